@@ -0,0 +1,462 @@
+#include "AsyncFileReader.hpp"
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include "Trace.hpp"
+
+#ifdef __linux__
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct AsyncFileReader::Request
+{
+    AsyncFileReader* owner = nullptr;
+    std::promise<Result> promise;
+    Result result;
+    std::chrono::steady_clock::time_point start;
+#ifdef __linux__
+    // io_uring operation the request waits on
+    enum class EState { Open, Read, Close } state = EState::Open;
+    int fd = -1;
+    size_t offset = 0;
+    bool failed = false;
+#endif
+};
+
+class AsyncFileReader::Backend
+{
+public:
+    virtual ~Backend() = default;
+    virtual std::string_view name() const noexcept = 0;
+    // takes ownership, request is completed through finish() from any thread
+    virtual void submit(Request* request) = 0;
+protected:
+    static void finish(Request* request) { request->owner->completed(request); }
+};
+
+namespace
+{
+    using Request = AsyncFileReader::Request;
+
+    class ThreadPoolBackend final : public AsyncFileReader::Backend
+    {
+    public:
+        explicit ThreadPoolBackend(size_t threads)
+        {
+            m_threads.reserve(threads);
+            for (size_t i = 0; i < threads; ++i)
+            {
+                m_threads.emplace_back(&ThreadPoolBackend::worker, this);
+            }
+        }
+
+        ~ThreadPoolBackend() override
+        {
+            {
+                std::lock_guard lock{ m_mutex };
+                m_stop = true;
+            }
+            m_cv.notify_all();
+            for (auto& t : m_threads)
+            {
+                t.join();
+            }
+        }
+
+        std::string_view name() const noexcept override { return "threads"; }
+
+        void submit(Request* request) override
+        {
+            {
+                std::lock_guard lock{ m_mutex };
+                m_queue.push_back(request);
+            }
+            m_cv.notify_one();
+        }
+    private:
+        void worker()
+        {
+            for (;;)
+            {
+                Request* request = nullptr;
+                {
+                    std::unique_lock lock{ m_mutex };
+                    m_cv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+                    if (m_queue.empty())
+                    {
+                        return;
+                    }
+                    request = m_queue.front();
+                    m_queue.pop_front();
+                }
+                read_file(request->result);
+                finish(request);
+            }
+        }
+
+        static void read_file(AsyncFileReader::Result& result)
+        {
+            TraceScope trace{ "read_ahead" };
+            std::ifstream in{ result.file, std::ios::binary };
+            std::error_code ec;
+            const auto size = std::filesystem::file_size(result.file, ec);
+            if (in && !ec)
+            {
+                result.data.resize(size);
+                in.read(result.data.data(), size);
+                result.ok = static_cast<bool>(in);
+            }
+        }
+
+        std::deque<Request*> m_queue;
+        bool m_stop = false;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::vector<std::thread> m_threads;
+    };
+
+#ifdef __linux__
+    // Raw io_uring without liburing. Every request walks OPENAT -> READ (repeated
+    // on short reads) -> CLOSE with one operation queued at a time, the reaper
+    // thread advances the requests of each completion batch and submits their
+    // next operations with one io_uring_enter.
+    class UringBackend final : public AsyncFileReader::Backend
+    {
+    public:
+        UringBackend() = default;
+
+        ~UringBackend() override
+        {
+            if (m_reaper.joinable())
+            {
+                {
+                    // no requests are left in flight, a nop without request stops the reaper
+                    std::lock_guard lock{ m_sq_mutex };
+                    queue(nullptr);
+                    flush();
+                }
+                m_reaper.join();
+            }
+            if (m_sqes != MAP_FAILED)
+            {
+                munmap(m_sqes, m_sqes_size);
+            }
+            if (m_ring != MAP_FAILED)
+            {
+                munmap(m_ring, m_ring_size);
+            }
+            if (m_ring_fd >= 0)
+            {
+                close(m_ring_fd);
+            }
+        }
+
+        // false when the kernel has no usable io_uring (older than 5.6, seccomp, sysctl)
+        bool init(unsigned entries)
+        {
+            io_uring_params params{};
+            const long fd = syscall(__NR_io_uring_setup, entries, &params);
+            if (fd < 0)
+            {
+                spdlog::debug("io_uring is not available: {}", std::strerror(errno));
+                return false;
+            }
+            m_ring_fd = static_cast<int>(fd);
+            // RW_CUR_POS came with 5.6, the first kernel with OPENAT, READ and CLOSE
+            constexpr unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_RW_CUR_POS;
+            if ((params.features & required) != required)
+            {
+                spdlog::debug("io_uring is too old, features {:#x}", params.features);
+                return false;
+            }
+            m_ring_size = std::max<size_t>(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+            m_ring = mmap(nullptr, m_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd,
+                IORING_OFF_SQ_RING);
+            m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            m_sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd,
+                IORING_OFF_SQES);
+            if (m_ring == MAP_FAILED || m_sqes == MAP_FAILED)
+            {
+                spdlog::debug("io_uring rings could not be mapped: {}", std::strerror(errno));
+                return false;
+            }
+            auto* ring = static_cast<char*>(m_ring);
+            m_sq_tail = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+            m_sq_mask = *reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+            m_sq_array = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+            m_cq_head = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+            m_cq_tail = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+            m_cq_mask = *reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe*>(ring + params.cq_off.cqes);
+            m_entries = params.sq_entries;
+            m_reaper = std::thread{ &UringBackend::reap, this };
+            return true;
+        }
+
+        unsigned entries() const noexcept { return m_entries; }
+
+        std::string_view name() const noexcept override { return "io_uring"; }
+
+        void submit(Request* request) override
+        {
+            std::lock_guard lock{ m_sq_mutex };
+            queue(request);
+            flush();
+        }
+    private:
+        // caller holds m_sq_mutex, requests in flight never exceed the ring size
+        // and each has a single operation queued so the ring can't overflow
+        void queue(Request* request)
+        {
+            const unsigned tail = *m_sq_tail;
+            const unsigned index = tail & m_sq_mask;
+            auto& sqe = static_cast<io_uring_sqe*>(m_sqes)[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.user_data = reinterpret_cast<uintptr_t>(request);
+            if (!request)
+            {
+                sqe.opcode = IORING_OP_NOP;
+            }
+            else if (request->state == Request::EState::Open)
+            {
+                sqe.opcode = IORING_OP_OPENAT;
+                sqe.fd = AT_FDCWD;
+                sqe.addr = reinterpret_cast<uintptr_t>(request->result.file.c_str());
+                sqe.open_flags = O_RDONLY | O_CLOEXEC;
+            }
+            else if (request->state == Request::EState::Read)
+            {
+                // len is 32 bit, huge files take several reads
+                constexpr size_t max_read = size_t{ 1 } << 30;
+                sqe.opcode = IORING_OP_READ;
+                sqe.fd = request->fd;
+                sqe.addr = reinterpret_cast<uintptr_t>(request->result.data.data() + request->offset);
+                sqe.len = static_cast<uint32_t>(std::min(request->result.data.size() - request->offset, max_read));
+                sqe.off = request->offset;
+            }
+            else
+            {
+                sqe.opcode = IORING_OP_CLOSE;
+                sqe.fd = request->fd;
+            }
+            m_sq_array[index] = index;
+            std::atomic_ref{ *m_sq_tail }.store(tail + 1, std::memory_order_release);
+            ++m_sq_pending;
+        }
+
+        // caller holds m_sq_mutex
+        void flush()
+        {
+            while (m_sq_pending != 0)
+            {
+                const long submitted = syscall(__NR_io_uring_enter, m_ring_fd, m_sq_pending, 0, 0, nullptr, 0);
+                if (submitted < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (submitted <= 0)
+                {
+                    spdlog::error("io_uring submission failed: {}", std::strerror(errno));
+                    return;
+                }
+                m_sq_pending -= static_cast<unsigned>(submitted);
+            }
+        }
+
+        void reap()
+        {
+            std::vector<Request*> next;
+            bool stop = false;
+            while (!stop)
+            {
+                const long ret = syscall(__NR_io_uring_enter, m_ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (ret < 0 && errno != EINTR)
+                {
+                    spdlog::error("io_uring wait failed: {}", std::strerror(errno));
+                    continue;
+                }
+                // only this thread moves the completion head
+                unsigned head = *m_cq_head;
+                const unsigned tail = std::atomic_ref{ *m_cq_tail }.load(std::memory_order_acquire);
+                for (; head != tail; ++head)
+                {
+                    const auto& cqe = m_cqes[head & m_cq_mask];
+                    auto* request = reinterpret_cast<Request*>(cqe.user_data);
+                    if (!request)
+                    {
+                        stop = true;
+                    }
+                    else if (advance(request, cqe.res))
+                    {
+                        next.push_back(request);
+                    }
+                }
+                std::atomic_ref{ *m_cq_head }.store(head, std::memory_order_release);
+                if (!next.empty())
+                {
+                    std::lock_guard lock{ m_sq_mutex };
+                    for (auto* request : next)
+                    {
+                        queue(request);
+                    }
+                    flush();
+                    next.clear();
+                }
+            }
+        }
+
+        // moves request past a completed operation, true when it has another one to queue
+        bool advance(Request* request, int res)
+        {
+            auto fail = [request](const char* operation, int error)
+            {
+                spdlog::debug("io_uring {} of '{}' failed: {}", operation, request->result.file.string(),
+                    std::strerror(error));
+                request->failed = true;
+                request->state = Request::EState::Close;
+            };
+            switch (request->state)
+            {
+            case Request::EState::Open:
+            {
+                if (res < 0)
+                {
+                    spdlog::debug("io_uring open of '{}' failed: {}", request->result.file.string(), std::strerror(-res));
+                    finish(request);
+                    return false;
+                }
+                request->fd = res;
+                struct stat st;
+                if (fstat(request->fd, &st) != 0)
+                {
+                    fail("stat", errno);
+                    return true;
+                }
+                request->result.data.resize(static_cast<size_t>(st.st_size));
+                request->state = st.st_size != 0 ? Request::EState::Read : Request::EState::Close;
+                return true;
+            }
+            case Request::EState::Read:
+                if (res == -EINTR || res == -EAGAIN)
+                {
+                    return true;
+                }
+                if (res < 0)
+                {
+                    fail("read", -res);
+                    return true;
+                }
+                if (res == 0)
+                {
+                    // file shrank since it was opened
+                    request->result.data.resize(request->offset);
+                }
+                request->offset += static_cast<size_t>(res);
+                if (request->offset == request->result.data.size())
+                {
+                    request->state = Request::EState::Close;
+                }
+                return true;
+            case Request::EState::Close:
+                request->result.ok = !request->failed;
+                finish(request);
+                return false;
+            }
+            return false;
+        }
+
+        int m_ring_fd = -1;
+        void* m_ring = MAP_FAILED;
+        size_t m_ring_size = 0;
+        void* m_sqes = MAP_FAILED;
+        size_t m_sqes_size = 0;
+        unsigned m_entries = 0;
+        unsigned* m_sq_tail = nullptr;
+        unsigned m_sq_mask = 0;
+        unsigned* m_sq_array = nullptr;
+        unsigned m_sq_pending = 0;
+        unsigned* m_cq_head = nullptr;
+        unsigned* m_cq_tail = nullptr;
+        unsigned m_cq_mask = 0;
+        io_uring_cqe* m_cqes = nullptr;
+        std::mutex m_sq_mutex;
+        std::thread m_reaper;
+    };
+#endif
+}
+
+AsyncFileReader::AsyncFileReader(size_t depth, size_t threads)
+    : m_depth{ std::max<size_t>(depth, 1) }
+{
+#ifdef __linux__
+    auto uring = std::make_unique<UringBackend>();
+    if (uring->init(static_cast<unsigned>(std::min<size_t>(m_depth, 4096))))
+    {
+        m_depth = std::min<size_t>(m_depth, uring->entries());
+        m_backend = std::move(uring);
+    }
+#endif
+    if (!m_backend)
+    {
+        m_backend = std::make_unique<ThreadPoolBackend>(std::clamp<size_t>(threads, 1, m_depth));
+    }
+    spdlog::debug("Reading files through {}, {} in flight", backend(), m_depth);
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+    {
+        std::unique_lock lock{ m_mutex };
+        m_cv.wait(lock, [this] { return m_in_flight == 0; });
+    }
+    m_backend.reset();
+}
+
+std::future<AsyncFileReader::Result> AsyncFileReader::read(std::filesystem::path file)
+{
+    auto request = std::make_unique<Request>();
+    request->owner = this;
+    request->result.file = std::move(file);
+    auto future = request->promise.get_future();
+    {
+        std::unique_lock lock{ m_mutex };
+        m_cv.wait(lock, [this] { return m_in_flight < m_depth; });
+        ++m_in_flight;
+    }
+    request->start = std::chrono::steady_clock::now();
+    m_backend->submit(request.release());
+    return future;
+}
+
+std::string_view AsyncFileReader::backend() const noexcept
+{
+    return m_backend->name();
+}
+
+void AsyncFileReader::completed(Request* request)
+{
+    std::unique_ptr<Request> owned{ request };
+    owned->result.read_time = std::chrono::steady_clock::now() - owned->start;
+    if (!owned->result.ok)
+    {
+        spdlog::warn("Could not read file '{}'", owned->result.file.string());
+    }
+    owned->promise.set_value(std::move(owned->result));
+    owned.reset();
+    // notified under the lock, the destructor may run as soon as the count drops
+    std::lock_guard lock{ m_mutex };
+    --m_in_flight;
+    m_cv.notify_all();
+}
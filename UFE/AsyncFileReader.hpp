@@ -0,0 +1,47 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Reads whole files without blocking the caller. On Linux open, read and close
+// are submitted to io_uring and completed by one reaper thread, elsewhere or
+// when the kernel refuses io_uring blocking reads run on a thread pool.
+// At most depth reads are in flight, read() blocks until a slot is free.
+class AsyncFileReader
+{
+public:
+    struct Result
+    {
+        std::filesystem::path file;
+        std::string data;
+        bool ok = false;
+        // from submission to completion
+        std::chrono::nanoseconds read_time{};
+    };
+
+    AsyncFileReader(size_t depth, size_t threads);
+    // waits for reads in flight
+    ~AsyncFileReader();
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    std::future<Result> read(std::filesystem::path file);
+    // "io_uring" or "threads"
+    std::string_view backend() const noexcept;
+
+    struct Request;
+    class Backend;
+private:
+    void completed(Request* request);
+
+    size_t m_depth;
+    size_t m_in_flight = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::unique_ptr<Backend> m_backend;
+};
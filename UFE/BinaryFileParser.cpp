@@ -1,61 +1,68 @@
 #include "BinaryFileParser.hpp"
-#include <gzip\config.hpp>
-#include <gzip\decompress.hpp>
-#include <gzip\utils.hpp>
-#include <gzip\version.hpp>
+#include <gzip/config.hpp>
+#include <gzip/decompress.hpp>
+#include <gzip/utils.hpp>
+#include <gzip/version.hpp>
 #include <zlib.h>
 #include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+    constexpr size_t stream_chunk_size = 64 * 1024;
+    // deflate can't expand data more than 1032 times
+    constexpr uint64_t max_deflate_ratio = 1032;
+}
+
+// file and inflate state of open_stream
+struct BinaryFileParser::StreamSource
+{
+    std::ifstream in;
+    bool compressed = false;
+    z_stream zs{};
+    int zret = Z_OK;
+    std::string in_chunk;
+    std::string out_chunk;
+
+    ~StreamSource()
+    {
+        if (compressed)
+        {
+            inflateEnd(&zs);
+        }
+    }
+};
+
+BinaryFileParser::BinaryFileParser() = default;
+BinaryFileParser::~BinaryFileParser() = default;
 
 bool BinaryFileParser::open(fs::path file_path)
 {
+    TraceScope trace{ "open" };
     if (fs::exists(file_path))
     {
         if (fs::is_regular_file(file_path))
         {
 	        spdlog::info("Reading file: {} ", file_path.string());
             std::ifstream in_file;
-	        in_file.open(file_path, std::ios::binary | std::ios::in | std::ios::out);
-	        if (m_file && fs::file_size(file_path) > (GZIP_START_OFF + 4))
+	        in_file.open(file_path, std::ios::binary | std::ios::in);
+            const auto file_size = fs::file_size(file_path);
+	        if (in_file && file_size > (GZIP_START_OFF + 4))
 	        {
-                m_raw_data.resize(GZIP_START_OFF + 4);
-                in_file.read(m_raw_data.data(), m_raw_data.size());
-                in_file.seekg(0);
-                // file is compressed
-                if (static_cast<uint8_t>(m_raw_data[GZIP_START_OFF]) == GZIP_MAGIC_1 &&
-                    static_cast<uint8_t>(m_raw_data[GZIP_START_OFF + 1]) == GZIP_MAGIC_2)
-                {
-                    m_header.resize(GZIP_START_OFF);
-                    in_file.read(m_header.data(), m_header.size());
-                    m_raw_data.resize(fs::file_size(file_path) - GZIP_START_OFF);
-                    in_file.read(m_raw_data.data(), m_raw_data.size());
-                    try
-                    {
-                        m_raw_data = gzip::decompress(m_raw_data.data(), m_raw_data.size());
-                        m_file.str(m_raw_data);
-                        m_file_type = EFileType::Compressed;
-                    }
-                    catch (std::exception& e)
-                    {
-                        spdlog::critical("Failed to decompress file: {}", e.what());
-                    }
-                }
-                else if (*reinterpret_cast<uint32_t*>(&m_raw_data[GZIP_START_OFF]) == 0x00000100)
-                {
-                    // uncompressed file
-                    m_header.resize(GZIP_START_OFF);
-                    in_file.read(m_header.data(), m_header.size());
-                    m_raw_data.resize(fs::file_size(file_path) - GZIP_START_OFF);
-                    in_file.read(m_raw_data.data(), m_raw_data.size());
-                    m_file.str(m_raw_data);
-                    m_file_type = EFileType::Uncompressed;
-                }
-                else
+                StageTimer read_timer{ m_stats, EStage::Read };
+                std::string file_data;
+                file_data.resize(GZIP_START_OFF + 4);
+                in_file.read(file_data.data(), file_data.size());
+                if (!is_supported(file_data))
                 {
                     // TODO: handle other file types
                     return false;
                 }
-                m_file_path = file_path;
-	            return true;
+                file_data.resize(file_size);
+                in_file.read(file_data.data() + GZIP_START_OFF + 4, file_size - GZIP_START_OFF - 4);
+                read_timer.stop();
+                return load(file_path, std::move(file_data));
 	        }
 	        spdlog::error("Could not open file for reading");
         }
@@ -67,70 +74,421 @@ bool BinaryFileParser::open(fs::path file_path)
     return false;
 }
 
-const std::any& BinaryFileParser::get_record(int32_t id)
+bool BinaryFileParser::open_stream(fs::path file_path)
+{
+    TraceScope trace{ "open_stream" };
+    spdlog::info("Reading file: {} ", file_path.string());
+    auto source = std::make_unique<StreamSource>();
+    std::error_code ec;
+    const auto file_size = fs::file_size(file_path, ec);
+    source->in.open(file_path, std::ios::binary | std::ios::in);
+    if (ec || !source->in || file_size <= GZIP_START_OFF + 4)
+    {
+        spdlog::error("Could not open file for reading");
+        return false;
+    }
+    std::string head(GZIP_START_OFF + 4, '\0');
+    {
+        StageTimer read_timer{ m_stats, EStage::Read, false };
+        source->in.read(head.data(), head.size());
+    }
+    if (!source->in || !is_supported(head))
+    {
+        return false;
+    }
+    source->compressed = static_cast<uint8_t>(head[GZIP_START_OFF]) == GZIP_MAGIC_1 &&
+        static_cast<uint8_t>(head[GZIP_START_OFF + 1]) == GZIP_MAGIC_2;
+    size_t stream_size = file_size - GZIP_START_OFF;
+    if (source->compressed)
+    {
+        if (inflateInit2(&source->zs, 16 + MAX_WBITS) != Z_OK)
+        {
+            source->compressed = false;
+            spdlog::critical("Failed to initialize inflate");
+            return false;
+        }
+        // gzip trailer ends with the inflated size modulo 2^32
+        uint32_t isize = 0;
+        source->in.seekg(-4, std::ios::end);
+        source->in.read(reinterpret_cast<char*>(&isize), sizeof(isize));
+        stream_size = stream_size_hint(file_size - GZIP_START_OFF, isize);
+        if (m_stream_limit && stream_size > m_stream_limit)
+        {
+            spdlog::warn("File '{}' announces a {} bytes stream, only {} bytes reserved", file_path.string(), stream_size, m_stream_limit);
+            stream_size = m_stream_limit;
+        }
+        source->out_chunk.resize(stream_chunk_size);
+    }
+    source->in.clear();
+    source->in.seekg(GZIP_START_OFF);
+    source->in_chunk.resize(stream_chunk_size);
+    head.resize(GZIP_START_OFF);
+    begin_stream(file_path, std::move(head), source->compressed ? EFileType::Compressed : EFileType::Uncompressed, stream_size);
+    if (m_stats)
+    {
+        m_stats->bytes_in = file_size;
+    }
+    m_source = std::move(source);
+    return true;
+}
+
+bool BinaryFileParser::pull_stream()
+{
+    if (!m_source || !m_source->in)
+    {
+        return false;
+    }
+    auto& src = *m_source;
+    {
+        StageTimer read_timer{ m_stats, EStage::Read, false };
+        src.in.read(src.in_chunk.data(), src.in_chunk.size());
+    }
+    const auto size = static_cast<size_t>(src.in.gcount());
+    if (size == 0)
+    {
+        return false;
+    }
+    if (!src.compressed)
+    {
+        return append_data(src.in_chunk.data(), size);
+    }
+    if (src.zret == Z_STREAM_END)
+    {
+        return false;
+    }
+    StageTimer inflate_timer{ m_stats, EStage::Inflate, false };
+    src.zs.next_in = reinterpret_cast<Bytef*>(src.in_chunk.data());
+    src.zs.avail_in = static_cast<uInt>(size);
+    do
+    {
+        src.zs.next_out = reinterpret_cast<Bytef*>(src.out_chunk.data());
+        src.zs.avail_out = static_cast<uInt>(src.out_chunk.size());
+        src.zret = inflate(&src.zs, Z_NO_FLUSH);
+        if (src.zret != Z_OK && src.zret != Z_STREAM_END && src.zret != Z_BUF_ERROR)
+        {
+            spdlog::critical("Failed to decompress file: {}", src.zs.msg ? src.zs.msg : "inflate error");
+            return false;
+        }
+        if (!append_data(src.out_chunk.data(), src.out_chunk.size() - src.zs.avail_out))
+        {
+            return false;
+        }
+    } while (src.zs.avail_out == 0 && src.zret == Z_OK);
+    return true;
+}
+
+bool BinaryFileParser::is_supported(const std::string& file_data)
+{
+    if (file_data.size() < GZIP_START_OFF + 4)
+    {
+        return false;
+    }
+    // compressed file
+    if (static_cast<uint8_t>(file_data[GZIP_START_OFF]) == GZIP_MAGIC_1 &&
+        static_cast<uint8_t>(file_data[GZIP_START_OFF + 1]) == GZIP_MAGIC_2)
+    {
+        return true;
+    }
+    // uncompressed file, SerializedStreamHeader record with root id 1
+    return *reinterpret_cast<const uint32_t*>(&file_data[GZIP_START_OFF]) == 0x00000100;
+}
+
+bool BinaryFileParser::load(fs::path file_path, std::string&& file_data)
 {
-    static std::any dummy;
-    for (const auto& rec : m_records)
+    if (!is_supported(file_data))
+    {
+        return false;
+    }
+    const auto file_size = file_data.size();
+    m_header.assign(file_data, 0, GZIP_START_OFF);
+    if (static_cast<uint8_t>(file_data[GZIP_START_OFF]) == GZIP_MAGIC_1 &&
+        static_cast<uint8_t>(file_data[GZIP_START_OFF + 1]) == GZIP_MAGIC_2)
     {
-        if (rec.first == id)
+        try
         {
-            return rec.second;
+            StageTimer inflate_timer{ m_stats, EStage::Inflate };
+            m_raw_data = gzip::decompress(file_data.data() + GZIP_START_OFF, file_data.size() - GZIP_START_OFF);
+            m_buffer.set(m_raw_data);
+            m_file.clear();
+            m_file_type = EFileType::Compressed;
         }
+        catch (std::exception& e)
+        {
+            spdlog::critical("Failed to decompress file: {}", e.what());
+        }
+    }
+    else
+    {
+        file_data.erase(0, GZIP_START_OFF);
+        m_raw_data = std::move(file_data);
+        m_buffer.set(m_raw_data);
+        m_file.clear();
+        m_file_type = EFileType::Uncompressed;
+    }
+    m_file_path = file_path;
+    if (m_stats)
+    {
+        m_stats->file = file_path;
+        m_stats->bytes_in = file_size;
+        m_stats->bytes_inflated = m_raw_data.size();
     }
-    return dummy;
+    return true;
+}
+
+const ufe::ClassWithMembersAndTypes* BinaryFileParser::get_class_metadata(int32_t id) const
+{
+    const auto it = m_class_metadata.find(id);
+    return it != m_class_metadata.cend() ? &it->second : nullptr;
+}
+
+std::streambuf::pos_type BinaryFileParser::BufferView::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    off_type base = 0;
+    if (dir == std::ios_base::cur)
+    {
+        base = gptr() - eback();
+    }
+    else if (dir == std::ios_base::end)
+    {
+        base = egptr() - eback();
+    }
+    const auto pos = base + off;
+    if (!(which & std::ios_base::in) || pos < 0 || pos > egptr() - eback())
+    {
+        return pos_type(off_type(-1));
+    }
+    setg(eback(), eback() + pos, egptr());
+    return pos_type(pos);
 }
 
 
 bool BinaryFileParser::check_header()
 {
-    bool ret = true;
-    auto curr_off = m_file.tellg();
-    m_file.seekg(0);
-    ufe::ERecordType rec = get_record_type();
     // default is partially parsed file if at least header is ok
     m_status = EFileStatus::PartialRead;
-    if (rec == ufe::ERecordType::SerializedStreamHeader)
+    if (!is_stream_header(m_raw_data))
+    {
+        spdlog::debug("Header doesn't match, abort reading file");
+        m_status = EFileStatus::Invalid;
+        return false;
+    }
+    return true;
+}
+
+uint64_t BinaryFileParser::stream_size_hint(uint64_t gzip_size, uint32_t isize)
+{
+    // a stream of 4 GB or more wraps around, a crafted trailer can claim anything
+    return std::clamp<uint64_t>(isize, gzip_size, gzip_size * max_deflate_ratio);
+}
+
+bool BinaryFileParser::is_stream_header(std::string_view stream)
+{
+    if (stream.size() < STREAM_HEADER_SIZE ||
+        static_cast<ufe::ERecordType>(stream[0]) != ufe::ERecordType::SerializedStreamHeader)
     {
-        ufe::SerializationHeaderRecord header;
-        read(header);
-        if (header.RootId.value != 1 ||
-            header.HeaderId.value != -1 ||
-            header.MajorVersion.value != 1 ||
-            header.MinorVersion.value != 0)
+        return false;
+    }
+    // root id, header id, major and minor version
+    std::array<int32_t, 4> fields;
+    std::memcpy(fields.data(), stream.data() + 1, sizeof(fields));
+    return fields[0] == 1 && fields[1] == -1 && fields[2] == 1 && fields[3] == 0;
+}
+
+void BinaryFileParser::read_records()
+{
+    read_records({}, true);
+}
+
+void BinaryFileParser::read_records(const RecordConsumer& consumer, bool keep_records /* = false */)
+{
+    TraceScope trace{ "read_records" };
+    auto result = parse(consumer, keep_records);
+    while (result == EParseResult::NeedData && pull_stream())
+    {
+        result = parse(consumer, keep_records);
+    }
+    m_source.reset();
+    if (result == EParseResult::NeedData)
+    {
+        // whole stream is loaded, nothing more will arrive
+        if (!m_header_checked)
         {
-            spdlog::debug("Header doesn't match, abort reading file");
             m_status = EFileStatus::Invalid;
-            ret = false;
         }
+        else if (m_status != EFileStatus::Invalid)
+        {
+            spdlog::warn("Stream is truncated, unfinished record at offset {}", static_cast<uint64_t>(m_file.tellg()));
+        }
+        finish();
     }
-    else
+}
+
+void BinaryFileParser::begin_stream(fs::path file_path, std::string header, EFileType file_type, size_t stream_size)
+{
+    m_file_path = file_path;
+    m_header = std::move(header);
+    m_file_type = file_type;
+    m_raw_data.clear();
+    // records view into the buffer, appending must never reallocate it
+    m_raw_data.reserve(stream_size);
+    m_buffer.set(m_raw_data);
+    m_file.clear();
+    if (m_stats)
+    {
+        m_stats->file = file_path;
+        m_stats->bytes_inflated = stream_size;
+    }
+}
+
+bool BinaryFileParser::append_data(const char* data, size_t size)
+{
+    if (m_raw_data.size() + size > m_raw_data.capacity())
     {
-        spdlog::debug("Header record type invalid, abort reading file");
+        // records view into the buffer, it can't be moved to grow
+        spdlog::error("File '{}' stream is larger than the {} bytes reserved for it, run without --mem_limit to load it whole", m_file_path.string(),
+            m_raw_data.capacity());
         m_status = EFileStatus::Invalid;
-        ret = false;
+        return false;
     }
-    m_file.seekg(curr_off);
-    return ret;
+    m_raw_data.append(data, size);
+    m_buffer.extend(m_raw_data);
+    return true;
 }
 
-void BinaryFileParser::read_records()
+BinaryFileParser::EParseResult BinaryFileParser::parse(const RecordConsumer& consumer, bool keep_records /* = false */)
 {
-    if (check_header()) // skip parsing file if it has invalid header
+    if (m_finished)
     {
-	    for (std::any a = read_record(); a.has_value(); a = read_record())
-	    {
-            m_root_records.emplace_back(a);
-	    }
+        return EParseResult::Done;
     }
-    else
+    if (!m_header_checked)
     {
-        m_status = EFileStatus::Invalid;
+        if (m_raw_data.size() < STREAM_HEADER_SIZE)
+        {
+            return EParseResult::NeedData;
+        }
+        m_header_checked = true;
+        if (!check_header()) // skip parsing file if it has invalid header
+        {
+            m_status = EFileStatus::Invalid;
+            finish();
+            return EParseResult::Done;
+        }
+    }
+    for (;;)
+    {
+        std::any a;
+        EStep step;
+        {
+            // consumer time goes to its own stages
+            StageTimer timer{ m_stats, EStage::Parse, false };
+            step = read_next_record(a);
+        }
+        if (step == EStep::NeedData)
+        {
+            return EParseResult::NeedData;
+        }
+        if (!a.has_value())
+        {
+            break;
+        }
+        if (consumer)
+        {
+            consumer(a);
+        }
+        if (keep_records)
+        {
+            m_root_records.emplace_back(std::move(a));
+        }
+    }
+    finish();
+    return EParseResult::Done;
+}
+
+void BinaryFileParser::finish()
+{
+    if (m_finished)
+    {
+        return;
+    }
+    m_finished = true;
+    m_stack.clear();
+    if (m_stats)
+    {
+        m_stats->records += m_records_count;
+        m_stats->members += m_members_count;
+        m_stats->bytes_skipped += m_bytes_skipped;
+    }
+}
+
+BinaryFileParser::EStep BinaryFileParser::read_next_record(std::any& record)
+{
+    // roots are searched for selected classes when projecting
+    const Target root_target{ m_projection ? EMode::Search : EMode::Keep, { true, {} } };
+    for (;;)
+    {
+        // completed containers become values of their parents
+        if (!m_stack.empty() && m_stack.back().index >= m_stack.back().count)
+        {
+            const bool emit = m_stack.back().emit;
+            auto value = pop_frame();
+            if (emit)
+            {
+                if (!m_stack.empty())
+                {
+                    attach(m_stack.back(), ufe::SkippedValue{});
+                }
+                record = std::move(value);
+                return EStep::Value;
+            }
+            if (!m_stack.empty())
+            {
+                attach(m_stack.back(), std::move(value));
+            }
+            else if (value.type() != std::type_index(typeid(ufe::SkippedValue)))
+            {
+                record = std::move(value);
+                return EStep::Value;
+            }
+            continue;
+        }
+
+        std::any value;
+        const auto step = m_stack.empty() ? read_record(value, root_target) : read_element(m_stack.back(), value);
+        if (step == EStep::NeedData)
+        {
+            return step;
+        }
+        if (m_status == EFileStatus::Invalid)
+        {
+            // the stream can't be followed any further, parsing ends like at MessageEnd
+            m_stack.clear();
+            record.reset();
+            return EStep::Value;
+        }
+        if (step == EStep::Value)
+        {
+            if (!m_stack.empty())
+            {
+                attach(m_stack.back(), std::move(value));
+            }
+            else if (value.type() != std::type_index(typeid(ufe::SkippedValue)))
+            {
+                record = std::move(value);
+                return EStep::Value;
+            }
+        }
     }
 }
 
-std::any BinaryFileParser::read_record()
+BinaryFileParser::EStep BinaryFileParser::read_record(std::any& value, const Target& target)
 {
+    const auto start = static_cast<std::streamoff>(m_file.tellg());
     ufe::ERecordType rec = get_record_type();
+    if (!m_file)
+    {
+        return need_data(start);
+    }
     spdlog::debug("Parsing record type: {}", ufe::ERecordType2str(rec));
     auto record_type_not_implemented = [this](ufe::ERecordType rec)
         {
@@ -138,13 +496,17 @@ std::any BinaryFileParser::read_record()
             spdlog::debug("filepos: {}", static_cast<uint64_t>(m_file.tellg()));
         };
 
+    const bool keep = target.mode == EMode::Keep;
+    bool pushed = false;
     switch (rec)
     {
         case ufe::ERecordType::SerializedStreamHeader:
-            return get_SerializedStreamHeader();
+            value = get_SerializedStreamHeader();
+            break;
 
         case ufe::ERecordType::ClassWithId:
-            return get_ClassWithId();
+            pushed = push_ClassWithId(value, target);
+            break;
 
         case ufe::ERecordType::SystemClassWithMembers:
             record_type_not_implemented(rec);
@@ -155,26 +517,41 @@ std::any BinaryFileParser::read_record()
             break;
 
         case ufe::ERecordType::SystemClassWithMembersAndTypes:
-            return get_SystemClassWithMembersAndTypes();
+            pushed = push_ClassWithMembersAndTypes(true, target);
+            break;
 
         case ufe::ERecordType::ClassWithMembersAndTypes:
-            return get_ClassWithMembersAndTypes();
+            pushed = push_ClassWithMembersAndTypes(false, target);
+            break;
 
         case ufe::ERecordType::BinaryObjectString:
-            return get_BinaryObjectString();
+            if (keep)
+            {
+                value = get_BinaryObjectString();
+            }
+            else
+            {
+                read<int32_t>();
+                skip_string();
+                value = ufe::SkippedValue{};
+            }
+            break;
 
         case ufe::ERecordType::BinaryArray:
-            return get_BinaryArray();
+            pushed = push_BinaryArray(target);
+            break;
 
         case ufe::ERecordType::MemberPrimitiveTyped:
             record_type_not_implemented(rec);
             break;
 
         case ufe::ERecordType::MemberReference:
-            return get_MemberReference();
+            value = get_MemberReference();
+            break;
 
         case ufe::ERecordType::ObjectNull:
-            return std::any{ufe::ObjectNull{}};
+            value = ufe::ObjectNull{};
+            break;
 
         case ufe::ERecordType::MessageEnd:
         {
@@ -183,23 +560,35 @@ std::any BinaryFileParser::read_record()
         } break;
 
         case ufe::ERecordType::BinaryLibrary:
-            return get_BinaryLibrary();
+            value = get_BinaryLibrary();
+            break;
 
         case ufe::ERecordType::ObjectNullMultiple256:
-            return get_ObjectNullMultiple256();
+            value = get_ObjectNullMultiple256();
+            break;
 
         case ufe::ERecordType::ObjectNullMultiple:
             record_type_not_implemented(rec);
             break;
 
         case ufe::ERecordType::ArraySinglePrimitive:
-            return get_ArraySinglePrimitive();
+            if (keep)
+            {
+                value = get_ArraySinglePrimitive();
+            }
+            else
+            {
+                skip_ArraySinglePrimitive();
+                value = ufe::SkippedValue{};
+            }
+            break;
 
         case ufe::ERecordType::ArraySingleObject:
             record_type_not_implemented(rec);
             break;
         case ufe::ERecordType::ArraySingleString:
-            return get_ArraySingleString();
+            pushed = push_ArraySingleString(target);
+            break;
 
         case ufe::ERecordType::MethodCall:   [[fallthrough]];
         case ufe::ERecordType::MethodReturn: [[fallthrough]];
@@ -208,43 +597,252 @@ std::any BinaryFileParser::read_record()
             record_type_not_implemented(rec);
             break;
     }
-    return {};
+    if (!m_file)
+    {
+        value.reset();
+        return need_data(start);
+    }
+    ++m_records_count;
+    if (!keep && value.has_value() && value.type() != std::type_index(typeid(ufe::ObjectNullMultiple256)))
+    {
+        // packed nulls still count array elements of dropped arrays
+        value = ufe::SkippedValue{};
+    }
+    return pushed ? EStep::Continue : EStep::Value;
 }
 
-std::any BinaryFileParser::get_ArraySingleString()
+BinaryFileParser::EStep BinaryFileParser::read_element(Frame& frame, std::any& value)
 {
-    ufe::ArraySingleString arr;
-    read(arr);
-    spdlog::debug("array_single_string  id {}, elements count {}", arr.ObjectId, arr.Length);
-    for (int i = 0; i < arr.Length; ++i)
+    // read_record may push a frame, frame must not be used after it
+    return std::visit([this, &frame, &value](auto& record)
+        {
+            using T = std::decay_t<decltype(record)>;
+            if constexpr (std::is_same_v<T, ufe::ClassWithMembersAndTypes> || std::is_same_v<T, ufe::ClassWithId>)
+            {
+                const auto& mti = record.m_MemberTypeInfo;
+                const auto member_name = record.m_ClassInfo.MemberNames[frame.index].value.string;
+                const auto target = element_target(frame, member_name);
+                if (mti.BinaryTypeEnums[frame.index] == ufe::EBinaryTypeEnumeration::Primitive)
+                {
+                    const auto start = static_cast<std::streamoff>(m_file.tellg());
+                    const auto type = std::get<ufe::EPrimitiveTypeEnumeration>(mti.AdditionalInfos[frame.add_info]);
+                    if (target.mode == EMode::Keep)
+                    {
+                        value = read_member_primitive(type, member_name);
+                    }
+                    else
+                    {
+                        const auto size = ufe::primitive_size(type);
+                        if (!size)
+                        {
+                            return unsized_primitive(type);
+                        }
+                        skip(size);
+                        value = ufe::SkippedValue{};
+                    }
+                    return m_file ? EStep::Value : need_data(start);
+                }
+                return read_record(value, target);
+            }
+            else if constexpr (std::is_same_v<T, ufe::BinaryArray>)
+            {
+                switch (record.TypeEnum)
+                {
+                    case ufe::EBinaryTypeEnumeration::Primitive:
+                    {
+                        const auto start = static_cast<std::streamoff>(m_file.tellg());
+                        const auto type = std::get<ufe::EPrimitiveTypeEnumeration>(record.AdditionalTypeInfo);
+                        if (frame.target.mode != EMode::Keep)
+                        {
+                            const auto size = ufe::primitive_size(type);
+                            if (!size)
+                            {
+                                return unsized_primitive(type);
+                            }
+                            // remaining elements at once
+                            if (!skip(static_cast<std::streamoff>(size) * (frame.count - frame.index)))
+                            {
+                                return need_data(start);
+                            }
+                            frame.index = frame.count;
+                            return EStep::Continue;
+                        }
+                        value = read_primitive_element(type);
+                        return m_file ? EStep::Value : need_data(start);
+                    }
+                    case ufe::EBinaryTypeEnumeration::Class:
+                        return read_record(value, frame.target);
+                    default:
+                        // elements of other types are not stored in the stream by this reader
+                        frame.index = frame.count;
+                        return EStep::Continue;
+                }
+            }
+            else
+            {
+                return read_record(value, frame.target);
+            }
+        }, frame.record);
+}
+
+BinaryFileParser::Target BinaryFileParser::element_target(const Frame& frame, std::string_view member_name)
+{
+    if (frame.target.mode != EMode::Keep || frame.target.scope.all)
     {
-        auto record = read_record();
-        if (record.type() == std::type_index(typeid(ufe::ObjectNullMultiple256)))
+        return frame.target;
+    }
+    auto scope = m_projection->select_member(frame.target.scope, member_name);
+    if (!scope.selected())
+    {
+        return { EMode::Skip, {} };
+    }
+    return { EMode::Keep, std::move(scope) };
+}
+
+void BinaryFileParser::attach(Frame& frame, std::any&& value)
+{
+    const bool keep = frame.target.mode == EMode::Keep;
+    std::visit([&frame, &value, keep](auto& record)
         {
-            // increase elements count if is a packed null object
-            const auto obj = std::any_cast<ufe::ObjectNullMultiple256>(record);
-            i += obj.NullCount;
-        }
-        arr.Data.push_back(record);
+            using T = std::decay_t<decltype(record)>;
+            if constexpr (std::is_same_v<T, ufe::ClassWithMembersAndTypes> || std::is_same_v<T, ufe::ClassWithId>)
+            {
+                auto& mti = record.m_MemberTypeInfo;
+                switch (mti.BinaryTypeEnums[frame.index])
+                {
+                    // member types with an entry in AdditionalInfos
+                    case ufe::EBinaryTypeEnumeration::Primitive:
+                    case ufe::EBinaryTypeEnumeration::SystemClass:
+                    case ufe::EBinaryTypeEnumeration::Class:
+                    case ufe::EBinaryTypeEnumeration::PrimitiveArray:
+                        ++frame.add_info;
+                        break;
+                    default:
+                        break;
+                }
+                if (keep)
+                {
+                    mti.Data.push_back(std::move(value));
+                }
+                ++frame.index;
+            }
+            else
+            {
+                // packed null object covers NullCount elements including current one
+                int32_t covered = 1;
+                if (value.type() == std::type_index(typeid(ufe::ObjectNullMultiple256)))
+                {
+                    covered = std::max<int32_t>(1, std::any_cast<const ufe::ObjectNullMultiple256&>(value).NullCount);
+                }
+                if (keep)
+                {
+                    record.Data.emplace_back(std::move(value));
+                }
+                frame.index += covered;
+            }
+        }, frame.record);
+}
+
+void BinaryFileParser::push_frame(Frame&& frame)
+{
+    if (Tracer::enabled())
+    {
+        frame.start = std::chrono::steady_clock::now();
     }
-    return arr;
+    m_stack.push_back(std::move(frame));
+}
+
+std::any BinaryFileParser::pop_frame()
+{
+    auto frame = std::move(m_stack.back());
+    m_stack.pop_back();
+    if (frame.start != std::chrono::steady_clock::time_point{})
+    {
+        Tracer::add_span(frame.trace_name, frame.start, std::chrono::steady_clock::now());
+    }
+    const bool keep = frame.target.mode == EMode::Keep;
+    return std::visit([this, keep](auto& record)
+        {
+            using T = std::decay_t<decltype(record)>;
+            if constexpr (std::is_same_v<T, ufe::ClassWithMembersAndTypes> || std::is_same_v<T, ufe::ClassWithId>)
+            {
+                m_members_count += record.m_MemberTypeInfo.BinaryTypeEnums.size();
+            }
+            return keep ? std::any{ std::move(record) } : std::any{ ufe::SkippedValue{} };
+        }, frame.record);
+}
+
+BinaryFileParser::EStep BinaryFileParser::need_data(std::streamoff start)
+{
+    // step is repeated from its first byte once more data is available
+    m_file.clear();
+    m_file.seekg(start);
+    return EStep::NeedData;
+}
+
+bool BinaryFileParser::push_ArraySingleString(const Target& target)
+{
+    Frame frame;
+    frame.trace_name = "get_ArraySingleString";
+    auto& arr = frame.record.emplace<ufe::ArraySingleString>();
+    read(arr);
+    if (!m_file)
+    {
+        return false;
+    }
+    spdlog::debug("array_single_string  id {}, elements count {}", arr.ObjectId, arr.Length);
+    frame.count = arr.Length;
+    frame.target = target;
+    push_frame(std::move(frame));
+    return true;
 }
 
 std::any BinaryFileParser::get_ArraySinglePrimitive()
 {
+    TraceScope trace{ "get_ArraySinglePrimitive" };
     ufe::ArraySinglePrimitive arr;
     read(arr);
+    if (!m_file)
+    {
+        return arr;
+    }
+    if (arr.Length < 0)
+    {
+        spdlog::warn("Primitive array {} has invalid length {}", arr.ObjectId, arr.Length);
+        return {};
+    }
+    // length comes from the file, reserve no more elements than the rest of the stream can hold
+    if (const auto element_size = ufe::primitive_size(arr.PrimitiveTypeEnum))
+    {
+        const auto offset = std::min<uint64_t>(static_cast<uint64_t>(m_file.tellg()), m_raw_data.size());
+        arr.Data.reserve(std::min<uint64_t>(arr.Length, (m_raw_data.size() - offset) / element_size));
+    }
     for (int i = 0; i < arr.Length; ++i)
     {
-        nlohmann::ordered_json tmp;
-        auto x = arr.PrimitiveTypeEnum;
-        read_primitive_element(x);
+        arr.Data.emplace_back(read_primitive_element(arr.PrimitiveTypeEnum));
     }
     return arr;
 }
 
+void BinaryFileParser::skip_ArraySinglePrimitive()
+{
+    ufe::ArraySinglePrimitive arr;
+    read(arr);
+    if (m_file && arr.Length > 0)
+    {
+        const auto size = ufe::primitive_size(arr.PrimitiveTypeEnum);
+        if (!size)
+        {
+            unsized_primitive(arr.PrimitiveTypeEnum);
+            return;
+        }
+        skip(static_cast<std::streamoff>(size) * arr.Length);
+    }
+}
+
 std::any BinaryFileParser::get_ObjectNullMultiple256()
 {
+    TraceScope trace{ "get_ObjectNullMultiple256" };
     ufe::ObjectNullMultiple256 obj;
     obj.NullCount = read<uint8_t>();
     spdlog::debug("null_multiple_256 count: {}", obj.NullCount);
@@ -253,96 +851,128 @@ std::any BinaryFileParser::get_ObjectNullMultiple256()
 
 std::any BinaryFileParser::get_BinaryLibrary()
 {
+    TraceScope trace{ "get_BinaryLibrary" };
     ufe::BinaryLibrary bl;
     read(bl);
-    add_record(bl.LibraryId.value, std::any{ bl });
     return bl;
 }
 
 std::any BinaryFileParser::get_MemberReference()
 {
+    TraceScope trace{ "get_MemberReference" };
     ufe::MemberReference ref;
     read(ref);
     spdlog::debug("reference id: {}", ref.m_idRef);
     return ref;
 }
 
-std::any BinaryFileParser::get_BinaryArray()
+std::any BinaryFileParser::get_BinaryObjectString()
 {
-    ufe::BinaryArray ba;
-    read(ba);
-    if (ba.Rank > 1)
+    TraceScope trace{ "get_BinaryObjectString" };
+    ufe::BinaryObjectString bos;
+    read(bos);
+    spdlog::debug("object string id: {}, value: '{}'", bos.m_ObjectId, bos.m_Value.value.string);
+    return bos;
+}
+
+bool BinaryFileParser::push_ClassWithMembersAndTypes(bool system_class, const Target& target)
+{
+    Frame frame;
+    frame.trace_name = system_class ? "get_SystemClassWithMembersAndTypes" : "get_ClassWithMembersAndTypes";
+    auto& cmt = frame.record.emplace<ufe::ClassWithMembersAndTypes>();
+    read(cmt, system_class);
+    if (!m_file)
     {
-        spdlog::error("multidimensional array");
-        return {};
+        return false;
     }
-    spdlog::debug("binary array id {}, elements type '{}'", ba.ObjectId, ufe::EBinaryTypeEnumeration2str(ba.TypeEnum));
-    for (int i = 0; i < ba.Lengths[0]; ++i)
+    // registered before members are read so nested objects of the same class can reference it,
+    // dropped classes too since later ClassWithId records may be selected
+    add_class_metadata(cmt);
+    frame.count = static_cast<int32_t>(cmt.m_MemberTypeInfo.BinaryTypeEnums.size());
+    push_class(std::move(frame), cmt.m_ClassInfo, target);
+    return true;
+}
+
+void BinaryFileParser::push_class(Frame&& frame, const ufe::ClassInfo& ci, const Target& target)
+{
+    if (target.mode == EMode::Search)
     {
-        switch (ba.TypeEnum)
+        if (const auto& scope = class_scope(ci); scope.selected())
         {
-        case ufe::EBinaryTypeEnumeration::Primitive:
-            ba.Data.emplace_back(read_primitive_element(std::get<ufe::EPrimitiveTypeEnumeration>(ba.AdditionalTypeInfo)));
-            break;
-        case ufe::EBinaryTypeEnumeration::String:
-            break;
-        case ufe::EBinaryTypeEnumeration::Object:
-            break;
-        case ufe::EBinaryTypeEnumeration::SystemClass:
-            break;
-        case ufe::EBinaryTypeEnumeration::Class:
+            frame.target = { EMode::Keep, scope };
+            frame.emit = true;
+        }
+        else
         {
-            ba.Data.emplace_back(read_record());
-        } break;
-        case ufe::EBinaryTypeEnumeration::ObjectArray:
-            break;
-        case ufe::EBinaryTypeEnumeration::StringArray:
-            break;
-        case ufe::EBinaryTypeEnumeration::PrimitiveArray:
-            break;
-        case ufe::EBinaryTypeEnumeration::None:
-            break;
-        default:
-            break;
+            frame.target.mode = EMode::Search;
         }
     }
-    return ba;
-}
-
-std::any BinaryFileParser::get_BinaryObjectString()
-{
-    ufe::BinaryObjectString bos;
-    read(bos);
-    spdlog::debug("object string id: {}, value: '{}'", bos.m_ObjectId, bos.m_Value.value.string);
-    add_record(bos.m_ObjectId, std::any{ bos });
-    return bos;
+    else
+    {
+        frame.target = target;
+    }
+    // ci points into frame, not used past this point
+    push_frame(std::move(frame));
 }
 
-std::any BinaryFileParser::get_ClassWithMembersAndTypes()
+const Projection::Scope& BinaryFileParser::class_scope(const ufe::ClassInfo& ci)
 {
-    ufe::ClassWithMembersAndTypes cmt;
-    read(cmt);
-    add_record(cmt.m_ClassInfo.ObjectId.value, std::any{ cmt });
-    return cmt;
+    auto it = m_class_scopes.find(ci.NameId);
+    if (it == m_class_scopes.end())
+    {
+        auto scope = m_projection->select_class(StringInterner::str(ci.NameId));
+        // member paths select only classes that have a matching member
+        if (!scope.all && std::none_of(ci.MemberNames.cbegin(), ci.MemberNames.cend(),
+            [&](const auto& name) { return m_projection->select_member(scope, name.value.string).selected(); }))
+        {
+            scope.paths.clear();
+        }
+        it = m_class_scopes.emplace(ci.NameId, std::move(scope)).first;
+    }
+    return it->second;
 }
 
-std::any BinaryFileParser::get_SystemClassWithMembersAndTypes()
+bool BinaryFileParser::push_ClassWithId(std::any& value, const Target& target)
 {
-    ufe::ClassWithMembersAndTypes cmt;
-    read(cmt, true);
-    add_record(cmt.m_ClassInfo.ObjectId.value, std::any{ cmt });
-    return cmt;
+    Frame frame;
+    frame.trace_name = "get_ClassWithId";
+    auto& cwi = frame.record.emplace<ufe::ClassWithId>();
+    if (read(cwi) && m_file)
+    {
+        frame.count = static_cast<int32_t>(cwi.m_MemberTypeInfo.BinaryTypeEnums.size());
+        push_class(std::move(frame), cwi.m_ClassInfo, target);
+        return true;
+    }
+    // unknown metadata, record has no members
+    value = std::move(cwi);
+    return false;
 }
 
-std::any BinaryFileParser::get_ClassWithId()
+bool BinaryFileParser::push_BinaryArray(const Target& target)
 {
-    ufe::ClassWithId cwi;
-    read(cwi);
-    return cwi;
+    Frame frame;
+    frame.trace_name = "get_BinaryArray";
+    auto& ba = frame.record.emplace<ufe::BinaryArray>();
+    read(ba);
+    if (!m_file)
+    {
+        return false;
+    }
+    if (ba.Rank > 1)
+    {
+        spdlog::error("multidimensional array");
+        return false;
+    }
+    spdlog::debug("binary array id {}, elements type '{}'", ba.ObjectId, ufe::EBinaryTypeEnumeration2str(ba.TypeEnum));
+    frame.count = ba.Lengths.empty() ? 0 : ba.Lengths[0];
+    frame.target = target;
+    push_frame(std::move(frame));
+    return true;
 }
 
 std::any BinaryFileParser::get_SerializedStreamHeader()
 {
+    TraceScope trace{ "get_SerializedStreamHeader" };
     ufe::SerializationHeaderRecord rec;
     read(rec);
     return rec;
@@ -407,6 +1037,38 @@ std::any BinaryFileParser::read_primitive_element(ufe::EPrimitiveTypeEnumeration
     return {};
 }
 
+BinaryFileParser::EStep BinaryFileParser::unsized_primitive(ufe::EPrimitiveTypeEnumeration type)
+{
+    // skipping 0 bytes would read the value's bytes as the next record
+    spdlog::warn("{} primitive at offset {} has no fixed size and can't be skipped, file is invalid",
+        ufe::EPrimitiveTypeEnumeration2str(type), static_cast<uint64_t>(m_file.tellg()));
+    m_status = EFileStatus::Invalid;
+    return EStep::Continue;
+}
+
+bool BinaryFileParser::skip(std::streamoff size)
+{
+    m_file.seekg(size, std::ios::cur);
+    if (m_file)
+    {
+        m_bytes_skipped += size;
+    }
+    return static_cast<bool>(m_file);
+}
+
+bool BinaryFileParser::skip_string()
+{
+    // same length prefix as LengthPrefixedString, without building a view
+    uint32_t len = 0;
+    for (int i = 0; i < 5; ++i)
+    {
+        uint8_t seg = read();
+        len |= static_cast<uint32_t>(seg & 0x7F) << (7 * i);
+        if ((seg & 0x80) == 0x00) break;
+    }
+    return m_file && skip(len);
+}
+
 bool BinaryFileParser::read(ufe::BinaryLibrary& bl)
 {
     read(bl.LibraryId);
@@ -419,18 +1081,34 @@ bool BinaryFileParser::read(ufe::ClassInfo& ci)
     read(ci.ObjectId);
     read(ci.Name);
     read(ci.MemberCount);
+    if (!m_file)
+    {
+        return false;
+    }
     ci.MemberNames.resize(ci.MemberCount.value);
     std::for_each(ci.MemberNames.begin(), ci.MemberNames.end(),
         [this](auto& data)
         {
             read(data);
         });
+    // ClassWithId records copy ids from their metadata class, names are hashed once per declaration
+    ci.NameId = StringInterner::intern(ci.Name.value.string);
+    ci.MemberNameIds.reserve(ci.MemberNames.size());
+    for (const auto& name : ci.MemberNames)
+    {
+        ci.MemberNameIds.push_back(StringInterner::intern(name.value.string));
+    }
     return false;
 }
 
 bool BinaryFileParser::read(ufe::ClassWithMembersAndTypes& cmt, bool system_class /* = false */)
 {
     read(cmt.m_ClassInfo);
+    cmt.m_system_class = system_class;
+    if (!m_file)
+    {
+        return false;
+    }
     auto& mti = cmt.m_MemberTypeInfo;
 
     for (int i = 0; i < cmt.m_ClassInfo.MemberCount.value; ++i)
@@ -490,8 +1168,7 @@ bool BinaryFileParser::read(ufe::ClassWithMembersAndTypes& cmt, bool system_clas
         mti.LibraryId = read<int32_t>();
         spdlog::debug("library id: {}", mti.LibraryId);
     }
-    read_members_data(mti, cmt.m_ClassInfo);
-    return false;
+    return true;
 }
 
 
@@ -509,14 +1186,22 @@ bool BinaryFileParser::read(ufe::LengthPrefixedString& lps)
         if ((seg & 0x80) == 0x00) break;
     }
     lps.m_original_len = len;
-    lps.string.resize(len);
-    m_file.read(lps.string.data(), len);
+    const auto pos = static_cast<std::streamoff>(m_file.tellg());
+    if (!m_file || pos + len > static_cast<std::streamoff>(m_raw_data.size()))
+    {
+        lps.string = {};
+        m_file.setstate(std::ios::failbit);
+        return false;
+    }
+    lps.string = std::string_view{ m_raw_data.data() + pos, len };
+    m_file.seekg(len, std::ios::cur);
     return true;
 }
 
 bool BinaryFileParser::read(ufe::ClassTypeInfo& cti)
 {
     read(cti.TypeName);
+    cti.TypeNameId = StringInterner::intern(cti.TypeName.string);
     cti.LibraryId = read<int32_t>();
     return true;
 }
@@ -535,16 +1220,11 @@ bool BinaryFileParser::read(ufe::ClassWithId& cmt)
 
     read(obj_id);
     read(cmt.MetadataId);
-    const auto& ref_class = get_record(cmt.MetadataId.value);
-    if (ref_class.has_value())
-    {
-        const auto& ref = std::any_cast<const ufe::ClassWithMembersAndTypes&>(ref_class);
-        cmt.m_ClassInfo = ref.m_ClassInfo;
-        cmt.m_MemberTypeInfo = ref.m_MemberTypeInfo;
-        // clear data from copied reference
-        cmt.m_MemberTypeInfo.Data.clear();
+    if (const auto* ref = get_class_metadata(cmt.MetadataId.value))
+    {
+        cmt.m_ClassInfo = ref->m_ClassInfo;
+        cmt.m_MemberTypeInfo = ref->m_MemberTypeInfo;
         cmt.m_ClassInfo.ObjectId = obj_id;
-        read_members_data(cmt.m_MemberTypeInfo, cmt.m_ClassInfo);
         return true;
     }
     return false;
@@ -585,6 +1265,10 @@ bool BinaryFileParser::read(ufe::BinaryArray& arr_bin)
     arr_bin.ObjectId = read<int32_t>();
     arr_bin.BinaryArrayTypeEnum = static_cast<ufe::EBinaryArrayTypeEnumeration>(read());
     arr_bin.Rank = read<int32_t>();
+    if (!m_file)
+    {
+        return false;
+    }
     arr_bin.Lengths.resize(arr_bin.Rank);
     for (auto& len : arr_bin.Lengths)
     {
@@ -637,123 +1321,48 @@ bool BinaryFileParser::read(ufe::BinaryArray& arr_bin)
     return true;
 }
 
-void BinaryFileParser::read_members_data(ufe::MemberTypeInfo& mti, ufe::ClassInfo& ci)
+std::any BinaryFileParser::read_member_primitive(ufe::EPrimitiveTypeEnumeration type, std::string_view member_name)
 {
-    auto it_add_info = mti.AdditionalInfos.cbegin();
-    auto it_member_names = ci.MemberNames.cbegin();
-
-    for (auto type : mti.BinaryTypeEnums)
+    switch (type)
     {
-        switch (type)
-        {
-            case ufe::EBinaryTypeEnumeration::Primitive:
-            {
-                switch (std::get<ufe::EPrimitiveTypeEnumeration>(*it_add_info))
-                {
-                    case ufe::EPrimitiveTypeEnumeration::Boolean:
-                    {
-                        process_member<bool>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::Byte:
-                    {
-                        process_member<uint8_t>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::Char:
-                    {
-                        process_member<char>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::Decimal:
-                        throw std::exception("Not implemented!!!");
-                        break;
-                    case ufe::EPrimitiveTypeEnumeration::Double:
-                    {
-                        process_member<double>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::Int16:
-                    {
-                        process_member<int16_t>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::Int32:
-                    {
-                        process_member<int32_t>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::Int64:
-                    {
-                        process_member<int64_t>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::SByte:
-                        throw std::exception("Not implemented!!!");
-                        break;
-                    case ufe::EPrimitiveTypeEnumeration::Single:
-                    {
-                        process_member<float>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::TimeSpan:
-                    {
-                        process_member<int64_t>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::DateTime:
-                    {
-                        process_member<int64_t>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::UInt16:
-                    {
-                        process_member<uint16_t>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::UInt32:
-                    {
-                        process_member<uint32_t>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::UInt64:
-                    {
-                        process_member<uint64_t>(it_member_names, mti);
-                    } break;
-                    case ufe::EPrimitiveTypeEnumeration::Null:
-                        throw std::exception("Not implemented!!!");
-                        break;
-                    case ufe::EPrimitiveTypeEnumeration::String:
-                        throw std::exception("Not implemented!!!");
-                        break;
-                    default:
-                        break;
-                }
-                ++it_add_info;
-            } break;
-            case ufe::EBinaryTypeEnumeration::String:
-            {
-                auto bstr = read_record();
-                mti.Data.push_back(bstr);
-            } break;
-            case ufe::EBinaryTypeEnumeration::Object:
-            {
-                auto rec = read_record();
-                mti.Data.push_back(rec);
-            } break;
-            case ufe::EBinaryTypeEnumeration::SystemClass:
-            {
-                auto rec = read_record();
-                mti.Data.push_back(rec);
-                ++it_add_info;
-            } break;
-            case ufe::EBinaryTypeEnumeration::Class:
-            {
-                auto nested_data = read_record();
-                mti.Data.push_back(nested_data);
-                ++it_add_info;
-            } break;
-            case ufe::EBinaryTypeEnumeration::ObjectArray:
-            case ufe::EBinaryTypeEnumeration::StringArray:
-            case ufe::EBinaryTypeEnumeration::PrimitiveArray:
-            case ufe::EBinaryTypeEnumeration::None:
-            {
-                auto record = read_record();
-                mti.Data.push_back(record);
-            } break;
-            default:
-                break;
-        }
-        ++it_member_names;
+        case ufe::EPrimitiveTypeEnumeration::Boolean:
+            return read_member<bool>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::Byte:
+            return read_member<uint8_t>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::Char:
+            return read_member<char>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::Decimal:
+            throw std::runtime_error("Not implemented!!!");
+        case ufe::EPrimitiveTypeEnumeration::Double:
+            return read_member<double>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::Int16:
+            return read_member<int16_t>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::Int32:
+            return read_member<int32_t>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::Int64:
+            return read_member<int64_t>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::SByte:
+            throw std::runtime_error("Not implemented!!!");
+        case ufe::EPrimitiveTypeEnumeration::Single:
+            return read_member<float>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::TimeSpan:
+            return read_member<int64_t>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::DateTime:
+            return read_member<int64_t>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::UInt16:
+            return read_member<uint16_t>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::UInt32:
+            return read_member<uint32_t>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::UInt64:
+            return read_member<uint64_t>(member_name);
+        case ufe::EPrimitiveTypeEnumeration::Null:
+            throw std::runtime_error("Not implemented!!!");
+        case ufe::EPrimitiveTypeEnumeration::String:
+            throw std::runtime_error("Not implemented!!!");
+        default:
+            break;
     }
+    return {};
 }
 
 std::vector<char> BinaryFileParser::raw_data() const
@@ -761,8 +1370,7 @@ std::vector<char> BinaryFileParser::raw_data() const
     return std::vector<char>(m_raw_data.begin(), m_raw_data.end());
 }
 
-template<>
-bool BinaryFileParser::read<ufe::LengthPrefixedString>(IndexedData<ufe::LengthPrefixedString>& data)
+bool BinaryFileParser::read(IndexedData<ufe::LengthPrefixedString>& data)
 {
     data.offset = m_file.tellg();
     read(data.value);
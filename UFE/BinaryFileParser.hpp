@@ -4,11 +4,19 @@
 #include <fstream>
 #include <map>
 #include <type_traits>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <variant>
+#include <chrono>
 #include "IndexedData.hpp"
 #include <any>
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 #include "Records.hpp"
+#include "Stats.hpp"
+#include "Trace.hpp"
+#include "Projection.hpp"
 
 namespace fs = std::filesystem;
 
@@ -27,16 +35,62 @@ public:
         Compressed,
         Uncompressed
     };
+    BinaryFileParser();
+    ~BinaryFileParser();
     bool open(fs::path file_path);
+    // low memory alternative to open, read_records reads and inflates the file in
+    // chunks as parsing needs them so the whole file content is never held
+    bool open_stream(fs::path file_path);
+    // takes whole file content including the 24 bytes header, file_path is informative only
+    bool load(fs::path file_path, std::string&& file_data);
+    // checks header prefix (at least GZIP_START_OFF + 4 bytes) for a compressed or uncompressed stream
+    static bool is_supported(const std::string& file_data);
+    // checks SerializedStreamHeader at the start of a decoded stream
+    static bool is_stream_header(std::string_view stream);
+    // decoded size expected from the gzip trailer, which holds it modulo 2^32 and is
+    // not checked until the end; clamped to what gzip_size bytes of deflate can hold
+    static uint64_t stream_size_hint(uint64_t gzip_size, uint32_t isize);
+    // most bytes open_stream reserves for the decoded stream, 0 for no limit; a
+    // stream outgrowing its reservation makes the file invalid
+    void set_stream_limit(uint64_t bytes) noexcept { m_stream_limit = bytes; }
     EFileStatus status() const noexcept { return m_status; }
     EFileType file_type() const noexcept { return m_file_type; }
 
+    // strings in records are views into the decoded buffer, parser must outlive them
     const std::vector<std::any>& get_records() const noexcept { return m_root_records; }
     std::string header() const noexcept { return m_header; }
 
     void read_records();
+    // hands every root record to consumer as soon as it is complete, without keep_records
+    // records are released afterwards and only class metadata needed by later ClassWithId
+    // records is kept, get_records() stays empty
+    using RecordConsumer = std::function<void(const std::any& record)>;
+    void read_records(const RecordConsumer& consumer, bool keep_records = false);
+
+    // incremental input, decoded stream bytes arrive through append_data and parse
+    // is called again after each chunk; stream_size must cover the whole stream
+    // since records keep views into the buffer
+    enum class EParseResult
+    {
+        Done,
+        NeedData
+    };
+    void begin_stream(fs::path file_path, std::string header, EFileType file_type, size_t stream_size);
+    bool append_data(const char* data, size_t size);
+    // parses as far as the available data allows, unfinished records are resumed by the next call
+    EParseResult parse(const RecordConsumer& consumer, bool keep_records = false);
 
     std::vector<char> raw_data() const;
+    // decoded stream without copying, valid while the parser lives
+    std::string_view stream() const noexcept { return m_raw_data; }
+
+    // optional per-file timings and counters, not owned
+    void set_stats(FileStats* stats) noexcept { m_stats = stats; }
+    // optional record selection, not owned; consumer then gets selected class records
+    // instead of root records, their unselected members hold ufe::SkippedValue
+    void set_projection(const Projection* projection) noexcept { m_projection = projection && !projection->empty() ? projection : nullptr; }
+    uint64_t records_count() const noexcept { return m_records_count; }
+    uint64_t members_count() const noexcept { return m_members_count; }
 
 private:
     unsigned char read()
@@ -64,12 +118,12 @@ private:
     }
 
     template <typename T>
-    void process_member(std::vector<IndexedData<ufe::LengthPrefixedString>>::const_iterator it_member_names, ufe::MemberTypeInfo& mti)
+    std::any read_member(std::string_view member_name)
     {
         IndexedData<T> tmp;
         read(tmp);
-        spdlog::debug("\t{} = {}", it_member_names->value.string, tmp.value);
-        mti.Data.push_back(std::any{ tmp });
+        spdlog::debug("\t{} = {}", member_name, tmp.value);
+        return tmp;
     }
     
     template <typename T>
@@ -81,8 +135,7 @@ private:
         return true;
     }
 
-    template<>
-    bool read<ufe::LengthPrefixedString>(IndexedData<ufe::LengthPrefixedString>& lps);
+    bool read(IndexedData<ufe::LengthPrefixedString>& lps);
     bool read(ufe::SerializationHeaderRecord& header);
     bool read(ufe::BinaryLibrary& bl);
     bool read(ufe::ClassInfo& ci);
@@ -99,10 +152,60 @@ private:
     bool read(ufe::BinaryArray& arr_bin);
 
     std::any read_primitive_element(ufe::EPrimitiveTypeEnumeration type);
-    const std::any& get_record(int32_t id);
-    std::any read_record();
+    std::any read_member_primitive(ufe::EPrimitiveTypeEnumeration type, std::string_view member_name);
+    const ufe::ClassWithMembersAndTypes* get_class_metadata(int32_t id) const;
 
-    std::any get_ArraySingleString();
+    // Record reader state machine. Leaf records are read at once, container records
+    // (classes and arrays) push a frame which later steps fill element by element,
+    // so nesting depth costs heap instead of call stack. A step that runs out of
+    // input rewinds to where it started and is repeated once more data is available.
+    enum class EStep
+    {
+        Value,    // value holds a complete record, possibly empty for MessageEnd
+        Continue, // frame pushed or elements skipped, nothing to attach
+        NeedData
+    };
+    // what happens to a record with an active projection
+    enum class EMode
+    {
+        Keep,   // value is built, members filtered by scope
+        Search, // value is dropped, nested class records are matched against the projection
+        Skip    // value is dropped, data is stepped over where the length is known
+    };
+    struct Target
+    {
+        EMode mode = EMode::Keep;
+        Projection::Scope scope;
+    };
+    struct Frame
+    {
+        std::variant<ufe::ClassWithMembersAndTypes, ufe::ClassWithId, ufe::ArraySingleString, ufe::BinaryArray> record;
+        int32_t index = 0;       // next member or element
+        int32_t count = 0;
+        size_t add_info = 0;     // next additional type info of class members
+        Target target;
+        bool emit = false;       // selected record, handed to the consumer instead of its parent
+        const char* trace_name = nullptr;
+        std::chrono::steady_clock::time_point start;
+    };
+    // next root record, or next selected record with a projection
+    EStep read_next_record(std::any& record);
+    EStep read_record(std::any& value, const Target& target);
+    EStep read_element(Frame& frame, std::any& value);
+    Target element_target(const Frame& frame, std::string_view member_name);
+    void push_class(Frame&& frame, const ufe::ClassInfo& ci, const Target& target);
+    const Projection::Scope& class_scope(const ufe::ClassInfo& ci);
+    bool skip(std::streamoff size);
+    bool skip_string();
+    // marks the file invalid, a primitive without fixed size can't be skipped
+    EStep unsized_primitive(ufe::EPrimitiveTypeEnumeration type);
+    void attach(Frame& frame, std::any&& value);
+    std::any pop_frame();
+    void push_frame(Frame&& frame);
+    EStep need_data(std::streamoff start);
+    void finish();
+    // next chunk of an open_stream file, false at the end or on errors
+    bool pull_stream();
 
     std::any get_ArraySinglePrimitive();
 
@@ -112,34 +215,65 @@ private:
 
     std::any get_MemberReference();
 
-    std::any get_BinaryArray();
-
     std::any get_BinaryObjectString();
 
-    std::any get_ClassWithMembersAndTypes();
+    std::any get_SerializedStreamHeader();
+
+    bool push_ClassWithMembersAndTypes(bool system_class, const Target& target);
 
-    std::any get_SystemClassWithMembersAndTypes();
+    bool push_ClassWithId(std::any& value, const Target& target);
 
-    std::any get_ClassWithId();
+    bool push_ArraySingleString(const Target& target);
 
-    std::any get_SerializedStreamHeader();
+    bool push_BinaryArray(const Target& target);
+
+    void skip_ArraySinglePrimitive();
 
-    void add_record(int32_t id, std::any&& record)
+    // member types without data, registered before members are read so nested
+    // objects of the same class can reference it
+    void add_class_metadata(const ufe::ClassWithMembersAndTypes& cmt)
     {
-        m_records.emplace_back(std::make_pair(id, record));
+        m_class_metadata.insert_or_assign(cmt.m_ClassInfo.ObjectId.value, cmt);
     }
     ufe::ERecordType get_record_type()
     {
         return static_cast<ufe::ERecordType>(read());
     }
-    void read_members_data(ufe::MemberTypeInfo& mti, ufe::ClassInfo& ci);
     bool check_header();
-    std::vector<std::pair<int32_t, std::any>> m_records;
+    std::unordered_map<int32_t, ufe::ClassWithMembersAndTypes> m_class_metadata;
     std::vector<std::any> m_root_records;
+    std::vector<Frame> m_stack;
+    bool m_header_checked = false;
+    bool m_finished = false;
     fs::path m_file_path;
     EFileStatus m_status = EFileStatus::Empty;
     EFileType m_file_type = EFileType::Uncompressed;
     std::string m_header;
     std::string m_raw_data;
-    mutable std::istringstream m_file;
+    uint64_t m_stream_limit = 0;
+    // reads m_raw_data in place, string views and offsets point into the same buffer
+    class BufferView : public std::streambuf
+    {
+    public:
+        void set(std::string& data) { setg(data.data(), data.data(), data.data() + data.size()); }
+        // data grew in place, read position is kept
+        void extend(std::string& data) { setg(data.data(), data.data() + (gptr() - eback()), data.data() + data.size()); }
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+        {
+            return seekoff(pos, std::ios_base::beg, which);
+        }
+    };
+    BufferView m_buffer;
+    mutable std::istream m_file{ &m_buffer };
+    FileStats* m_stats = nullptr;
+    const Projection* m_projection = nullptr;
+    // class selection by interned name, same class repeats throughout a file
+    std::unordered_map<StringInterner::Id, Projection::Scope> m_class_scopes;
+    uint64_t m_bytes_skipped = 0;
+    uint64_t m_records_count = 0;
+    uint64_t m_members_count = 0;
+    struct StreamSource;
+    std::unique_ptr<StreamSource> m_source;
 };
\ No newline at end of file
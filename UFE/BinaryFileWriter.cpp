@@ -0,0 +1,293 @@
+#include "BinaryFileWriter.hpp"
+#include <fstream>
+#include <mutex>
+#include <gzip/compress.hpp>
+
+BinaryFileWriter::BinaryFileWriter()
+{
+    // assign all callbacks once per run, writers may be created on several threads
+    static std::once_flag registered;
+    std::call_once(registered, [this]
+    {
+        register_any_visitor<ufe::SerializationHeaderRecord>(&BinaryFileWriter::header);
+        register_any_visitor<ufe::BinaryLibrary>(&BinaryFileWriter::binary_library);
+        register_any_visitor<ufe::ClassWithMembersAndTypes>(&BinaryFileWriter::class_with_members_and_types);
+        register_any_visitor<ufe::ClassWithId>(&BinaryFileWriter::class_with_id);
+        register_any_visitor<ufe::MemberReference>(&BinaryFileWriter::member_reference);
+        register_any_visitor<ufe::BinaryObjectString>(&BinaryFileWriter::binary_object_string);
+        register_any_visitor<ufe::ArraySingleString>(&BinaryFileWriter::array_single_string);
+        register_any_visitor<ufe::ArraySinglePrimitive>(&BinaryFileWriter::array_single_primitive);
+        register_any_visitor<ufe::BinaryArray>(&BinaryFileWriter::array_binary);
+        register_any_visitor<ufe::ObjectNull>(&BinaryFileWriter::object_null);
+        register_any_visitor<ufe::ObjectNullMultiple256>(&BinaryFileWriter::object_null_256);
+        register_any_visitor<IndexedData<bool>>(&BinaryFileWriter::write_value<bool>);
+        register_any_visitor<IndexedData<char>>(&BinaryFileWriter::write_value<char>);
+        register_any_visitor<IndexedData<unsigned char>>(&BinaryFileWriter::write_value<unsigned char>);
+        register_any_visitor<IndexedData<int16_t>>(&BinaryFileWriter::write_value<int16_t>);
+        register_any_visitor<IndexedData<uint16_t>>(&BinaryFileWriter::write_value<uint16_t>);
+        register_any_visitor<IndexedData<int32_t>>(&BinaryFileWriter::write_value<int32_t>);
+        register_any_visitor<IndexedData<uint32_t>>(&BinaryFileWriter::write_value<uint32_t>);
+        register_any_visitor<IndexedData<int64_t>>(&BinaryFileWriter::write_value<int64_t>);
+        register_any_visitor<IndexedData<uint64_t>>(&BinaryFileWriter::write_value<uint64_t>);
+        register_any_visitor<IndexedData<float>>(&BinaryFileWriter::write_value<float>);
+        register_any_visitor<IndexedData<double>>(&BinaryFileWriter::write_value<double>);
+    });
+}
+
+std::unordered_map<
+    std::type_index, std::function<void(BinaryFileWriter&, std::any const&)>> BinaryFileWriter::m_any_visitor;
+
+bool BinaryFileWriter::serialize(const std::vector<std::any>& records, std::string& stream)
+{
+    StageTimer timer{ m_stats, EStage::Serialize };
+    m_out = &stream;
+    m_failed = false;
+    for (const auto& rec : records)
+    {
+        process(rec);
+    }
+    write_record_type(ufe::ERecordType::MessageEnd);
+    m_out = nullptr;
+    return !m_failed;
+}
+
+bool BinaryFileWriter::save(std::filesystem::path binary_path, const std::string& header, const std::vector<std::any>& records, bool compressed)
+{
+    std::string stream;
+    if (!serialize(records, stream))
+    {
+        spdlog::error("Record tree of '{}' can't be serialized", binary_path.string());
+        return false;
+    }
+    return save(std::move(binary_path), header, std::string_view{ stream }, compressed);
+}
+
+bool BinaryFileWriter::save(std::filesystem::path binary_path, const std::string& header, std::string_view stream, bool compressed)
+{
+    std::string compressed_data;
+    if (compressed)
+    {
+        try
+        {
+            StageTimer timer{ m_stats, EStage::Deflate };
+            compressed_data = gzip::compress(stream.data(), stream.size(), Z_DEFAULT_COMPRESSION);
+        }
+        catch (std::exception& e)
+        {
+            spdlog::critical("Failed to compress file: {}", e.what());
+            return false;
+        }
+    }
+    std::ofstream bin{ binary_path, std::ios::binary };
+    if (bin)
+    {
+        StageTimer timer{ m_stats, EStage::BinaryWrite };
+        const auto data = compressed ? std::string_view{ compressed_data } : stream;
+        bin.write(header.data(), header.size());
+        bin.write(data.data(), data.size());
+        if (m_stats)
+        {
+            m_stats->bytes_out += static_cast<uint64_t>(bin.tellp());
+        }
+        return true;
+    }
+    spdlog::error("Could not save '{}'", binary_path.string());
+    return false;
+}
+
+void BinaryFileWriter::append_string(std::string& out, std::string_view str)
+{
+    // .NET always writes the shortest 7 bit encoding
+    uint64_t len = str.size();
+    do
+    {
+        uint8_t seg = len & 0x7F;
+        len >>= 7;
+        out.push_back(static_cast<char>(len ? seg | 0x80 : seg));
+    } while (len);
+    out.append(str);
+}
+
+void BinaryFileWriter::write(const ufe::LengthPrefixedString& lps)
+{
+    // prefix is rebuilt from the current value
+    append_string(*m_out, lps.string);
+}
+
+void BinaryFileWriter::write(const ufe::ClassInfo& ci)
+{
+    write(ci.ObjectId.value);
+    write(ci.Name.value);
+    write(static_cast<int32_t>(ci.MemberNames.size()));
+    for (const auto& name : ci.MemberNames)
+    {
+        write(name.value);
+    }
+}
+
+void BinaryFileWriter::write(const ufe::ClassTypeInfo& cti)
+{
+    write(cti.TypeName);
+    write(cti.LibraryId);
+}
+
+void BinaryFileWriter::write_type_infos(const std::vector<ufe::EBinaryTypeEnumeration>& types, const std::vector<ufe::AdditionalInfosType>& infos)
+{
+    for (auto type : types)
+    {
+        write_byte(static_cast<uint8_t>(type));
+    }
+    // parser keeps additional infos only for member types which have one
+    auto it_add_info = infos.cbegin();
+    for (auto type : types)
+    {
+        switch (type)
+        {
+            case ufe::EBinaryTypeEnumeration::Primitive:
+            case ufe::EBinaryTypeEnumeration::SystemClass:
+            case ufe::EBinaryTypeEnumeration::Class:
+            case ufe::EBinaryTypeEnumeration::PrimitiveArray:
+                if (it_add_info == infos.cend())
+                {
+                    spdlog::error("Missing additional type info for '{}'", ufe::EBinaryTypeEnumeration2str(type));
+                    m_failed = true;
+                    return;
+                }
+                write_additional_info(type, *it_add_info++);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void BinaryFileWriter::write_additional_info(ufe::EBinaryTypeEnumeration type, const ufe::AdditionalInfosType& info)
+{
+    switch (type)
+    {
+        case ufe::EBinaryTypeEnumeration::Primitive:
+        case ufe::EBinaryTypeEnumeration::PrimitiveArray:
+            write_byte(static_cast<uint8_t>(std::get<ufe::EPrimitiveTypeEnumeration>(info)));
+            break;
+        case ufe::EBinaryTypeEnumeration::SystemClass:
+            write(std::get<ufe::LengthPrefixedString>(info));
+            break;
+        case ufe::EBinaryTypeEnumeration::Class:
+            write(std::get<ufe::ClassTypeInfo>(info));
+            break;
+        default:
+            break;
+    }
+}
+
+void BinaryFileWriter::write_data(const std::vector<std::any>& data)
+{
+    for (const auto& rec : data)
+    {
+        process(rec);
+    }
+}
+
+void BinaryFileWriter::header(const ufe::SerializationHeaderRecord& rec)
+{
+    write_record_type(ufe::ERecordType::SerializedStreamHeader);
+    write(rec.RootId.value);
+    write(rec.HeaderId.value);
+    write(rec.MajorVersion.value);
+    write(rec.MinorVersion.value);
+}
+
+void BinaryFileWriter::binary_library(const ufe::BinaryLibrary& bl)
+{
+    write_record_type(ufe::ERecordType::BinaryLibrary);
+    write(bl.LibraryId.value);
+    write(bl.LibraryName.value);
+}
+
+void BinaryFileWriter::class_with_members_and_types(const ufe::ClassWithMembersAndTypes& cmt)
+{
+    const auto& mti = cmt.m_MemberTypeInfo;
+    write_record_type(cmt.m_system_class ? ufe::ERecordType::SystemClassWithMembersAndTypes : ufe::ERecordType::ClassWithMembersAndTypes);
+    write(cmt.m_ClassInfo);
+    write_type_infos(mti.BinaryTypeEnums, mti.AdditionalInfos);
+    if (!cmt.m_system_class)
+    {
+        write(mti.LibraryId);
+    }
+    write_data(mti.Data);
+}
+
+void BinaryFileWriter::class_with_id(const ufe::ClassWithId& cwi)
+{
+    write_record_type(ufe::ERecordType::ClassWithId);
+    write(cwi.m_ClassInfo.ObjectId.value);
+    write(cwi.MetadataId.value);
+    write_data(cwi.m_MemberTypeInfo.Data);
+}
+
+void BinaryFileWriter::binary_object_string(const ufe::BinaryObjectString& bos)
+{
+    write_record_type(ufe::ERecordType::BinaryObjectString);
+    write(bos.m_ObjectId);
+    write(bos.m_Value.value);
+}
+
+void BinaryFileWriter::member_reference(const ufe::MemberReference& mref)
+{
+    write_record_type(ufe::ERecordType::MemberReference);
+    write(mref.m_idRef);
+}
+
+void BinaryFileWriter::object_null_256(const ufe::ObjectNullMultiple256& obj)
+{
+    write_record_type(ufe::ERecordType::ObjectNullMultiple256);
+    write(obj.NullCount);
+}
+
+void BinaryFileWriter::array_single_string(const ufe::ArraySingleString& arr)
+{
+    write_record_type(ufe::ERecordType::ArraySingleString);
+    write(arr.ObjectId);
+    write(arr.Length);
+    write_data(arr.Data);
+}
+
+void BinaryFileWriter::array_single_primitive(const ufe::ArraySinglePrimitive& arr)
+{
+    write_record_type(ufe::ERecordType::ArraySinglePrimitive);
+    write(arr.ObjectId);
+    write(arr.Length);
+    write_byte(static_cast<uint8_t>(arr.PrimitiveTypeEnum));
+    write_data(arr.Data);
+}
+
+void BinaryFileWriter::array_binary(const ufe::BinaryArray& arr)
+{
+    write_record_type(ufe::ERecordType::BinaryArray);
+    write(arr.ObjectId);
+    write_byte(static_cast<uint8_t>(arr.BinaryArrayTypeEnum));
+    write(arr.Rank);
+    for (auto len : arr.Lengths)
+    {
+        write(len);
+    }
+    for (auto bound : arr.LowerBounds)
+    {
+        write(bound);
+    }
+    write_byte(static_cast<uint8_t>(arr.TypeEnum));
+    write_additional_info(arr.TypeEnum, arr.AdditionalTypeInfo);
+    write_data(arr.Data);
+}
+
+void BinaryFileWriter::process(const std::any& a)
+{
+    if (const auto it = m_any_visitor.find(std::type_index(a.type()));
+        it != m_any_visitor.cend()) {
+        it->second(*this, a);
+    }
+    else {
+        spdlog::error("BinaryFileWriter unregistered type: {}", a.type().name());
+        m_failed = true;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeindex>
+#include <functional>
+#include <unordered_map>
+#include "IndexedData.hpp"
+#include <any>
+#include <spdlog/spdlog.h>
+#include "Records.hpp"
+#include "Stats.hpp"
+
+// Serializes parsed record tree back into NRBF stream in one sequential pass,
+// unchanged tree reproduces decoded stream of the original file byte for byte
+class BinaryFileWriter
+{
+public:
+    BinaryFileWriter();
+    // stream is terminated with MessageEnd, false if tree contains records which can't be written
+    bool serialize(const std::vector<std::any>& records, std::string& stream);
+    // writes 24 bytes header followed by gzip-wrapped or plain stream
+    bool save(std::filesystem::path binary_path, const std::string& header, const std::vector<std::any>& records, bool compressed);
+    // same for an already serialized stream
+    bool save(std::filesystem::path binary_path, const std::string& header, std::string_view stream, bool compressed);
+    // optional per-file timings and counters, not owned
+    void set_stats(FileStats* stats) noexcept { m_stats = stats; }
+    // appends str preceded by its 7 bit encoded length, as LengthPrefixedString is stored
+    static void append_string(std::string& out, std::string_view str);
+private:
+
+    template<class T, class F>
+    inline void register_any_visitor(F const& f)
+    {
+        m_any_visitor[std::type_index(typeid(T))] = [f](BinaryFileWriter& self, std::any const& a) -> void {
+            std::invoke(f, self, std::any_cast<T const&>(a));
+        };
+    }
+
+    void write_byte(uint8_t b) { m_out->push_back(static_cast<char>(b)); }
+    void write_record_type(ufe::ERecordType rec) { write_byte(static_cast<uint8_t>(rec)); }
+    template <typename T>
+    void write(T value)
+    {
+        static_assert(std::is_fundamental_v<T>, "Only fundamental types allowed");
+        m_out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    template <typename T>
+    void write_value(const IndexedData<T>& x) { write(x.value); }
+    void write(const ufe::LengthPrefixedString& lps);
+    void write(const ufe::ClassInfo& ci);
+    void write(const ufe::ClassTypeInfo& cti);
+    void write_type_infos(const std::vector<ufe::EBinaryTypeEnumeration>& types, const std::vector<ufe::AdditionalInfosType>& infos);
+    void write_additional_info(ufe::EBinaryTypeEnumeration type, const ufe::AdditionalInfosType& info);
+    void write_data(const std::vector<std::any>& data);
+
+    void header(const ufe::SerializationHeaderRecord& rec);
+    void binary_library(const ufe::BinaryLibrary& bl);
+    void class_with_members_and_types(const ufe::ClassWithMembersAndTypes& cmt);
+    void class_with_id(const ufe::ClassWithId& cwi);
+    void binary_object_string(const ufe::BinaryObjectString& bos);
+    void member_reference(const ufe::MemberReference& mref);
+    void object_null(const ufe::ObjectNull&) { write_record_type(ufe::ERecordType::ObjectNull); }
+    void object_null_256(const ufe::ObjectNullMultiple256& obj);
+    void array_single_string(const ufe::ArraySingleString& arr);
+    void array_single_primitive(const ufe::ArraySinglePrimitive& arr);
+    void array_binary(const ufe::BinaryArray& arr);
+
+    static std::unordered_map<
+        std::type_index, std::function<void(BinaryFileWriter&, std::any const&)>>
+        m_any_visitor;
+    void process(const std::any& a);
+    std::string* m_out = nullptr;
+    bool m_failed = false;
+    FileStats* m_stats = nullptr;
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+struct QueueStats
+{
+    size_t capacity = 0;
+    size_t max_depth = 0;
+    double avg_depth = 0.0;                 // sampled on every push
+    std::chrono::nanoseconds push_wait{};   // producers blocked on a full queue
+    std::chrono::nanoseconds pop_wait{};    // consumers blocked on an empty queue
+};
+
+// Bounded multi producer multi consumer ring (Vyukov), each cell carries a
+// sequence number so push and pop claim slots with a single CAS and no lock.
+// Blocking push/pop wait on counters with atomic wait/notify only when the
+// ring is full or empty. Capacity is rounded up to a power of two.
+template<class T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity)
+        : m_capacity{ std::bit_ceil(std::max<size_t>(capacity, 2)) }, m_mask{ m_capacity - 1 },
+        m_cells{ std::make_unique<Cell[]>(m_capacity) }
+    {
+        for (size_t i = 0; i < m_capacity; ++i)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // value is moved from only on success
+    bool try_push(T& value)
+    {
+        auto pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& cell = m_cells[pos & m_mask];
+            const auto seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    sample_depth(pos + 1);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T& value)
+    {
+        auto pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& cell = m_cells[pos & m_mask];
+            const auto seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = std::move(cell.value);
+                    cell.sequence.store(pos + m_capacity, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // empty
+            }
+            else
+            {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // blocks while full, false if the queue was closed
+    bool push(T&& value)
+    {
+        std::chrono::steady_clock::time_point wait_start{};
+        for (;;)
+        {
+            // counter is read before trying so a pop in between wakes the wait below
+            const auto popped = m_popped.load(std::memory_order_acquire);
+            if (m_closed.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            if (try_push(value))
+            {
+                add_wait(m_push_wait_ns, wait_start);
+                m_pushed.fetch_add(1, std::memory_order_release);
+                m_pushed.notify_all();
+                return true;
+            }
+            if (wait_start == std::chrono::steady_clock::time_point{})
+            {
+                wait_start = std::chrono::steady_clock::now();
+            }
+            m_popped.wait(popped, std::memory_order_acquire);
+        }
+    }
+
+    // blocks while empty, false once the queue is closed and drained
+    bool pop(T& value)
+    {
+        std::chrono::steady_clock::time_point wait_start{};
+        for (;;)
+        {
+            const auto pushed = m_pushed.load(std::memory_order_acquire);
+            const bool closed = m_closed.load(std::memory_order_acquire);
+            if (try_pop(value))
+            {
+                add_wait(m_pop_wait_ns, wait_start);
+                m_popped.fetch_add(1, std::memory_order_release);
+                m_popped.notify_all();
+                return true;
+            }
+            if (closed)
+            {
+                add_wait(m_pop_wait_ns, wait_start);
+                return false;
+            }
+            if (wait_start == std::chrono::steady_clock::time_point{})
+            {
+                wait_start = std::chrono::steady_clock::now();
+            }
+            m_pushed.wait(pushed, std::memory_order_acquire);
+        }
+    }
+
+    // no more pushes, waiting consumers drain what is left and return false
+    void close()
+    {
+        m_closed.store(true, std::memory_order_release);
+        m_pushed.fetch_add(1, std::memory_order_release);
+        m_pushed.notify_all();
+        m_popped.fetch_add(1, std::memory_order_release);
+        m_popped.notify_all();
+    }
+
+    QueueStats stats() const
+    {
+        QueueStats s;
+        s.capacity = m_capacity;
+        s.max_depth = m_max_depth.load(std::memory_order_relaxed);
+        const auto samples = m_depth_samples.load(std::memory_order_relaxed);
+        s.avg_depth = samples ? static_cast<double>(m_depth_sum.load(std::memory_order_relaxed)) / samples : 0.0;
+        s.push_wait = std::chrono::nanoseconds{ m_push_wait_ns.load(std::memory_order_relaxed) };
+        s.pop_wait = std::chrono::nanoseconds{ m_pop_wait_ns.load(std::memory_order_relaxed) };
+        return s;
+    }
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    void sample_depth(size_t enqueued)
+    {
+        const auto dequeued = m_dequeue_pos.load(std::memory_order_relaxed);
+        const size_t depth = enqueued > dequeued ? enqueued - dequeued : 0;
+        m_depth_sum.fetch_add(depth, std::memory_order_relaxed);
+        m_depth_samples.fetch_add(1, std::memory_order_relaxed);
+        auto max_depth = m_max_depth.load(std::memory_order_relaxed);
+        while (depth > max_depth && !m_max_depth.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    static void add_wait(std::atomic<int64_t>& total, std::chrono::steady_clock::time_point wait_start)
+    {
+        if (wait_start != std::chrono::steady_clock::time_point{})
+        {
+            total.fetch_add((std::chrono::steady_clock::now() - wait_start).count(), std::memory_order_relaxed);
+        }
+    }
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    // producers and consumers touch different cache lines
+    alignas(64) std::atomic<size_t> m_enqueue_pos{ 0 };
+    alignas(64) std::atomic<size_t> m_dequeue_pos{ 0 };
+    alignas(64) std::atomic<uint32_t> m_pushed{ 0 };
+    alignas(64) std::atomic<uint32_t> m_popped{ 0 };
+    std::atomic<bool> m_closed{ false };
+    std::atomic<size_t> m_max_depth{ 0 };
+    std::atomic<uint64_t> m_depth_sum{ 0 };
+    std::atomic<uint64_t> m_depth_samples{ 0 };
+    std::atomic<int64_t> m_push_wait_ns{ 0 };
+    std::atomic<int64_t> m_pop_wait_ns{ 0 };
+};
@@ -5,14 +5,67 @@ CLIParser::CLIParser()
     try
     {
         m_app.add_option("path", m_base_path, "file/directory to be processed")->check(CLI::ExistingPath);
-        m_app.add_flag("-e,--export", m_export, "export file(s) to json, resulting filename is '<parsed_filename>.json'");
-        m_app.add_flag("-p,--patch", m_patch, "patch existing binary file(s) with respective json file(s)");
+        auto export_opt = m_app.add_flag("-e,--export", m_export, "export file(s) to json, resulting filename is '<parsed_filename>.json'");
+        auto patch_opt = m_app.add_flag("-p,--patch", m_patch, "patch existing binary file(s) with respective json file(s)");
         //m_app.add_option("-p,--patch", m_patch_dir, "output directory for json files, default is parsed file directory");
         //auto out_opt = m_app.add_option("-o,--outdir", m_out_dir, "output directory for json files, default is parsed file directory");
         //m_app.add_option("-r,--rootdir", m_root_dir, "root directory used as reference for creating original directory structure")->needs(out_opt);
-        m_app.add_flag("-v,--validate", m_validate, "verify file(s) integrity for packed/unpacked files");
+        auto validate_opt = m_app.add_flag("-v,--validate", m_validate, "verify file(s) integrity for packed/unpacked files");
         m_app.add_option("-l,--loglevel", m_logging_level, "set logging level, [trace, debug, info, warn, error, critical, off], default info")->check(CLI::Range(0, 6));
         m_app.add_flag("--log_file", m_log_file, "log to file 'ufe.log' instead of console");
+        m_app.add_flag("--stats", m_stats, "print per stage timings, byte and record counts after processing");
+        m_app.add_flag("--mem_stats", m_memory_stats, "track heap usage per stage and file, report peak memory, implies --stats");
+        m_app.add_option("--stats_json", m_stats_json, "save per file and total stats report to json file, implies --stats");
+        m_app.add_option("--trace", m_trace_file, "save chrome trace event timeline of processing to json file (chrome://tracing, ui.perfetto.dev)");
+        auto select_opt = m_app.add_option("--select", m_select, "export only matching class records and members, '<class>[:<member>.<member>...]', '*' and '?' wildcards, repeatable")
+            ->excludes(patch_opt)->excludes(validate_opt);
+        m_app.add_flag("-t,--triage", m_triage, "classify file(s) as compressed, uncompressed or unsupported from their headers only and list sizes");
+        m_app.add_option("--triage_json", m_triage_json, "save triage listing to json file, usable as --plan, implies --triage");
+        auto plan_opt = m_app.add_option("--plan", m_plan, "process supported files of a triage json listing instead of scanning path")->check(CLI::ExistingFile);
+        m_app.add_option("--table", m_table_dir, "save one table per class with a column per member as csv and binary columnar files to directory, honours --select")
+            ->excludes(patch_opt);
+        m_app.add_flag("--make_patch", m_make_patch, "save the members of edited json file(s) that differ from the binary as '<parsed_filename>.ufepatch', -p applies a patch not older than its json instead of the json")
+            ->excludes(export_opt)->excludes(select_opt);
+        m_app.add_option("--layer", m_layers, "patch with a mod directory of '<relative binary path>.ufepatch' or '.json' edits instead of the json next to each binary, "
+            "repeatable in load order, later layers win, every binary is written once")
+            ->needs(patch_opt)->excludes(export_opt)->excludes(validate_opt)->check(CLI::ExistingPath);
+        m_app.add_option("--layer_json", m_layer_json, "save merged edits and conflicts of --layer patching to json file");
+        m_app.add_option("--io_threads", m_io_threads, "read stage threads of the directory pipeline when io_uring is not available, 0 processes files one by one without the pipeline, default 4");
+        m_app.add_option("--io_depth", m_io_depth, "file reads in flight in the read stage of the directory pipeline, default 32")->check(CLI::PositiveNumber);
+        m_app.add_option("--inflate_threads", m_inflate_threads, "inflate stage threads of the directory pipeline, default 2")->check(CLI::PositiveNumber);
+        m_app.add_option("--parse_threads", m_parse_threads, "parse stage threads of the directory pipeline (parse, export, patch, validate), default 4")->check(CLI::PositiveNumber);
+        m_app.add_option("--emit_threads", m_emit_threads, "emit stage threads of the directory pipeline writing json files, default 2")->check(CLI::PositiveNumber);
+        m_app.add_option("--dedup", m_dedup, "process byte identical files of a directory run once, copies get a copy or hard link of the json export, [off, copy, link], default copy")
+            ->check(CLI::IsMember({ "off", "copy", "link" }));
+        m_app.add_option("--mem_limit", m_mem_limit, "memory budget in MB, files wait for admission while their estimated working sets don't fit, large files are streamed in chunks, default 0 (no limit)");
+        m_app.add_option("--queue_depth", m_queue_depth, "files waiting between two pipeline stages, default 32")->check(CLI::PositiveNumber);
+        m_app.add_flag("--watch", m_watch, "keep running after processing a directory, export changed binaries (-e) and patch binaries of changed json files (-p)")
+            ->excludes(plan_opt);
+        m_app.add_option("--debounce", m_debounce, "quiet time in ms before a changed file is processed in --watch mode, default 300");
+        m_serve = m_app.add_subcommand("serve", "keep parsed files cached and answer export/get/set/patch/validate requests on a unix domain socket");
+        m_serve->add_option("--socket", m_socket_path, "socket file to listen on, default 'ufe.sock'");
+        m_serve->add_option("--cache_mb", m_cache_mb, "memory limit of the parsed file cache in MB, least recently used files are dropped first, entries are measured by counting heap allocations, default 512")->check(CLI::PositiveNumber);
+        m_diff = m_app.add_subcommand("diff", "report changed members between two versions of a file or directory tree, compared by structural hashes");
+        m_diff->add_option("old", m_diff_old, "old file or directory")->check(CLI::ExistingPath)->required();
+        m_diff->add_option("new", m_diff_new, "new file or directory")->check(CLI::ExistingPath)->required();
+        m_diff->add_option("--json", m_diff_json, "save changes to json file");
+        m_rebase = m_app.add_subcommand("rebase", "carry json mods made for an old game version over to a new one, conflicting values are reported");
+        m_rebase->add_option("old", m_rebase_old, "binary file or directory of the version the mod was made for")->check(CLI::ExistingPath)->required();
+        m_rebase->add_option("mod", m_rebase_mod, "mod json file or directory of '<relative binary path>.json' files")->check(CLI::ExistingPath)->required();
+        m_rebase->add_option("new", m_rebase_new, "binary file or directory of the new version")->check(CLI::ExistingPath)->required();
+        m_rebase->add_option("-o,--out", m_rebase_out, "rebased json file or directory, default is '<new binary>.json' ready for -p");
+        m_rebase->add_option("--json", m_rebase_json, "save applied edits and conflicts to json file");
+        m_transform = m_app.add_subcommand("transform", "update matching members of every file with rules, '<class>:<member path> [if <compare> <value>] <update> <value>'");
+        m_transform->add_option("path", m_transform_path, "file or directory to transform")->check(CLI::ExistingPath)->required();
+        m_transform->add_option("-r,--rule", m_transform_rules, "rule like 'Weapon*:Damage *= 1.1' or '*:Weight if > 10 = 10', repeatable, applied in order")->required();
+        m_transform->add_flag("--dry_run", m_transform_dry_run, "report edits without writing files");
+        m_transform->add_option("--preview", m_transform_preview, "edits listed in the report, default 10");
+        m_transform->add_option("--json", m_transform_json, "save edit counts and previews to json file");
+        m_strings = m_app.add_subcommand("strings", "export every string of a file or directory to one deduplicated table for translation, or import a translated table");
+        m_strings->add_option("path", m_strings_path, "file or directory the table belongs to")->check(CLI::ExistingPath)->required();
+        auto table_export = m_strings->add_option("--export", m_strings_export, "save the string table to json file");
+        m_strings->add_option("--import", m_strings_import, "patch every binary with the changed texts of a translated string table")
+            ->check(CLI::ExistingFile)->excludes(table_export);
     }
     catch (std::exception& e)
     {
@@ -30,10 +83,25 @@ int CLIParser::parse(int argc, char** argv)
     {
         return m_app.exit(e);
     }
-    if (base_path().empty())
+    if (!serve() && !diff() && !rebase() && !transform() && !strings() && base_path().empty() && plan().empty())
     {
         auto err = CLI::Error{ "Path validation", "Invalid base path", CLI::ExitCodes::ValidationError };
         return m_app.exit(err);
     }
+    if (watch() && (!std::filesystem::is_directory(base_path()) || !(export_mode() || patch())))
+    {
+        auto err = CLI::Error{ "Watch mode", "--watch needs a directory and -e or -p", CLI::ExitCodes::ValidationError };
+        return m_app.exit(err);
+    }
+    if (strings() && strings_export().empty() && strings_import().empty())
+    {
+        auto err = CLI::Error{ "Strings", "strings needs --export or --import", CLI::ExitCodes::ValidationError };
+        return m_app.exit(err);
+    }
+    if (!layers().empty() && (watch() || make_patch() || !plan().empty()))
+    {
+        auto err = CLI::Error{ "Layers", "--layer can't be combined with --watch, --make_patch or --plan", CLI::ExitCodes::ValidationError };
+        return m_app.exit(err);
+    }
     return 0;
 }
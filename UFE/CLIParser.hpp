@@ -2,7 +2,10 @@
 #include "CLI/App.hpp"
 #include "CLI/Formatter.hpp"
 #include "CLI/Config.hpp"
+#include <chrono>
 #include <filesystem>
+#include <string>
+#include <vector>
 #include <spdlog/spdlog.h>
 #include "spdlog/sinks/basic_file_sink.h"
 class CLIParser
@@ -17,7 +20,54 @@ public:
     const std::filesystem::path& root_dir() const { return m_root_dir; }
     bool validate() const { return m_validate; }
     bool patch() const { return m_patch; }
+    bool make_patch() const { return m_make_patch; }
+    const std::vector<std::filesystem::path>& layers() const { return m_layers; }
+    const std::filesystem::path& layer_json() const { return m_layer_json; }
     bool log_file() const { return m_log_file; }
+    bool stats() const { return m_stats || m_memory_stats || !m_stats_json.empty(); }
+    bool memory_stats() const { return m_memory_stats; }
+    const std::filesystem::path& trace_file() const { return m_trace_file; }
+    const std::filesystem::path& stats_json() const { return m_stats_json; }
+    const std::vector<std::string>& select() const { return m_select; }
+    bool triage() const { return m_triage || !m_triage_json.empty(); }
+    const std::filesystem::path& triage_json() const { return m_triage_json; }
+    const std::filesystem::path& plan() const { return m_plan; }
+    const std::filesystem::path& table_dir() const { return m_table_dir; }
+    size_t io_threads() const { return m_io_threads; }
+    size_t io_depth() const { return m_io_depth; }
+    size_t inflate_threads() const { return m_inflate_threads; }
+    size_t parse_threads() const { return m_parse_threads; }
+    size_t emit_threads() const { return m_emit_threads; }
+    size_t queue_depth() const { return m_queue_depth; }
+    const std::string& dedup() const { return m_dedup; }
+    // bytes, 0 is no limit
+    uint64_t mem_limit() const { return static_cast<uint64_t>(m_mem_limit) * 1024 * 1024; }
+    bool watch() const { return m_watch; }
+    std::chrono::milliseconds debounce() const { return std::chrono::milliseconds{ m_debounce }; }
+    bool serve() const { return m_serve->parsed(); }
+    const std::filesystem::path& socket_path() const { return m_socket_path; }
+    // bytes
+    uint64_t cache_limit() const { return static_cast<uint64_t>(m_cache_mb) * 1024 * 1024; }
+    bool diff() const { return m_diff->parsed(); }
+    const std::filesystem::path& diff_old() const { return m_diff_old; }
+    const std::filesystem::path& diff_new() const { return m_diff_new; }
+    const std::filesystem::path& diff_json() const { return m_diff_json; }
+    bool rebase() const { return m_rebase->parsed(); }
+    const std::filesystem::path& rebase_old() const { return m_rebase_old; }
+    const std::filesystem::path& rebase_mod() const { return m_rebase_mod; }
+    const std::filesystem::path& rebase_new() const { return m_rebase_new; }
+    const std::filesystem::path& rebase_out() const { return m_rebase_out; }
+    const std::filesystem::path& rebase_json() const { return m_rebase_json; }
+    bool transform() const { return m_transform->parsed(); }
+    const std::filesystem::path& transform_path() const { return m_transform_path; }
+    const std::vector<std::string>& transform_rules() const { return m_transform_rules; }
+    bool transform_dry_run() const { return m_transform_dry_run; }
+    size_t transform_preview() const { return m_transform_preview; }
+    const std::filesystem::path& transform_json() const { return m_transform_json; }
+    bool strings() const { return m_strings->parsed(); }
+    const std::filesystem::path& strings_path() const { return m_strings_path; }
+    const std::filesystem::path& strings_export() const { return m_strings_export; }
+    const std::filesystem::path& strings_import() const { return m_strings_import; }
 private:
     CLI::App m_app;
     int m_logging_level = spdlog::level::info;
@@ -29,5 +79,50 @@ private:
     std::filesystem::path m_patch_dir;
     bool m_validate = false;
     bool m_patch = false;
+    bool m_make_patch = false;
+    std::vector<std::filesystem::path> m_layers;
+    std::filesystem::path m_layer_json;
+    bool m_stats = false;
+    bool m_memory_stats = false;
+    std::filesystem::path m_stats_json;
+    std::filesystem::path m_trace_file;
+    std::vector<std::string> m_select;
+    bool m_triage = false;
+    std::filesystem::path m_triage_json;
+    std::filesystem::path m_plan;
+    std::filesystem::path m_table_dir;
+    size_t m_io_threads = 4;
+    size_t m_io_depth = 32;
+    size_t m_inflate_threads = 2;
+    size_t m_parse_threads = 4;
+    size_t m_emit_threads = 2;
+    size_t m_queue_depth = 32;
+    size_t m_mem_limit = 0;
+    std::string m_dedup = "copy";
+    bool m_watch = false;
+    size_t m_debounce = 300;
+    CLI::App* m_serve = nullptr;
+    std::filesystem::path m_socket_path = "ufe.sock";
+    size_t m_cache_mb = 512;
+    CLI::App* m_diff = nullptr;
+    std::filesystem::path m_diff_old;
+    std::filesystem::path m_diff_new;
+    std::filesystem::path m_diff_json;
+    CLI::App* m_rebase = nullptr;
+    std::filesystem::path m_rebase_old;
+    std::filesystem::path m_rebase_mod;
+    std::filesystem::path m_rebase_new;
+    std::filesystem::path m_rebase_out;
+    std::filesystem::path m_rebase_json;
+    CLI::App* m_transform = nullptr;
+    std::filesystem::path m_transform_path;
+    std::vector<std::string> m_transform_rules;
+    bool m_transform_dry_run = false;
+    size_t m_transform_preview = 10;
+    std::filesystem::path m_transform_json;
+    CLI::App* m_strings = nullptr;
+    std::filesystem::path m_strings_path;
+    std::filesystem::path m_strings_export;
+    std::filesystem::path m_strings_import;
 };
 
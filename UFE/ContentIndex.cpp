@@ -0,0 +1,145 @@
+#include "ContentIndex.hpp"
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+namespace fs = std::filesystem;
+
+ContentIndex::EMode ContentIndex::mode_from_str(std::string_view mode)
+{
+    if (mode == "copy")
+    {
+        return EMode::Copy;
+    }
+    if (mode == "link")
+    {
+        return EMode::Link;
+    }
+    return EMode::Off;
+}
+
+bool ContentIndex::claim(const fs::path& file, std::string_view content)
+{
+    if (m_mode == EMode::Off)
+    {
+        return true;
+    }
+    const Key key{ content.size(), std::hash<std::string_view>{}(content) };
+    std::vector<fs::path> owners;
+    {
+        std::lock_guard lock{ m_mutex };
+        if (const auto it = m_owners.find(key); it != m_owners.end())
+        {
+            owners = it->second;
+        }
+    }
+    // owners are compared outside the lock, copies read at the same time may both end up processed
+    for (const auto& owner : owners)
+    {
+        if (same_content(owner, content))
+        {
+            spdlog::debug("File '{}' is identical to '{}'", file.string(), owner.string());
+            std::lock_guard lock{ m_mutex };
+            m_duplicates.push_back({ file, owner, content.size() });
+            return false;
+        }
+    }
+    std::lock_guard lock{ m_mutex };
+    m_owners[key].push_back(file);
+    return true;
+}
+
+bool ContentIndex::same_content(const fs::path& file, std::string_view content)
+{
+    std::ifstream in{ file, std::ios::binary };
+    std::string data(content.size(), '\0');
+    in.read(data.data(), data.size());
+    return in && in.peek() == std::ifstream::traits_type::eof() && data == content;
+}
+
+void ContentIndex::finish(const fs::path& file, Outcome outcome)
+{
+    if (m_mode == EMode::Off)
+    {
+        return;
+    }
+    std::lock_guard lock{ m_mutex };
+    m_outcomes[file] = std::move(outcome);
+}
+
+void ContentIndex::apply(bool exported, bool validated) const
+{
+    for (const auto& dup : m_duplicates)
+    {
+        const auto it = m_outcomes.find(dup.owner);
+        if (it == m_outcomes.end())
+        {
+            spdlog::warn("File '{}' is identical to '{}', which couldn't be processed", dup.file.string(), dup.owner.string());
+            continue;
+        }
+        const auto& owner = it->second;
+        if (exported && owner.json.empty())
+        {
+            spdlog::warn("File '{}' not exported, identical to '{}' which wasn't exported", dup.file.string(), dup.owner.string());
+        }
+        else if (exported)
+        {
+            fs::path json_path = dup.file;
+            json_path += ".json";
+            // an earlier export of the copy may be a link to the owner's json or a stale file
+            std::error_code ec;
+            fs::remove(json_path, ec);
+            ec.clear();
+            if (m_mode == EMode::Link)
+            {
+                fs::create_hard_link(owner.json, json_path, ec);
+            }
+            if (m_mode == EMode::Copy || ec)
+            {
+                ec.clear();
+                fs::copy_file(owner.json, json_path, fs::copy_options::overwrite_existing, ec);
+            }
+            if (ec)
+            {
+                spdlog::error("Could not save '{}': {}", json_path.string(), ec.message());
+            }
+            else
+            {
+                spdlog::info("Exporting data to '{}' (identical to '{}')", json_path.string(), dup.owner.string());
+            }
+        }
+        if (validated && owner.validated)
+        {
+            spdlog::info("File '{}' is identical to '{}', validated with it", dup.file.string(), dup.owner.string());
+        }
+        else if (validated)
+        {
+            spdlog::warn("File '{}' is identical to '{}', validation status '{}'", dup.file.string(), dup.owner.string(), owner.status);
+        }
+    }
+}
+
+void ContentIndex::print() const
+{
+    uint64_t bytes = 0;
+    for (const auto& dup : m_duplicates)
+    {
+        bytes += dup.size;
+    }
+    spdlog::info("{} identical file(s) processed once, {} bytes not parsed again", m_duplicates.size(), bytes);
+}
+
+nlohmann::ordered_json ContentIndex::to_json() const
+{
+    nlohmann::ordered_json js = nlohmann::ordered_json::value_t::object;
+    js["mode"] = m_mode == EMode::Link ? "link" : "copy";
+    js["files"] = nlohmann::ordered_json::value_t::array;
+    uint64_t bytes = 0;
+    for (const auto& dup : m_duplicates)
+    {
+        bytes += dup.size;
+        js["files"].push_back({ { "file", dup.file.string() }, { "same_as", dup.owner.string() } });
+    }
+    js["duplicates"] = m_duplicates.size();
+    js["bytes"] = bytes;
+    return js;
+}
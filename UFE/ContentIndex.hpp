@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Finds byte identical files among the ones read in a directory run. The first
+// file with some content owns it and is processed, later copies are only
+// recorded and get the owner's outputs once the run is done. Contents are keyed
+// by size and hash, a hash match is confirmed against the owner file on disk.
+class ContentIndex
+{
+public:
+    enum class EMode
+    {
+        Off,
+        Copy,
+        Link
+    };
+    struct Duplicate
+    {
+        std::filesystem::path file;
+        std::filesystem::path owner;
+        uint64_t size = 0;
+    };
+    // how an owner was processed, its copies are reported and exported from it
+    struct Outcome
+    {
+        bool validated = false;     // validated and re-serialized without differences
+        std::string status;         // validation status otherwise
+        std::filesystem::path json; // export written, empty if none
+    };
+
+    explicit ContentIndex(EMode mode) : m_mode{ mode } {}
+    // "off", "copy" or "link", anything else is off
+    static EMode mode_from_str(std::string_view mode);
+    EMode mode() const noexcept { return m_mode; }
+
+    // false if content belongs to a file claimed before, file is then recorded as its copy
+    bool claim(const std::filesystem::path& file, std::string_view content);
+
+    // recorded once a claimed file is done, owners without one weren't processed
+    void finish(const std::filesystem::path& file, Outcome outcome);
+
+    // copies or hard links owner json exports next to their copies, logs validation of copies
+    void apply(bool exported, bool validated) const;
+    const std::vector<Duplicate>& duplicates() const noexcept { return m_duplicates; }
+    void print() const;
+    nlohmann::ordered_json to_json() const;
+private:
+    static bool same_content(const std::filesystem::path& file, std::string_view content);
+
+    EMode m_mode;
+    std::mutex m_mutex;
+    // size and content hash to files owning that content
+    struct Key
+    {
+        uint64_t size;
+        size_t hash;
+        bool operator==(const Key&) const = default;
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const noexcept { return key.hash ^ (key.size * 0x9e3779b97f4a7c15ull); }
+    };
+    std::unordered_map<Key, std::vector<std::filesystem::path>, KeyHash> m_owners;
+    std::vector<Duplicate> m_duplicates;
+    std::map<std::filesystem::path, Outcome> m_outcomes;
+};
@@ -0,0 +1,197 @@
+#include "Diff.hpp"
+#include <algorithm>
+#include <map>
+#include <spdlog/spdlog.h>
+#include "FileRoots.hpp"
+#include "Pipeline.hpp"
+#include "Report.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::string_view status_str(Diff::EStatus status)
+    {
+        switch (status)
+        {
+            case Diff::EStatus::Identical: return "identical";
+            case Diff::EStatus::Changed: return "changed";
+            case Diff::EStatus::Added: return "added";
+            case Diff::EStatus::Removed: return "removed";
+            case Diff::EStatus::Invalid:
+            default:
+                return "invalid";
+        }
+    }
+
+    std::string_view change_str(MerkleTree::Change::EType type)
+    {
+        switch (type)
+        {
+            case MerkleTree::Change::EType::Added: return "added";
+            case MerkleTree::Change::EType::Removed: return "removed";
+            case MerkleTree::Change::EType::Changed:
+            default:
+                return "changed";
+        }
+    }
+}
+
+bool Diff::run(const fs::path& old_root, const fs::path& new_root, size_t threads)
+{
+    m_files.clear();
+    // pairs of old and new file, empty for added and removed files
+    std::vector<std::pair<fs::path, fs::path>> pairs;
+    const auto kind = root_kind({ old_root, new_root });
+    if (!kind)
+    {
+        return false;
+    }
+    if (*kind == ERootKind::Files)
+    {
+        pairs.emplace_back(old_root, new_root);
+        m_files.emplace_back().file = new_root.filename();
+    }
+    else
+    {
+        auto old_files = supported_files(old_root);
+        auto new_files = supported_files(new_root);
+        for (auto& [relative, file] : old_files)
+        {
+            const auto it = new_files.find(relative);
+            pairs.emplace_back(file, it != new_files.end() ? it->second : fs::path{});
+            m_files.emplace_back().file = relative;
+        }
+        for (auto& [relative, file] : new_files)
+        {
+            if (!old_files.contains(relative))
+            {
+                pairs.emplace_back(fs::path{}, file);
+                m_files.emplace_back().file = relative;
+            }
+        }
+    }
+
+    parallel_for(pairs.size(), threads, [&](size_t i) { compare(pairs[i].first, pairs[i].second, m_files[i]); });
+    // report in path order, added files were appended last
+    std::stable_sort(m_files.begin(), m_files.end(), [](const FileDiff& a, const FileDiff& b) { return a.file < b.file; });
+    return true;
+}
+
+void Diff::compare(const fs::path& old_file, const fs::path& new_file, FileDiff& result)
+{
+    if (old_file.empty() || new_file.empty())
+    {
+        result.status = old_file.empty() ? EStatus::Added : EStatus::Removed;
+        return;
+    }
+    MerkleTree old_tree;
+    MerkleTree new_tree;
+    if (!old_tree.open(old_file) || !new_tree.open(new_file))
+    {
+        result.status = EStatus::Invalid;
+        return;
+    }
+    if (old_tree.stream() == new_tree.stream())
+    {
+        result.status = EStatus::Identical;
+        return;
+    }
+    result.parsed = true;
+    if (!old_tree.build() || !new_tree.build())
+    {
+        spdlog::warn("File '{}' can't be compared, parsing failed", result.file.string());
+        result.status = EStatus::Invalid;
+        return;
+    }
+    result.nodes = old_tree.nodes().size() + new_tree.nodes().size();
+    result.changes = MerkleTree::diff(old_tree, new_tree, &result.visited);
+    result.status = result.changes.empty() ? EStatus::Identical : EStatus::Changed;
+}
+
+void Diff::print() const
+{
+    size_t counts[5] = {};
+    size_t parsed = 0;
+    uint64_t changes = 0;
+    uint64_t nodes = 0;
+    uint64_t visited = 0;
+    for (const auto& file : m_files)
+    {
+        ++counts[static_cast<size_t>(file.status)];
+        parsed += file.parsed;
+        changes += file.changes.size();
+        nodes += file.nodes;
+        visited += file.visited;
+        switch (file.status)
+        {
+            case EStatus::Changed:
+                spdlog::info("Changed '{}', {} members", file.file.string(), file.changes.size());
+                for (const auto& change : file.changes)
+                {
+                    if (change.type == MerkleTree::Change::EType::Added)
+                    {
+                        spdlog::info("  + {}: {}", change.path, change.new_value.dump());
+                    }
+                    else if (change.type == MerkleTree::Change::EType::Removed)
+                    {
+                        spdlog::info("  - {}: {}", change.path, change.old_value.dump());
+                    }
+                    else
+                    {
+                        spdlog::info("  ~ {}: {} -> {}", change.path, change.old_value.dump(), change.new_value.dump());
+                    }
+                }
+                break;
+            case EStatus::Added:
+                spdlog::info("Added '{}'", file.file.string());
+                break;
+            case EStatus::Removed:
+                spdlog::info("Removed '{}'", file.file.string());
+                break;
+            case EStatus::Invalid:
+                spdlog::warn("Invalid '{}'", file.file.string());
+                break;
+            case EStatus::Identical:
+            default:
+                spdlog::debug("Identical '{}'", file.file.string());
+                break;
+        }
+    }
+    spdlog::info("Compared {} files: {} identical, {} changed, {} added, {} removed, {} invalid", m_files.size(),
+        counts[0], counts[1], counts[2], counts[3], counts[4]);
+    spdlog::info("{} member changes, {} files parsed, {} of {} nodes compared", changes, parsed, visited, nodes);
+}
+
+nlohmann::ordered_json Diff::to_json() const
+{
+    nlohmann::ordered_json js;
+    js["files"] = nlohmann::ordered_json::value_t::array;
+    for (const auto& file : m_files)
+    {
+        if (file.status == EStatus::Identical)
+        {
+            continue;
+        }
+        nlohmann::ordered_json entry;
+        entry["file"] = file.file.generic_string();
+        entry["status"] = status_str(file.status);
+        if (!file.changes.empty())
+        {
+            auto& changes = entry["changes"] = nlohmann::ordered_json::value_t::array;
+            for (const auto& change : file.changes)
+            {
+                changes.push_back({ { "type", change_str(change.type) }, { "path", change.path },
+                    { "old", change.old_value }, { "new", change.new_value } });
+            }
+        }
+        js["files"].push_back(std::move(entry));
+    }
+    js["compared"] = m_files.size();
+    return js;
+}
+
+bool Diff::save_json(const fs::path& json_path) const
+{
+    return save_report(json_path, to_json(), "Diff report");
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "MerkleTree.hpp"
+
+// Changes between two versions of a file or a directory tree. Files are paired
+// by their path relative to the compared roots, byte identical streams are not
+// parsed at all and parsed pairs only descend into subtrees whose hashes differ.
+class Diff
+{
+public:
+    enum class EStatus
+    {
+        Identical,
+        Changed,
+        Added,
+        Removed,
+        Invalid
+    };
+    struct FileDiff
+    {
+        std::filesystem::path file; // relative to the compared roots
+        EStatus status = EStatus::Identical;
+        bool parsed = false;
+        uint64_t nodes = 0;   // nodes of both trees
+        uint64_t visited = 0; // nodes compared
+        std::vector<MerkleTree::Change> changes;
+    };
+
+    // old_root and new_root are both files or both directories
+    bool run(const std::filesystem::path& old_root, const std::filesystem::path& new_root, size_t threads);
+    const std::vector<FileDiff>& files() const noexcept { return m_files; }
+
+    // changed members of every changed file and totals, logged at info level
+    void print() const;
+    nlohmann::ordered_json to_json() const;
+    bool save_json(const std::filesystem::path& json_path) const;
+private:
+    static void compare(const std::filesystem::path& old_file, const std::filesystem::path& new_file, FileDiff& result);
+
+    std::vector<FileDiff> m_files;
+};
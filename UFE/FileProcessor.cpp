@@ -0,0 +1,158 @@
+#include "FileProcessor.hpp"
+#include <algorithm>
+#include "BinaryFileWriter.hpp"
+#include "JsonReader.hpp"
+#include "JsonWriter.hpp"
+#include "Patch.hpp"
+
+std::string_view EFileStatus2str(BinaryFileParser::EFileStatus status)
+{
+    switch (status)
+    {
+        case BinaryFileParser::EFileStatus::Empty:
+            return "empty";
+        case BinaryFileParser::EFileStatus::PartialRead:
+            return "partial read";
+        case BinaryFileParser::EFileStatus::FullRead:
+            return "validated";
+        case BinaryFileParser::EFileStatus::Invalid:
+        default:
+            return "invalid";
+    }
+}
+
+bool validate_round_trip(const fs::path& p, const BinaryFileParser& parser, FileStats* stats)
+{
+    BinaryFileWriter writer;
+    writer.set_stats(stats);
+    std::string stream;
+    const auto raw_data = parser.raw_data();
+    if (writer.serialize(parser.get_records(), stream))
+    {
+        const auto [it_raw, it_stream] = std::mismatch(raw_data.cbegin(), raw_data.cend(), stream.cbegin(), stream.cend());
+        if (it_raw == raw_data.cend() && it_stream == stream.cend())
+        {
+            spdlog::debug("File '{}' re-serialized without differences", p.string());
+            return true;
+        }
+        spdlog::warn("File '{}' re-serialized stream differs at offset {} (original {} bytes, written {} bytes)",
+            p.string(), std::distance(raw_data.cbegin(), it_raw), raw_data.size(), stream.size());
+        return false;
+    }
+    spdlog::warn("File '{}' record tree can't be re-serialized", p.string());
+    return false;
+}
+
+namespace
+{
+    // '<file>.ufepatch' with the members of '<file>.json' that differ from the binary
+    bool make_patch(const fs::path& p, const fs::path& json_path, const fs::path& patch_path, const BinaryFileParser& parser)
+    {
+        MerkleTree tree;
+        tree.build(parser.get_records());
+        Patch patch;
+        if (!patch.load_json(tree, json_path) || !patch.save(patch_path))
+        {
+            return false;
+        }
+        spdlog::info("Patch '{}' of '{}' saved, {} members", patch_path.string(), p.string(), patch.edits().size());
+        return true;
+    }
+}
+
+ProcessResult process_records(const fs::path& p, BinaryFileParser& parser, const ProcessOptions& options, FileStats* pstats,
+    std::ostream* json_buffer)
+{
+    ProcessResult result;
+    fs::path json_path = p;
+    json_path += ".json";
+    // records are exported as they are parsed, only patching and validation need the whole tree
+    JsonWriter writer;
+    writer.set_stats(pstats);
+    bool exporting = false;
+    parser.read_records([&](const std::any& record)
+        {
+            if (options.export_json)
+            {
+                if (!exporting)
+                {
+                    if (json_buffer)
+                    {
+                        writer.begin(*json_buffer);
+                        exporting = true;
+                    }
+                    else
+                    {
+                        exporting = writer.begin(json_path);
+                    }
+                }
+                if (exporting)
+                {
+                    writer.add(record);
+                }
+            }
+        }, options.patch || options.validate || options.make_patch);
+    if (exporting)
+    {
+        writer.end();
+    }
+
+    if (parser.status() != BinaryFileParser::EFileStatus::Invalid &&
+        parser.status() != BinaryFileParser::EFileStatus::Empty)
+    {
+        //reader.export_json(json_path);
+        if (parser.status() == BinaryFileParser::EFileStatus::PartialRead)
+        {
+            spdlog::warn("Partial file read!");
+            //continue;
+        }
+
+        fs::path patch_path = p;
+        patch_path += ".ufepatch";
+        if (options.make_patch)
+        {
+            make_patch(p, json_path, patch_path, parser);
+        }
+        if (options.patch && Patch::use_patch(json_path, patch_path))
+        {
+            Patch patch;
+            result.patched = patch.load(patch_path) && patch.apply(p, parser, pstats).ok;
+        }
+        else if (options.patch)
+        {
+            JsonReader reader;
+            reader.set_stats(pstats);
+            result.patched = reader.patch(json_path, p, parser);
+        }
+    }
+
+    if (options.validate)
+    {
+        if (parser.status() != BinaryFileParser::EFileStatus::Invalid &&
+            parser.status() != BinaryFileParser::EFileStatus::Empty)
+        {
+            if (parser.file_type() == BinaryFileParser::EFileType::Compressed)
+            {
+                spdlog::info("File '{}' is compressed, validation status '{}'", p.string(), EFileStatus2str(parser.status()));
+            }
+            else if (parser.file_type() == BinaryFileParser::EFileType::Uncompressed)
+            {
+                spdlog::info("File '{}' is uncompressed, validation status '{}'", p.string(), EFileStatus2str(parser.status()));
+            }
+            else
+            {
+                spdlog::info("File '{}' is raw, validation status '{}'", p.string(), EFileStatus2str(parser.status()));
+            }
+            if (parser.status() == BinaryFileParser::EFileStatus::FullRead)
+            {
+                result.round_trip = validate_round_trip(p, parser, pstats);
+            }
+        }
+        else
+        {
+            spdlog::trace("File '{}' not supported");
+        }
+    }
+    result.exported = exporting;
+    return result;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <filesystem>
+#include <ostream>
+#include <string_view>
+#include "BinaryFileParser.hpp"
+#include "Stats.hpp"
+
+// Per file work shared by the command line tool and libufe, after the file was
+// opened by a BinaryFileParser.
+struct ProcessOptions
+{
+    bool export_json = false;
+    bool patch = false;
+    bool validate = false;
+    bool make_patch = false; // '<file>.ufepatch' from the edited '<file>.json'
+};
+
+struct ProcessResult
+{
+    bool exported = false;   // at least one record was exported
+    bool patched = false;
+    bool round_trip = false; // validated and re-serialized without differences
+};
+
+std::string_view EFileStatus2str(BinaryFileParser::EFileStatus status);
+
+// re-serialized record tree must match decoded stream byte for byte
+bool validate_round_trip(const std::filesystem::path& p, const BinaryFileParser& parser, FileStats* stats);
+
+// exports, patches and validates an opened file, patching prefers a '<file>.ufepatch'
+// that isn't older than '<file>.json', json goes to json_buffer instead of
+// the '<file>.json' file next to it when given
+ProcessResult process_records(const std::filesystem::path& p, BinaryFileParser& parser, const ProcessOptions& options,
+    FileStats* pstats, std::ostream* json_buffer);
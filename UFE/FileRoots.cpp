@@ -0,0 +1,56 @@
+#include "FileRoots.hpp"
+#include "Triage.hpp"
+#include <algorithm>
+#include <string>
+#include <spdlog/spdlog.h>
+
+namespace fs = std::filesystem;
+
+std::optional<ERootKind> root_kind(const std::vector<fs::path>& roots)
+{
+    auto all = [&](auto&& is_kind) { return std::all_of(roots.begin(), roots.end(), [&](const fs::path& p) { return is_kind(p); }); };
+    if (!roots.empty() && all([](const fs::path& p) { return fs::is_regular_file(p); }))
+    {
+        return ERootKind::Files;
+    }
+    if (!roots.empty() && all([](const fs::path& p) { return fs::is_directory(p); }))
+    {
+        return ERootKind::Directories;
+    }
+    std::string names;
+    for (const auto& root : roots)
+    {
+        names += names.empty() ? "'" : ", '";
+        names += root.string() + "'";
+    }
+    spdlog::error("{} have to be all files or all directories", names);
+    return std::nullopt;
+}
+
+std::map<fs::path, fs::path> supported_files(const fs::path& root)
+{
+    std::map<fs::path, fs::path> files;
+    for (auto& entry : Triage::scan(root))
+    {
+        if (entry.type != TriageEntry::EType::Unsupported)
+        {
+            auto relative = entry.file.lexically_relative(root);
+            files.emplace(std::move(relative), std::move(entry.file));
+        }
+    }
+    return files;
+}
+
+std::map<fs::path, fs::path> edit_files(const fs::path& root, const std::vector<std::string_view>& extensions)
+{
+    std::map<fs::path, fs::path> files;
+    for (const auto& entry : fs::recursive_directory_iterator{ root })
+    {
+        const auto extension = entry.path().extension().string();
+        if (entry.is_regular_file() && std::find(extensions.begin(), extensions.end(), extension) != extensions.end())
+        {
+            files.emplace(entry.path().lexically_relative(root).replace_extension(), entry.path());
+        }
+    }
+    return files;
+}
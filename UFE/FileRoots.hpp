@@ -0,0 +1,25 @@
+#pragma once
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Inputs of commands working on several versions or layers of the same files:
+// either every root is a single file, or every root is a directory and files
+// pair up by their path relative to the root.
+enum class ERootKind
+{
+    Files,
+    Directories
+};
+
+// kind shared by all roots, an error naming the roots is logged otherwise
+std::optional<ERootKind> root_kind(const std::vector<std::filesystem::path>& roots);
+// supported files under root by their path relative to root
+std::map<std::filesystem::path, std::filesystem::path> supported_files(const std::filesystem::path& root);
+// files with one of extensions under root by the path of the binary they edit
+// relative to root, 'items/a.item' for 'items/a.item.json'; a binary edited by
+// several files maps to one of them
+std::map<std::filesystem::path, std::filesystem::path> edit_files(const std::filesystem::path& root,
+    const std::vector<std::string_view>& extensions);
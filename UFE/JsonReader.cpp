@@ -1,9 +1,12 @@
 #include "JsonReader.hpp"
-#include <gzip\compress.hpp>
+#include <gzip/compress.hpp>
+#include <algorithm>
+#include <mutex>
 JsonReader::JsonReader()
 {
-    // assign all callbacks once per run
-    if (m_any_visitor.empty())
+    // assign all callbacks once per run, readers may be created on several threads
+    static std::once_flag registered;
+    std::call_once(registered, [this]
     {
         //register_any_visitor<ufe::ClassWithMembersAndTypes>( &JsonWriter::class_with_members_and_types);
          //m_any_visitor.insert(std::make_pair(std::type_index(typeid(ufe::ClassWithMembersAndTypes)),
@@ -35,7 +38,7 @@ JsonReader::JsonReader()
         register_any_visitor<IndexedData<float>>(&JsonReader::value_float);
         register_any_visitor<IndexedData<double>>(&JsonReader::value_double);
         //register_any_visitor<>(&JsonReader::);
-    }
+    });
     // init json
     m_json =
     {
@@ -49,7 +52,7 @@ bool JsonReader::patch(std::filesystem::path json_path, std::filesystem::path bi
 {
     if (parser.status() == BinaryFileParser::EFileStatus::Invalid || parser.status() == BinaryFileParser::EFileStatus::Empty)
     {
-        spdlog::warn("File '{}' not valid for patching");
+        spdlog::warn("File '{}' not valid for patching", binary_path.string());
         return false;
     }
 
@@ -57,60 +60,98 @@ bool JsonReader::patch(std::filesystem::path json_path, std::filesystem::path bi
     {
         if (std::filesystem::exists(binary_path) && std::filesystem::is_regular_file(binary_path))
         {
-            m_raw_data = parser.raw_data();
             std::ifstream json{ json_path };
             spdlog::info("Patching file '{}'", binary_path.string());
             spdlog::info("with json file '{}'", json_path.string());
             try
             {
+                StageTimer patch_timer{ m_stats, EStage::Patch };
                 json >> m_json;
-                process_records(parser.get_records());
-                update_strings();
+            }
+            catch (std::exception& e)
+            {
+                spdlog::critical("Failed to parse json file: {}", e.what());
+                return false;
+            }
+            return write_patched(binary_path, parser);
+        }
 
+    }
+    return false;
+}
 
-                std::ofstream bin{ binary_path, std::ios::binary };
-                if (bin)
+bool JsonReader::patch(const nlohmann::ordered_json& json, std::filesystem::path binary_path, const BinaryFileParser& parser)
+{
+    if (parser.status() == BinaryFileParser::EFileStatus::Invalid || parser.status() == BinaryFileParser::EFileStatus::Empty)
+    {
+        spdlog::warn("File '{}' not valid for patching", binary_path.string());
+        return false;
+    }
+    spdlog::info("Patching file '{}'", binary_path.string());
+    m_json = json;
+    return write_patched(binary_path, parser);
+}
+
+bool JsonReader::write_patched(const std::filesystem::path& binary_path, const BinaryFileParser& parser)
+{
+    m_raw_data = parser.raw_data();
+    try
+    {
+        StageTimer patch_timer{ m_stats, EStage::Patch };
+        process_records(parser.get_records());
+        update_strings();
+        patch_timer.stop();
+
+        std::ofstream bin{ binary_path, std::ios::binary };
+        if (bin)
+        {
+            if (parser.file_type() == BinaryFileParser::EFileType::Compressed)
+            {
+                std::string compressed_data;
+                try
+                {
+                    StageTimer timer{ m_stats, EStage::Deflate };
+                    compressed_data = gzip::compress(m_raw_data.data(), m_raw_data.size(), Z_DEFAULT_COMPRESSION);
+                }
+                catch (std::exception& e)
                 {
-                    if (parser.file_type() == BinaryFileParser::EFileType::Compressed)
-                    {
-                        std::string compressed_data;
-                        try
-                        {
-                            compressed_data = gzip::compress(m_raw_data.data(), m_raw_data.size(), Z_DEFAULT_COMPRESSION);
-                        }
-                        catch (std::exception& e)
-                        {
-                            spdlog::critical("Failed to compress file: {}", e.what());
-                            return false;
-                        }
-                        auto compressed_header = parser.header();
-                        bin.write(compressed_header.data(), compressed_header.size());
-                        bin.write(compressed_data.data(), compressed_data.size());
-                    }
-                    else if (parser.file_type() == BinaryFileParser::EFileType::Uncompressed)
-                    {
-                        auto header = parser.header();
-                        bin.write(header.data(), header.size());
-                        bin.write(m_raw_data.data(), m_raw_data.size());
-                    }
-                    else
-                    {
-                        bin.write(m_raw_data.data(), m_raw_data.size());
-                    }
+                    spdlog::critical("Failed to compress file: {}", e.what());
+                    return false;
                 }
+                StageTimer timer{ m_stats, EStage::BinaryWrite };
+                auto compressed_header = parser.header();
+                bin.write(compressed_header.data(), compressed_header.size());
+                bin.write(compressed_data.data(), compressed_data.size());
             }
-            catch (std::exception& e)
+            else if (parser.file_type() == BinaryFileParser::EFileType::Uncompressed)
             {
-                spdlog::critical("Failed to parse json file: {}", e.what());
+                StageTimer timer{ m_stats, EStage::BinaryWrite };
+                auto header = parser.header();
+                bin.write(header.data(), header.size());
+                bin.write(m_raw_data.data(), m_raw_data.size());
+            }
+            else
+            {
+                StageTimer timer{ m_stats, EStage::BinaryWrite };
+                bin.write(m_raw_data.data(), m_raw_data.size());
             }
+            if (m_stats)
+            {
+                m_stats->bytes_out += static_cast<uint64_t>(bin.tellp());
+            }
+            return static_cast<bool>(bin);
         }
-
+        spdlog::error("Could not write '{}'", binary_path.string());
+    }
+    catch (std::exception& e)
+    {
+        spdlog::critical("Failed to patch file: {}", e.what());
     }
     return false;
 }
 
 std::unordered_map<
-    std::type_index, std::function<void(std::any const&, const ojson&)>> JsonReader::m_any_visitor;
+    std::type_index, std::function<void(JsonReader&, std::any const&, const ojson&)>> JsonReader::m_any_visitor;
 
 bool JsonReader::process_records(const std::vector<std::any>& records)
 {
@@ -179,21 +220,11 @@ void JsonReader::class_with_members_and_types(const ufe::ClassWithMembersAndType
     if (!cls.is_null())
     {
         const auto& members = cls["members"];
-        auto it_member_names = cmt.m_ClassInfo.MemberNames.cbegin();
         spdlog::debug("Processing class '{}' with id {}", cmt.m_ClassInfo.Name.value.string, cmt.m_ClassInfo.ObjectId.value);
         // check if class name was updated
         process_string(cmt.m_ClassInfo.Name, cls["name"]);
 
-        for (const auto& rec : cmt.m_MemberTypeInfo.Data)
-        {
-            
-            if (json_elem(members, it_member_names->value.string))
-            {
-                spdlog::debug(it_member_names->value.string);
-                process(rec, members[it_member_names->value.string]);
-            }
-            ++it_member_names;
-        }
+        process_class_members(members, cmt.m_ClassInfo, cmt.m_MemberTypeInfo);
         spdlog::debug("Done class {}", cmt.m_ClassInfo.ObjectId.value);
     }
     else
@@ -208,18 +239,8 @@ void JsonReader::class_with_id(const ufe::ClassWithId& cwi, const ojson& ctx)
     if (!cls.is_null())
     {
         const auto& members = cls["members"];
-        auto it_member_names = cwi.m_ClassInfo.MemberNames.cbegin();
         spdlog::debug("Processing class_id '{}' with id {}", cwi.m_ClassInfo.Name.value.string, cwi.m_ClassInfo.ObjectId.value);
-        for (const auto& rec : cwi.m_MemberTypeInfo.Data)
-        {
-
-            if (json_elem(members, it_member_names->value.string))
-            {
-                spdlog::debug(it_member_names->value.string);
-                process(rec, members[it_member_names->value.string]);
-            }
-            ++it_member_names;
-        }
+        process_class_members(members, cwi.m_ClassInfo, cwi.m_MemberTypeInfo);
         spdlog::debug("Done class_id {}", cwi.m_ClassInfo.ObjectId.value);
     }
     else
@@ -228,6 +249,46 @@ void JsonReader::class_with_id(const ufe::ClassWithId& cwi, const ojson& ctx)
     }
 }
 
+void JsonReader::process_class_members(const ojson& members, const ufe::ClassInfo& ci, const ufe::MemberTypeInfo& mti)
+{
+    // json keys are interned once, record members are then matched by id, usually at the same position
+    std::vector<std::pair<StringInterner::Id, const ojson*>> json_members;
+    if (members.is_object())
+    {
+        json_members.reserve(members.size());
+        for (auto it = members.cbegin(); it != members.cend(); ++it)
+        {
+            json_members.emplace_back(StringInterner::intern(it.key()), &it.value());
+        }
+    }
+    auto it_member_names = ci.MemberNameIds.cbegin();
+    size_t pos = 0;
+    for (const auto& rec : mti.Data)
+    {
+        const ojson* value = nullptr;
+        if (pos < json_members.size() && json_members[pos].first == *it_member_names)
+        {
+            value = json_members[pos].second;
+        }
+        else
+        {
+            auto it = std::find_if(json_members.cbegin(), json_members.cend(), [id = *it_member_names](const auto& m) { return m.first == id; });
+            value = it != json_members.cend() ? it->second : nullptr;
+        }
+        if (value)
+        {
+            spdlog::debug(StringInterner::str(*it_member_names));
+            process(rec, *value);
+        }
+        else
+        {
+            spdlog::warn("current json object doesn't contain element {}", StringInterner::str(*it_member_names));
+        }
+        ++it_member_names;
+        ++pos;
+    }
+}
+
 void JsonReader::array_single_string(const ufe::ArraySingleString& arr, const ojson& ctx)
 {
     const auto& values = find_array_by_id(ctx, arr.ObjectId);
@@ -332,7 +393,7 @@ void JsonReader::process(const std::any& a, const ojson& context)
 {
     if (const auto it = m_any_visitor.find(std::type_index(a.type()));
         it != m_any_visitor.cend()) {
-        it->second(a, context);
+        it->second(*this, a, context);
     }
     else {
         spdlog::error("JsonReader unregistered type: {}", a.type().name());
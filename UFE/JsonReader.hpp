@@ -16,6 +16,10 @@ class JsonReader
 public:
     JsonReader();
     bool patch(std::filesystem::path json_path, std::filesystem::path binary_path, const BinaryFileParser& parser);
+    // same with an export document held in memory
+    bool patch(const nlohmann::ordered_json& json, std::filesystem::path binary_path, const BinaryFileParser& parser);
+    // optional per-file timings and counters, not owned
+    void set_stats(FileStats* stats) noexcept { m_stats = stats; }
 private:
 
     template<class T, class F>
@@ -31,27 +35,18 @@ private:
         //        return std::bind(f, this, std::any_cast<T const&>(a));
         //    }
         //));
-        m_any_visitor[std::type_index(typeid(T))] = [this, f](std::any const& a, const ojson& context) -> void {
+        // map is shared by all readers, the reader is passed in instead of captured
+        m_any_visitor[std::type_index(typeid(T))] = [f](JsonReader& self, std::any const& a, const ojson& context) -> void {
             if (std::is_fundamental_v<T>)
             {
-                std::bind(f, this, std::any_cast<T>(a), std::cref(context))();
+                std::bind(f, &self, std::any_cast<T>(a), std::cref(context))();
             }
             else
             {
-                std::bind(f, this, std::cref(std::any_cast<T const&>(a)), std::cref(context))();
+                std::bind(f, &self, std::cref(std::any_cast<T const&>(a)), std::cref(context))();
             }
         };
     }
-    bool json_elem(const nlohmann::ordered_json& json, const std::string& name)
-    {
-        if (json.contains(name))
-        {
-            return true;
-        }
-        spdlog::warn("current json object doesn't contain element {}", name);
-        return false;
-    }
-
     template <typename T>
     void process_member(const IndexedData<T>& data, const ojson& ctx)
     {
@@ -80,13 +75,15 @@ private:
         }
     }
 
+    // applies m_json to the raw data of parser and writes binary_path
+    bool write_patched(const std::filesystem::path& binary_path, const BinaryFileParser& parser);
     bool process_records(const std::vector<std::any>& records);
     void update_strings();
 
 
     const ojson& find_class_by_id(const ojson& ctx, const ufe::ClassInfo& ci, std::string class_type);
     const ojson& find_array_by_id(const ojson& ctx, int32_t arr_id);
-    void process_class_members(nlohmann::ordered_json& members, const  ufe::ClassInfo& ci, const  ufe::MemberTypeInfo& mti);
+    void process_class_members(const ojson& members, const ufe::ClassInfo& ci, const ufe::MemberTypeInfo& mti);
 
     void member_reference(const ufe::MemberReference& mref, const ojson& ctx) { /* do nothing */ }
     void header(const ufe::SerializationHeaderRecord& mref, const ojson& ctx) { /* do nothing */ }
@@ -116,12 +113,13 @@ private:
     void object_null(ufe::ObjectNull, const ojson& ctx) { /* do nothing */ }
     void object_null_256(ufe::ObjectNullMultiple256 obj, const ojson& ctx) { /* do nothing */ }
     static std::unordered_map<
-        std::type_index, std::function<void(std::any const&, const ojson& context)>>
+        std::type_index, std::function<void(JsonReader&, std::any const&, const ojson& context)>>
         m_any_visitor;
     void process(const std::any& a, const ojson& context);
     nlohmann::ordered_json m_json;
     std::vector<char> m_raw_data;
     bool m_stop_parsing = false;
     std::vector <IndexedData<ufe::LengthPrefixedString>> m_updated_strings;
+    FileStats* m_stats = nullptr;
 };
 
@@ -1,4 +1,5 @@
 #include "JsonWriter.hpp"
+#include <mutex>
 
 nlohmann::ordered_json test(int x)
 {
@@ -7,8 +8,9 @@ nlohmann::ordered_json test(int x)
 
 JsonWriter::JsonWriter()
 {
-    // assign all callbacks
-    if (m_any_visitor.empty())
+    // assign all callbacks once per run, writers may be created on several threads
+    static std::once_flag registered;
+    std::call_once(registered, [this]
     {
        //register_any_visitor<ufe::ClassWithMembersAndTypes>( &JsonWriter::class_with_members_and_types);
         //m_any_visitor.insert(std::make_pair(std::type_index(typeid(ufe::ClassWithMembersAndTypes)),
@@ -37,49 +39,108 @@ JsonWriter::JsonWriter()
         register_any_visitor<IndexedData<float>>(&JsonWriter::value_float);
         register_any_visitor<IndexedData<double>>(&JsonWriter::value_double);
         //register_any_visitor<>(&JsonWriter::);
-    }
-    // init json
-    m_json =
+    });
+}
+
+bool JsonWriter::save(std::filesystem::path json_path, const std::vector<std::any>& records)
+{
+    if (begin(json_path))
     {
+        for (const auto& rec : records)
         {
-            "records", {}
+            add(rec);
         }
-    };
+        return end();
+    }
+    return false;
 }
 
-bool JsonWriter::save(std::filesystem::path json_path, const std::vector<std::any>& records)
+bool JsonWriter::begin(std::filesystem::path json_path)
 {
-    std::ofstream out_json{ json_path };
-    if (out_json)
+    // a json hard linked by --dedup link is replaced, not written through to the other names
+    std::error_code ec;
+    std::filesystem::remove(json_path, ec);
+    m_file.open(json_path);
+    if (m_file)
     {
-        spdlog::debug("Parsing records into json");
-        process_records(records);
         spdlog::info("Exporting data to '{}'", json_path.string());
-        out_json << std::setw(4) << m_json;
+        begin(m_file);
         return true;
     }
     spdlog::error("Could not save '{}'", json_path.string());
     return false;
 }
 
-bool JsonWriter::process_records(const std::vector<std::any>& records)
+void JsonWriter::begin(std::ostream& out)
+{
+    m_out = &out;
+    m_records_written = 0;
+}
+
+void JsonWriter::add(const std::any& record)
+{
+    ojson json;
+    {
+        StageTimer timer{ m_stats, EStage::JsonBuild, false };
+        json = process(record);
+    }
+    if (json.empty())
+    {
+        return;
+    }
+    StageTimer timer{ m_stats, EStage::JsonWrite, false };
+    auto& out = *m_out;
+    // same text as dumping the whole document with indent 4, records sit two levels deep
+    out << (m_records_written++ ? ",\n" : "{\n    \"records\": [\n");
+    const auto text = json.dump(4);
+    size_t line_start = 0;
+    while (line_start < text.size())
+    {
+        auto line_end = text.find('\n', line_start);
+        line_end = line_end == std::string::npos ? text.size() : line_end + 1;
+        out << "        ";
+        out.write(text.data() + line_start, line_end - line_start);
+        line_start = line_end;
+    }
+}
+
+bool JsonWriter::end()
+{
+    StageTimer timer{ m_stats, EStage::JsonWrite, false };
+    auto& out = *m_out;
+    out << (m_records_written ? "\n    ]\n}" : "{\n    \"records\": null\n}");
+    if (m_stats)
+    {
+        m_stats->bytes_out += static_cast<uint64_t>(out.tellp());
+    }
+    if (m_file.is_open())
+    {
+        m_file.close();
+        return static_cast<bool>(m_file);
+    }
+    return static_cast<bool>(out);
+}
+
+nlohmann::ordered_json JsonWriter::to_json(const std::vector<std::any>& records)
 {
-    auto& json_records = m_json["records"];
+    StageTimer timer{ m_stats, EStage::JsonBuild };
+    ojson doc = { { "records", nullptr } };
+    auto& json_records = doc["records"];
     for (const auto& rec : records)
     {
         auto json = process(rec);
         if (!json.empty())
         {
-            json_records.push_back(json);
+            json_records.push_back(std::move(json));
         }
     }
-    return false;
+    return doc;
 }
 
 nlohmann::ordered_json JsonWriter::class_with_members_and_types(const ufe::ClassWithMembersAndTypes& cmt)
 {
     nlohmann::ordered_json cls = { {"class", {}} };
-    cls["class"]["name"] = cmt.m_ClassInfo.Name.value.string;
+    cls["class"]["name"] = StringInterner::str(cmt.m_ClassInfo.NameId);
     cls["class"]["id"] = cmt.m_ClassInfo.ObjectId.value;
     cls["class"]["members"] = {};
     spdlog::debug("process class {} with id {}", cmt.m_ClassInfo.Name.value.string, cmt.m_ClassInfo.ObjectId.value);
@@ -89,11 +150,22 @@ nlohmann::ordered_json JsonWriter::class_with_members_and_types(const ufe::Class
 
 void JsonWriter::process_class_members(nlohmann::ordered_json& members, const ufe::ClassInfo& ci, const ufe::MemberTypeInfo& mti)
 {
-    auto it_member_names = ci.MemberNames.cbegin();
+    // interned names are ready made json keys, no temporary string per member
+    auto it_member_names = ci.MemberNameIds.cbegin();
     for (const auto& data : mti.Data)
     {
-        members[it_member_names->value.string] = process(data);
-        spdlog::debug("'{}' : {}", it_member_names->value.string, members[it_member_names->value.string].dump());
+        if (data.type() == std::type_index(typeid(ufe::SkippedValue)))
+        {
+            // not selected by --select
+            ++it_member_names;
+            continue;
+        }
+        auto& member = members[StringInterner::str(*it_member_names)];
+        member = process(data);
+        if (spdlog::should_log(spdlog::level::debug))
+        {
+            spdlog::debug("'{}' : {}", StringInterner::str(*it_member_names), member.dump());
+        }
         ++it_member_names;
     }
 }
@@ -115,7 +187,7 @@ ojson JsonWriter::binary_object_string(const ufe::BinaryObjectString& bos)
 ojson JsonWriter::class_with_id(const ufe::ClassWithId& cwi)
 {
     nlohmann::ordered_json cls = { {"class_id", {}} };
-    cls["class_id"]["name"] = cwi.m_ClassInfo.Name.value.string;
+    cls["class_id"]["name"] = StringInterner::str(cwi.m_ClassInfo.NameId);
     cls["class_id"]["id"] = cwi.m_ClassInfo.ObjectId.value;
     cls["class_id"]["ref_id"] = cwi.MetadataId.value;
     cls["class_id"]["members"] = {};
@@ -156,13 +228,13 @@ ojson JsonWriter::object_null_256(ufe::ObjectNullMultiple256 obj)
 }
 
 std::unordered_map<
-    std::type_index, std::function<nlohmann::ordered_json(std::any const&)>> JsonWriter::m_any_visitor;
+    std::type_index, std::function<nlohmann::ordered_json(JsonWriter&, std::any const&)>> JsonWriter::m_any_visitor;
 
 nlohmann::ordered_json JsonWriter::process(const std::any& a)
 {
     if (const auto it = m_any_visitor.find(std::type_index(a.type()));
         it != m_any_visitor.cend()) {
-        return it->second(a);
+        return it->second(*this, a);
     }
     else {
         if (a.type() != std::type_index(typeid(ufe::SerializationHeaderRecord)) && 
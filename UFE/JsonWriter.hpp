@@ -9,6 +9,7 @@
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 #include "Records.hpp"
+#include "Stats.hpp"
 //#include <gzip/compress.hpp>
 //#include <gzip/config.hpp>
 //#include <gzip/decompress.hpp>
@@ -20,6 +21,16 @@ class JsonWriter
 public:
     JsonWriter();
     bool save(std::filesystem::path json_path, const std::vector<std::any>& records);
+    // streaming export, records are written as they are added and not kept
+    bool begin(std::filesystem::path json_path);
+    // same export into a stream owned by the caller
+    void begin(std::ostream& out);
+    void add(const std::any& record);
+    bool end();
+    // whole export as a document, same content as the saved json file
+    nlohmann::ordered_json to_json(const std::vector<std::any>& records);
+    // optional per-file timings and counters, not owned
+    void set_stats(FileStats* stats) noexcept { m_stats = stats; }
 private:
 
     template<class T, class F>
@@ -35,20 +46,19 @@ private:
         //        return std::bind(f, this, std::any_cast<T const&>(a));
         //    }
         //));
-        m_any_visitor[std::type_index(typeid(T))] = [this, f](std::any const& a) -> nlohmann::ordered_json {
+        // map is shared by all writers, the writer is passed in instead of captured
+        m_any_visitor[std::type_index(typeid(T))] = [f](JsonWriter& self, std::any const& a) -> nlohmann::ordered_json {
             if (std::is_fundamental_v<T>)
             {
-                return std::bind(f, this, std::any_cast<T>(a))();
+                return std::bind(f, &self, std::any_cast<T>(a))();
             }
             else
             {
-                return std::bind(f, this, std::cref(std::any_cast<T const&>(a)))();
+                return std::bind(f, &self, std::cref(std::any_cast<T const&>(a)))();
             }
         };
     }
 
-    bool process_records(const std::vector<std::any>& records);
-
     nlohmann::ordered_json class_with_members_and_types(const ufe::ClassWithMembersAndTypes& cmt);
 
     void process_class_members(nlohmann::ordered_json& members, const  ufe::ClassInfo& ci, const  ufe::MemberTypeInfo& mti);
@@ -73,9 +83,12 @@ private:
     ojson object_null(ufe::ObjectNull) { return ojson(nullptr); }
     ojson object_null_256(ufe::ObjectNullMultiple256 obj);
     static std::unordered_map<
-        std::type_index, std::function<nlohmann::ordered_json(std::any const&)>>
+        std::type_index, std::function<nlohmann::ordered_json(JsonWriter&, std::any const&)>>
         m_any_visitor;
     nlohmann::ordered_json process(const std::any& a);
-    nlohmann::ordered_json m_json;
+    std::ofstream m_file;
+    std::ostream* m_out = &m_file;
+    size_t m_records_written = 0;
+    FileStats* m_stats = nullptr;
 };
 
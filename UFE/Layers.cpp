@@ -0,0 +1,212 @@
+#include "Layers.hpp"
+#include <map>
+#include <unordered_map>
+#include <spdlog/spdlog.h>
+#include "FileRoots.hpp"
+#include "Pipeline.hpp"
+#include "Report.hpp"
+
+namespace fs = std::filesystem;
+using ojson = nlohmann::ordered_json;
+
+namespace
+{
+    // edit file of a layer for the binary at stem, empty if the layer doesn't touch it
+    fs::path edit_file(const fs::path& stem)
+    {
+        auto json_path = stem;
+        json_path += ".json";
+        auto patch_path = stem;
+        patch_path += ".ufepatch";
+        if (Patch::use_patch(json_path, patch_path))
+        {
+            return patch_path;
+        }
+        return fs::is_regular_file(json_path) ? json_path : fs::path{};
+    }
+}
+
+bool Layers::run(const fs::path& root, const std::vector<fs::path>& layers, size_t threads)
+{
+    m_layers = layers;
+    m_files.clear();
+    std::vector<fs::path> roots{ root };
+    roots.insert(roots.end(), layers.begin(), layers.end());
+    const auto kind = root_kind(roots);
+    if (!kind)
+    {
+        return false;
+    }
+    if (*kind == ERootKind::Files)
+    {
+        auto& file = m_files.emplace_back();
+        file.file = root;
+        for (size_t i = 0; i < layers.size(); ++i)
+        {
+            file.sources.emplace_back(i, layers[i]);
+        }
+    }
+    else
+    {
+        // layers touching each binary, by relative binary path
+        std::map<fs::path, std::vector<size_t>> binaries;
+        for (size_t i = 0; i < layers.size(); ++i)
+        {
+            for (const auto& edit : edit_files(layers[i], { ".json", ".ufepatch" }))
+            {
+                binaries[edit.first].push_back(i);
+            }
+        }
+        for (const auto& [relative, touching] : binaries)
+        {
+            if (!fs::is_regular_file(root / relative))
+            {
+                spdlog::warn("Layers have edits of '{}' which is not in '{}'", relative.string(), root.string());
+                continue;
+            }
+            auto& file = m_files.emplace_back();
+            file.file = root / relative;
+            for (const auto i : touching)
+            {
+                file.sources.emplace_back(i, edit_file(layers[i] / relative));
+            }
+        }
+    }
+
+    parallel_for(m_files.size(), threads, [&](size_t i) { apply(m_files[i]); });
+    return true;
+}
+
+void Layers::apply(FileLayers& file)
+{
+    MerkleTree tree;
+    if (!tree.open(file.file) || !tree.build())
+    {
+        spdlog::error("File '{}' can't be patched, parsing failed", file.file.string());
+        return;
+    }
+
+    // winning edit of every member, in the order members were first set
+    struct Merged
+    {
+        uint32_t node;
+        size_t layer;
+        Patch::Edit edit;
+    };
+    std::vector<Merged> merged;
+    std::unordered_map<uint32_t, size_t> by_node;
+    for (const auto& [layer, source] : file.sources)
+    {
+        Patch patch;
+        if (source.empty() || !(source.extension() == ".ufepatch" ? patch.load(source) : patch.load_json(tree, source)))
+        {
+            spdlog::error("File '{}' not patched, edits of layer {} can't be read", file.file.string(), layer + 1);
+            return;
+        }
+        file.edits += patch.edits().size();
+        for (auto& edit : patch.edits())
+        {
+            const auto node = tree.find(edit.path);
+            if (!node)
+            {
+                file.conflicts.push_back({ edit.path, "not found", layer, edit.new_value, {} });
+                continue;
+            }
+            const auto it = by_node.find(node);
+            // an edit stacked on an earlier layer expects that layer's value
+            const bool expected = tree.equals(node, edit.old_value) || tree.equals(node, edit.new_value) ||
+                (it != by_node.end() && merged[it->second].edit.new_value == edit.old_value);
+            if (!expected)
+            {
+                file.conflicts.push_back({ tree.path(node), "old value differs", layer, edit.new_value,
+                    it != by_node.end() ? merged[it->second].edit.new_value : tree.value(node) });
+                continue;
+            }
+            if (it == by_node.end())
+            {
+                by_node.emplace(node, merged.size());
+                merged.push_back({ node, layer, { std::move(edit.path), tree.value(node), std::move(edit.new_value) } });
+                continue;
+            }
+            auto& winner = merged[it->second];
+            if (winner.edit.new_value != edit.new_value)
+            {
+                file.conflicts.push_back({ tree.path(node), "overridden", winner.layer, winner.edit.new_value, edit.new_value });
+            }
+            winner.layer = layer;
+            winner.edit.new_value = std::move(edit.new_value);
+        }
+    }
+
+    Patch patch;
+    for (auto& m : merged)
+    {
+        patch.edits().push_back(std::move(m.edit));
+    }
+    file.members = patch.edits().size();
+    file.result = patch.apply(file.file, tree.parser(), tree, nullptr);
+    file.ok = file.result.ok;
+}
+
+void Layers::print() const
+{
+    size_t patched = 0;
+    size_t edits = 0;
+    size_t members = 0;
+    size_t conflicts = 0;
+    for (const auto& file : m_files)
+    {
+        patched += file.result.written;
+        edits += file.edits;
+        members += file.members;
+        conflicts += file.conflicts.size();
+        spdlog::log(file.ok ? spdlog::level::info : spdlog::level::err, "{} '{}' with {} layers, {} edits merged into {} members, {} conflicts",
+            file.ok ? "Patched" : "Failed", file.file.string(), file.sources.size(), file.edits, file.members, file.conflicts.size());
+        for (const auto& conflict : file.conflicts)
+        {
+            spdlog::warn("  {} {}: layer '{}' sets {}, stays {}", conflict.path, conflict.reason, m_layers[conflict.layer].string(),
+                conflict.value.dump(), conflict.current.dump());
+        }
+    }
+    spdlog::info("Patched {} of {} files from {} layers, {} edits merged into {} members, {} conflicts", patched, m_files.size(),
+        m_layers.size(), edits, members, conflicts);
+}
+
+nlohmann::ordered_json Layers::to_json() const
+{
+    ojson js;
+    js["layers"] = ojson::value_t::array;
+    for (const auto& layer : m_layers)
+    {
+        js["layers"].push_back(layer.string());
+    }
+    js["files"] = ojson::value_t::array;
+    for (const auto& file : m_files)
+    {
+        ojson entry;
+        entry["file"] = file.file.string();
+        entry["ok"] = file.ok;
+        entry["sources"] = ojson::value_t::array;
+        for (const auto& [layer, source] : file.sources)
+        {
+            entry["sources"].push_back(source.string());
+        }
+        entry["edits"] = file.edits;
+        entry["members"] = file.members;
+        entry["applied"] = file.result.applied;
+        entry["unchanged"] = file.result.unchanged;
+        entry["conflicts"] = ojson::value_t::array;
+        for (const auto& conflict : file.conflicts)
+        {
+            entry["conflicts"].push_back({ { "path", conflict.path }, { "reason", conflict.reason },
+                { "layer", m_layers[conflict.layer].string() }, { "value", conflict.value }, { "current", conflict.current } });
+        }
+        js["files"].push_back(std::move(entry));
+    }
+    return js;
+}
+
+bool Layers::save_json(const fs::path& json_path) const
+{
+    return save_report(json_path, to_json(), "Layer report");
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "Patch.hpp"
+
+// Several mods patched into the same binaries at once. A layer is a directory
+// mirroring the patched one with '<relative binary path>.ufepatch' or '.json'
+// edits (or a single edit file when a single binary is patched), layers are
+// given in load order. Every binary is parsed once, the edits of all its layers
+// are resolved against it and merged, a later layer setting a member an earlier
+// one set to another value wins and the override is reported. The merged edits
+// are spliced in and the binary is written once, binaries are patched in parallel.
+class Layers
+{
+public:
+    struct Conflict
+    {
+        std::string path;
+        std::string reason;
+        size_t layer;                   // layer whose edit was dropped or overridden
+        nlohmann::ordered_json value;   // its value
+        nlohmann::ordered_json current; // value that stays, of the binary or a later layer
+    };
+    struct FileLayers
+    {
+        std::filesystem::path file; // binary
+        // edit files in load order with the index of their layer
+        std::vector<std::pair<size_t, std::filesystem::path>> sources;
+        bool ok = false;
+        size_t edits = 0;   // edits of all layers
+        size_t members = 0; // members set by the merged patch
+        Patch::Result result;
+        std::vector<Conflict> conflicts;
+    };
+
+    // root is a binary and layers edit files, or all of them are directories
+    bool run(const std::filesystem::path& root, const std::vector<std::filesystem::path>& layers, size_t threads);
+    const std::vector<FileLayers>& files() const noexcept { return m_files; }
+
+    void print() const;
+    nlohmann::ordered_json to_json() const;
+    bool save_json(const std::filesystem::path& json_path) const;
+private:
+    static void apply(FileLayers& file);
+
+    std::vector<std::filesystem::path> m_layers;
+    std::vector<FileLayers> m_files;
+};
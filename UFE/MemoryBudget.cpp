@@ -0,0 +1,100 @@
+#include "MemoryBudget.hpp"
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    // ratios to the decoded stream size, measured with --mem_stats on generated files
+    constexpr uint64_t inflate_factor = 3;      // gzip::decompress grows its output geometrically
+    constexpr uint64_t record_tree_factor = 10; // records kept for patching and validation
+    constexpr uint64_t metadata_factor = 1;     // class metadata and the record being exported
+    constexpr uint64_t json_factor = 7;         // indented json text
+    constexpr uint64_t unknown_stream_factor = 4; // compressed file without a usable gzip trailer
+    constexpr uint64_t stream_buffers = 2 * 64 * 1024;
+
+    uint64_t stream_size(const TriageEntry& entry)
+    {
+        if (entry.stream_size)
+        {
+            return entry.stream_size;
+        }
+        return entry.type == TriageEntry::EType::Compressed ? entry.file_size * unknown_stream_factor : entry.file_size;
+    }
+
+    double to_mb(uint64_t bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+}
+
+MemoryBudget::Lease MemoryBudget::acquire(uint64_t bytes)
+{
+    if (m_limit == 0)
+    {
+        return {};
+    }
+    std::unique_lock lock{ m_mutex };
+    const auto ticket = m_next_ticket++;
+    auto admitted = [&] { return ticket == m_serving && (m_used == 0 || m_used + bytes <= m_limit); };
+    if (!admitted())
+    {
+        ++m_waits;
+        const auto start = std::chrono::steady_clock::now();
+        m_cv.wait(lock, admitted);
+        m_wait_time += std::chrono::steady_clock::now() - start;
+    }
+    ++m_serving;
+    m_used += bytes;
+    m_peak = std::max(m_peak, m_used);
+    lock.unlock();
+    // next ticket may fit as well
+    m_cv.notify_all();
+    return { this, bytes };
+}
+
+void MemoryBudget::release(uint64_t bytes)
+{
+    {
+        std::lock_guard lock{ m_mutex };
+        m_used -= bytes;
+    }
+    m_cv.notify_all();
+}
+
+uint64_t MemoryBudget::estimate(const TriageEntry& entry, bool keep_records, bool buffered_json)
+{
+    const auto stream = stream_size(entry);
+    // uncompressed content becomes the stream buffer in place
+    uint64_t bytes = entry.type == TriageEntry::EType::Compressed ? entry.file_size + inflate_factor * stream : entry.file_size;
+    bytes += (keep_records ? record_tree_factor : metadata_factor) * stream;
+    if (buffered_json)
+    {
+        bytes += json_factor * stream;
+    }
+    return bytes;
+}
+
+uint64_t MemoryBudget::estimate_streaming(const TriageEntry& entry, bool keep_records)
+{
+    const auto stream = stream_size(entry);
+    return stream_buffers + stream + (keep_records ? record_tree_factor : metadata_factor) * stream;
+}
+
+void MemoryBudget::print() const
+{
+    std::lock_guard lock{ m_mutex };
+    spdlog::info("Memory budget {:.1f} MB, peak reserved {:.1f} MB, {} file(s) streamed, {} admission wait(s) {:.2f} ms",
+        to_mb(m_limit), to_mb(m_peak), m_streamed.load(), m_waits,
+        std::chrono::duration<double, std::milli>(m_wait_time).count());
+}
+
+nlohmann::ordered_json MemoryBudget::to_json() const
+{
+    std::lock_guard lock{ m_mutex };
+    return {
+        { "limit_bytes", m_limit },
+        { "peak_reserved_bytes", m_peak },
+        { "streamed_files", m_streamed.load() },
+        { "admission_waits", m_waits },
+        { "admission_wait_ms", std::chrono::duration<double, std::milli>(m_wait_time).count() }
+    };
+}
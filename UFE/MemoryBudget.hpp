@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <nlohmann/json.hpp>
+#include "Triage.hpp"
+
+// Admission control for parallel runs. Every file reserves its estimated working
+// set before it is read and waits while the budget is used up, reservations are
+// admitted in request order. A reservation larger than the whole budget is
+// admitted once nothing else is reserved, so every file still gets processed.
+class MemoryBudget
+{
+public:
+    // releases its reservation on destruction
+    class Lease
+    {
+    public:
+        Lease() = default;
+        Lease(MemoryBudget* budget, uint64_t bytes) : m_budget{ budget }, m_bytes{ bytes } {}
+        Lease(Lease&& rhs) noexcept : m_budget{ std::exchange(rhs.m_budget, nullptr) }, m_bytes{ rhs.m_bytes } {}
+        Lease& operator=(Lease&& rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                release();
+                m_budget = std::exchange(rhs.m_budget, nullptr);
+                m_bytes = rhs.m_bytes;
+            }
+            return *this;
+        }
+        ~Lease() { release(); }
+        void release()
+        {
+            if (m_budget)
+            {
+                m_budget->release(m_bytes);
+                m_budget = nullptr;
+            }
+        }
+    private:
+        MemoryBudget* m_budget = nullptr;
+        uint64_t m_bytes = 0;
+    };
+
+    // limit 0 admits everything
+    explicit MemoryBudget(uint64_t limit) : m_limit{ limit } {}
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    // blocks until bytes fit into the budget
+    Lease acquire(uint64_t bytes);
+    uint64_t limit() const noexcept { return m_limit; }
+
+    // estimated peak heap usage of a file loaded whole: file content, inflated
+    // stream, record tree and buffered json export
+    static uint64_t estimate(const TriageEntry& entry, bool keep_records, bool buffered_json);
+    // same file read and inflated in chunks with json written straight to disk
+    static uint64_t estimate_streaming(const TriageEntry& entry, bool keep_records);
+
+    void count_streamed() { ++m_streamed; }
+    // reservations, waits and streamed files, logged at info level
+    void print() const;
+    nlohmann::ordered_json to_json() const;
+private:
+    void release(uint64_t bytes);
+
+    const uint64_t m_limit;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    uint64_t m_used = 0;
+    uint64_t m_peak = 0;
+    uint64_t m_next_ticket = 0;
+    uint64_t m_serving = 0;
+    uint64_t m_waits = 0;
+    std::chrono::nanoseconds m_wait_time{};
+    std::atomic<uint64_t> m_streamed{ 0 };
+};
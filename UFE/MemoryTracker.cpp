@@ -0,0 +1,243 @@
+#include "MemoryTracker.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    struct ThreadCounters
+    {
+        int64_t live;
+        int64_t stage_peak;
+        int64_t file_peak;
+        uint64_t allocs;
+        uint64_t bytes_allocated;
+    };
+
+    std::atomic<bool> s_enabled{ false };
+    std::atomic<int64_t> s_process_live{ 0 };
+    std::atomic<int64_t> s_process_peak{ 0 };
+    // trivial type, no dynamic initialization needed inside operator new
+    thread_local ThreadCounters t_counters{};
+
+    size_t usable_size(void* p) noexcept
+    {
+#ifdef _WIN32
+        return _msize(p);
+#else
+        return malloc_usable_size(p);
+#endif
+    }
+
+    void on_alloc(void* p) noexcept
+    {
+        const auto size = static_cast<int64_t>(usable_size(p));
+        auto& tc = t_counters;
+        tc.live += size;
+        ++tc.allocs;
+        tc.bytes_allocated += size;
+        tc.stage_peak = std::max(tc.stage_peak, tc.live);
+        tc.file_peak = std::max(tc.file_peak, tc.live);
+
+        const auto live = s_process_live.fetch_add(size, std::memory_order_relaxed) + size;
+        auto peak = s_process_peak.load(std::memory_order_relaxed);
+        while (live > peak && !s_process_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void on_free(void* p) noexcept
+    {
+        const auto size = static_cast<int64_t>(usable_size(p));
+        t_counters.live -= size;
+        s_process_live.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    void* allocate(size_t size) noexcept
+    {
+        if (size == 0)
+        {
+            size = 1;
+        }
+        void* p = std::malloc(size);
+        while (!p)
+        {
+            auto handler = std::get_new_handler();
+            if (!handler)
+            {
+                return nullptr;
+            }
+            handler();
+            p = std::malloc(size);
+        }
+        if (s_enabled.load(std::memory_order_relaxed))
+        {
+            on_alloc(p);
+        }
+        return p;
+    }
+
+    void deallocate(void* p) noexcept
+    {
+        if (p)
+        {
+            if (s_enabled.load(std::memory_order_relaxed))
+            {
+                on_free(p);
+            }
+            std::free(p);
+        }
+    }
+}
+
+StageMemory& StageMemory::operator+=(const StageMemory& rhs)
+{
+    allocs += rhs.allocs;
+    bytes_allocated += rhs.bytes_allocated;
+    peak = std::max(peak, rhs.peak);
+    retained += rhs.retained;
+    return *this;
+}
+
+void MemoryTracker::enable(bool enabled /* = true */) noexcept
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool MemoryTracker::enabled() noexcept
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+MemoryTracker::Snapshot MemoryTracker::stage_begin() noexcept
+{
+    auto& tc = t_counters;
+    tc.stage_peak = tc.live;
+    return { tc.live, tc.allocs, tc.bytes_allocated };
+}
+
+StageMemory MemoryTracker::stage_end(const Snapshot& begin) noexcept
+{
+    const auto& tc = t_counters;
+    StageMemory mem;
+    mem.allocs = tc.allocs - begin.allocs;
+    mem.bytes_allocated = tc.bytes_allocated - begin.bytes_allocated;
+    mem.peak = tc.stage_peak - begin.live;
+    mem.retained = tc.live - begin.live;
+    return mem;
+}
+
+MemoryTracker::Snapshot MemoryTracker::file_begin() noexcept
+{
+    auto& tc = t_counters;
+    tc.file_peak = tc.live;
+    return { tc.live, tc.allocs, tc.bytes_allocated };
+}
+
+StageMemory MemoryTracker::file_end(const Snapshot& begin) noexcept
+{
+    const auto& tc = t_counters;
+    StageMemory mem;
+    mem.allocs = tc.allocs - begin.allocs;
+    mem.bytes_allocated = tc.bytes_allocated - begin.bytes_allocated;
+    mem.peak = tc.file_peak - begin.live;
+    mem.retained = tc.live - begin.live;
+    return mem;
+}
+
+int64_t MemoryTracker::process_live() noexcept
+{
+    return s_process_live.load(std::memory_order_relaxed);
+}
+
+int64_t MemoryTracker::process_peak() noexcept
+{
+    return s_process_peak.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::peak_rss() noexcept
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (::GetProcessMemoryInfo(::GetCurrentProcess(), &pmc, sizeof(pmc)))
+    {
+        return pmc.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage usage{};
+    if (::getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+    }
+    return 0;
+#endif
+}
+
+// global replacements, every heap allocation of the process goes through here
+void* operator new(size_t size)
+{
+    if (void* p = allocate(size))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    deallocate(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    deallocate(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    deallocate(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    deallocate(p);
+}
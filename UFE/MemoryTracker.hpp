@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// heap usage attributed to a stage or file, deltas against the live bytes
+// of the current thread when the scope started
+struct StageMemory
+{
+    uint64_t allocs = 0;
+    uint64_t bytes_allocated = 0;
+    int64_t peak = 0;     // highest live growth while the scope ran
+    int64_t retained = 0; // live growth still held when the scope ended
+
+    // sums counters, keeps the highest peak
+    StageMemory& operator+=(const StageMemory& rhs);
+};
+
+// Counts heap usage through the replaced global operator new/delete, which
+// covers the std::any record tree, ordered_json DOM and raw file buffers alike.
+// Tracking is off by default, untracked runs only pay one branch per allocation.
+class MemoryTracker
+{
+public:
+    struct Snapshot
+    {
+        int64_t live = 0;
+        uint64_t allocs = 0;
+        uint64_t bytes_allocated = 0;
+    };
+
+    static void enable(bool enabled = true) noexcept;
+    static bool enabled() noexcept;
+
+    // scopes are per thread, stage scopes must not nest
+    static Snapshot stage_begin() noexcept;
+    static StageMemory stage_end(const Snapshot& begin) noexcept;
+    static Snapshot file_begin() noexcept;
+    static StageMemory file_end(const Snapshot& begin) noexcept;
+
+    static int64_t process_live() noexcept;
+    static int64_t process_peak() noexcept;
+    // peak resident set (working set on Windows) of the whole process
+    static uint64_t peak_rss() noexcept;
+};
@@ -0,0 +1,715 @@
+#include "MerkleTree.hpp"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <map>
+#include <typeindex>
+#include <utility>
+#include "StringInterner.hpp"
+
+namespace
+{
+    // distinct seeds keep nodes of different kinds apart
+    constexpr uint64_t class_seed = 0x436c617373ull;
+    constexpr uint64_t array_seed = 0x4172726179ull;
+    constexpr uint64_t file_seed = 0x46696c65ull;
+    constexpr uint64_t string_seed = 0x537472696e67ull;
+    constexpr uint64_t value_seed = 0x56616c7565ull;
+    constexpr uint64_t reference_seed = 0x526566ull;
+    constexpr uint64_t null_seed = 0x4e756c6cull;
+
+    template <typename T>
+    constexpr std::string_view type_name()
+    {
+        if constexpr (std::is_same_v<T, bool>) return "bool";
+        else if constexpr (std::is_same_v<T, char>) return "char";
+        else if constexpr (std::is_same_v<T, unsigned char>) return "uint8";
+        else if constexpr (std::is_same_v<T, int16_t>) return "int16";
+        else if constexpr (std::is_same_v<T, uint16_t>) return "uint16";
+        else if constexpr (std::is_same_v<T, int32_t>) return "int32";
+        else if constexpr (std::is_same_v<T, uint32_t>) return "uint32";
+        else if constexpr (std::is_same_v<T, int64_t>) return "int64";
+        else if constexpr (std::is_same_v<T, uint64_t>) return "uint64";
+        else if constexpr (std::is_same_v<T, float>) return "float";
+        else return "double";
+    }
+
+    template <typename T>
+    bool set_primitive(MerkleTree::Node& node, const std::any& value)
+    {
+        if (value.type() != typeid(IndexedData<T>))
+        {
+            return false;
+        }
+        const auto& data = std::any_cast<const IndexedData<T>&>(value);
+        const T v = data.value;
+        node.kind = MerkleTree::EKind::Value;
+        node.type = type_name<T>();
+        node.offset = data.offset;
+        node.size = sizeof(T);
+        uint64_t bits = 0;
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            node.value = v;
+            bits = v;
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            node.value = v;
+            bits = std::bit_cast<std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t>>(v);
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            node.value = static_cast<int64_t>(v);
+            bits = static_cast<uint64_t>(static_cast<int64_t>(v));
+        }
+        else
+        {
+            node.value = static_cast<uint64_t>(v);
+            bits = v;
+        }
+        node.hash = MerkleTree::combine(MerkleTree::combine(value_seed, MerkleTree::hash_bytes(node.type)), bits);
+        return true;
+    }
+
+    template <typename... T>
+    bool set_primitives(MerkleTree::Node& node, const std::any& value)
+    {
+        return (set_primitive<T>(node, value) || ...);
+    }
+}
+
+uint64_t MerkleTree::hash_bytes(std::string_view bytes) noexcept
+{
+    // FNV-1a, stable across runs and platforms
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const auto c : bytes)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t MerkleTree::combine(uint64_t seed, uint64_t value) noexcept
+{
+    // splitmix64 finalizer, order of combined values matters
+    uint64_t x = seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+bool MerkleTree::open(const std::filesystem::path& file)
+{
+    m_nodes.clear();
+    return m_parser.open(file);
+}
+
+bool MerkleTree::build(bool keep_records)
+{
+    begin();
+    m_parser.read_records([this](const std::any& record) { add_root(record); }, keep_records);
+    finish();
+    return valid();
+}
+
+void MerkleTree::build(const std::vector<std::any>& records)
+{
+    begin();
+    for (const auto& record : records)
+    {
+        add_root(record);
+    }
+    finish();
+}
+
+void MerkleTree::begin()
+{
+    m_nodes.clear();
+    m_ids.clear();
+    m_root_counts.clear();
+    m_nodes.emplace_back().kind = EKind::File;
+}
+
+bool MerkleTree::valid() const noexcept
+{
+    return m_parser.status() != BinaryFileParser::EFileStatus::Invalid && m_parser.status() != BinaryFileParser::EFileStatus::Empty;
+}
+
+void MerkleTree::add_root(const std::any& record)
+{
+    std::string_view label;
+    const auto type = std::type_index(record.type());
+    if (type == std::type_index(typeid(ufe::ClassWithMembersAndTypes)))
+    {
+        label = StringInterner::str(std::any_cast<const ufe::ClassWithMembersAndTypes&>(record).m_ClassInfo.NameId);
+    }
+    else if (type == std::type_index(typeid(ufe::ClassWithId)))
+    {
+        label = StringInterner::str(std::any_cast<const ufe::ClassWithId&>(record).m_ClassInfo.NameId);
+    }
+    else if (type == std::type_index(typeid(ufe::BinaryObjectString)))
+    {
+        label = "string";
+    }
+    else if (type == std::type_index(typeid(ufe::BinaryArray)) || type == std::type_index(typeid(ufe::ArraySingleString)) ||
+        type == std::type_index(typeid(ufe::ArraySinglePrimitive)))
+    {
+        label = "array";
+    }
+    else
+    {
+        // header and libraries carry no content of their own
+        return;
+    }
+    add(record, label, m_root_counts[label]++, 0xFF, 0);
+}
+
+uint32_t MerkleTree::add(const std::any& value, std::string_view name, uint32_t index, uint8_t binary_type, uint32_t parent)
+{
+    const auto node = static_cast<uint32_t>(m_nodes.size());
+    {
+        auto& n = m_nodes.emplace_back();
+        n.parent = parent;
+        n.name = name;
+        n.index = index;
+        n.binary_type = binary_type;
+    }
+    // children are added below, m_nodes may reallocate
+    const auto type = std::type_index(value.type());
+    if (type == std::type_index(typeid(ufe::ClassWithMembersAndTypes)) || type == std::type_index(typeid(ufe::ClassWithId)))
+    {
+        const bool with_types = type == std::type_index(typeid(ufe::ClassWithMembersAndTypes));
+        const auto& ci = with_types ? std::any_cast<const ufe::ClassWithMembersAndTypes&>(value).m_ClassInfo :
+            std::any_cast<const ufe::ClassWithId&>(value).m_ClassInfo;
+        const auto& mti = with_types ? std::any_cast<const ufe::ClassWithMembersAndTypes&>(value).m_MemberTypeInfo :
+            std::any_cast<const ufe::ClassWithId&>(value).m_MemberTypeInfo;
+        m_nodes[node].kind = EKind::Class;
+        m_nodes[node].type = StringInterner::str(ci.NameId);
+        m_nodes[node].object_id = ci.ObjectId.value;
+        m_ids[ci.ObjectId.value] = node;
+        add_class(node, ci, mti);
+    }
+    else if (type == std::type_index(typeid(ufe::BinaryArray)))
+    {
+        const auto& arr = std::any_cast<const ufe::BinaryArray&>(value);
+        m_nodes[node].kind = EKind::Array;
+        m_nodes[node].type = "BinaryArray";
+        m_nodes[node].object_id = arr.ObjectId;
+        m_ids[arr.ObjectId] = node;
+        add_elements(node, arr.Data);
+    }
+    else if (type == std::type_index(typeid(ufe::ArraySingleString)))
+    {
+        const auto& arr = std::any_cast<const ufe::ArraySingleString&>(value);
+        m_nodes[node].kind = EKind::Array;
+        m_nodes[node].type = "ArraySingleString";
+        m_nodes[node].object_id = arr.ObjectId;
+        m_ids[arr.ObjectId] = node;
+        add_elements(node, arr.Data);
+    }
+    else if (type == std::type_index(typeid(ufe::ArraySinglePrimitive)))
+    {
+        const auto& arr = std::any_cast<const ufe::ArraySinglePrimitive&>(value);
+        m_nodes[node].kind = EKind::Array;
+        m_nodes[node].type = "ArraySinglePrimitive";
+        m_nodes[node].object_id = arr.ObjectId;
+        m_ids[arr.ObjectId] = node;
+        add_elements(node, arr.Data);
+    }
+    else if (type == std::type_index(typeid(ufe::BinaryObjectString)))
+    {
+        const auto& bos = std::any_cast<const ufe::BinaryObjectString&>(value);
+        auto& n = m_nodes[node];
+        n.kind = EKind::String;
+        n.type = "string";
+        n.object_id = bos.m_ObjectId;
+        n.text = bos.m_Value.value.string;
+        n.offset = bos.m_Value.offset;
+        n.hash = combine(string_seed, hash_bytes(n.text));
+        m_ids[bos.m_ObjectId] = node;
+    }
+    else if (type == std::type_index(typeid(ufe::MemberReference)))
+    {
+        // hashed by finish once the target is known
+        m_nodes[node].kind = EKind::Reference;
+        m_nodes[node].object_id = std::any_cast<const ufe::MemberReference&>(value).m_idRef;
+    }
+    else if (!set_primitives<bool, char, unsigned char, int16_t, uint16_t, int32_t, uint32_t, int64_t, uint64_t, float, double>(m_nodes[node], value))
+    {
+        // ObjectNull and anything without content
+        m_nodes[node].kind = EKind::Null;
+        m_nodes[node].hash = null_seed;
+    }
+    m_nodes[node].end = static_cast<uint32_t>(m_nodes.size());
+    return node;
+}
+
+void MerkleTree::add_class(uint32_t node, const ufe::ClassInfo& ci, const ufe::MemberTypeInfo& mti)
+{
+    const auto members = std::min({ mti.BinaryTypeEnums.size(), mti.Data.size(), ci.MemberNameIds.size() });
+    for (size_t i = 0; i < members; ++i)
+    {
+        if (mti.Data[i].type() == typeid(ufe::SkippedValue))
+        {
+            continue;
+        }
+        add(mti.Data[i], StringInterner::str(ci.MemberNameIds[i]), 0, static_cast<uint8_t>(mti.BinaryTypeEnums[i]), node);
+    }
+}
+
+void MerkleTree::add_elements(uint32_t node, const std::vector<std::any>& data)
+{
+    uint32_t index = 0;
+    for (const auto& element : data)
+    {
+        if (element.type() == typeid(ufe::ObjectNullMultiple256))
+        {
+            // packed nulls stand for NullCount elements
+            const auto count = std::max<uint32_t>(1, std::any_cast<const ufe::ObjectNullMultiple256&>(element).NullCount);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                add(ufe::ObjectNull{}, {}, index++, 0xFF, node);
+            }
+        }
+        else if (element.type() != typeid(ufe::SkippedValue))
+        {
+            add(element, {}, index++, 0xFF, node);
+        }
+    }
+}
+
+void MerkleTree::finish()
+{
+    m_nodes.front().end = static_cast<uint32_t>(m_nodes.size());
+    for (auto& node : m_nodes)
+    {
+        if (node.kind == EKind::Reference)
+        {
+            const auto target = m_ids.find(node.object_id);
+            node.hash = combine(reference_seed, target != m_ids.end() ? hash_bytes(path(target->second)) : static_cast<uint32_t>(node.object_id));
+        }
+    }
+    // children come after their parent
+    for (auto i = static_cast<uint32_t>(m_nodes.size()); i-- > 0;)
+    {
+        const auto kind = m_nodes[i].kind;
+        if (kind != EKind::File && kind != EKind::Class && kind != EKind::Array)
+        {
+            continue;
+        }
+        uint64_t hash = combine(kind == EKind::File ? file_seed : kind == EKind::Class ? class_seed : array_seed, name_hash(m_nodes[i].type));
+        for_each_child(i, [&](uint32_t child)
+            {
+                const auto& c = m_nodes[child];
+                // members by name and type, elements by position
+                hash = combine(hash, kind == EKind::Array ? c.hash : combine(name_hash(c.name) ^ c.binary_type, c.hash));
+            });
+        m_nodes[i].hash = hash;
+    }
+}
+
+uint64_t MerkleTree::name_hash(std::string_view name)
+{
+    const auto [it, inserted] = m_name_hashes.try_emplace(name.data(), 0);
+    if (inserted)
+    {
+        it->second = hash_bytes(name);
+    }
+    return it->second;
+}
+
+std::string MerkleTree::path(uint32_t node) const
+{
+    std::vector<uint32_t> chain;
+    for (; node != 0 && node < m_nodes.size(); node = m_nodes[node].parent)
+    {
+        chain.push_back(node);
+    }
+    std::string result;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+    {
+        const auto& n = m_nodes[*it];
+        if (n.parent == 0)
+        {
+            result.append(n.name).append("[").append(std::to_string(n.index)).append("]");
+        }
+        else if (n.name.empty())
+        {
+            result.append("[").append(std::to_string(n.index)).append("]");
+        }
+        else
+        {
+            result.append(".").append(n.name);
+        }
+    }
+    return result;
+}
+
+nlohmann::ordered_json MerkleTree::value(uint32_t node) const
+{
+    const auto& n = m_nodes[node];
+    switch (n.kind)
+    {
+        case EKind::Value:
+            return std::visit([](const auto& v) -> nlohmann::ordered_json
+                {
+                    if constexpr (std::is_same_v<std::decay_t<decltype(v)>, std::monostate>)
+                    {
+                        return nullptr;
+                    }
+                    else
+                    {
+                        return v;
+                    }
+                }, n.value);
+        case EKind::String:
+            return std::string{ n.text };
+        case EKind::Reference:
+        {
+            const auto target = m_ids.find(n.object_id);
+            return "-> " + (target != m_ids.end() ? path(target->second) : "#" + std::to_string(n.object_id));
+        }
+        case EKind::Class:
+        case EKind::Array:
+        {
+            size_t children = 0;
+            for_each_child(node, [&](uint32_t) { ++children; });
+            return std::string{ n.type } + (n.kind == EKind::Class ? " {" : " [") + std::to_string(children) + (n.kind == EKind::Class ? "}" : "]");
+        }
+        case EKind::File:
+        case EKind::Null:
+        default:
+            return nullptr;
+    }
+}
+
+bool MerkleTree::equals(uint32_t node, const nlohmann::ordered_json& value) const
+{
+    const auto& n = m_nodes[node];
+    if (n.kind == EKind::String)
+    {
+        return value.is_string() && value.get_ref<const std::string&>() == n.text;
+    }
+    if (n.kind != EKind::Value)
+    {
+        return false;
+    }
+    return std::visit([&value](const auto& v)
+        {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, std::monostate>)
+            {
+                return value.is_null();
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                return value.is_boolean() && value.get<bool>() == v;
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                // json text of a float reads back as a double
+                return value.is_number() && static_cast<T>(value.get<double>()) == v;
+            }
+            else
+            {
+                return value.is_number_integer() && value.get<T>() == v;
+            }
+        }, n.value);
+}
+
+uint32_t MerkleTree::child(uint32_t node, std::string_view name, uint32_t index) const
+{
+    uint32_t found = 0;
+    for_each_child(node, [&](uint32_t c)
+        {
+            if (!found && m_nodes[c].name == name && m_nodes[c].index == index)
+            {
+                found = c;
+            }
+        });
+    return found;
+}
+
+uint32_t MerkleTree::object(int32_t id) const
+{
+    const auto it = m_ids.find(id);
+    return it != m_ids.end() ? it->second : 0;
+}
+
+std::string MerkleTree::address(uint32_t node) const
+{
+    uint32_t root = node;
+    while (root != 0 && m_nodes[root].parent != 0)
+    {
+        root = m_nodes[root].parent;
+    }
+    auto result = path(node);
+    const auto id = m_nodes[root].object_id;
+    if (root == 0 || id == 0 || object(id) != root)
+    {
+        return result;
+    }
+    return "@" + std::to_string(id) + result.substr(path(root).size());
+}
+
+uint32_t MerkleTree::find(std::string_view path) const
+{
+    // digits of '[n]' at pos, pos is moved past it
+    auto ordinal = [&path](size_t& pos, uint32_t& value)
+    {
+        if (pos >= path.size() || path[pos] != '[')
+        {
+            return false;
+        }
+        const auto [end, ec] = std::from_chars(path.data() + pos + 1, path.data() + path.size(), value);
+        if (ec != std::errc{} || end == path.data() + path.size() || *end != ']')
+        {
+            return false;
+        }
+        pos = end - path.data() + 1;
+        return true;
+    };
+
+    uint32_t node = 0;
+    size_t pos = 0;
+    if (path.starts_with('@'))
+    {
+        int32_t id = 0;
+        const auto [end, ec] = std::from_chars(path.data() + 1, path.data() + path.size(), id);
+        if (ec != std::errc{})
+        {
+            return 0;
+        }
+        node = object(id);
+        pos = end - path.data();
+    }
+    else
+    {
+        // class names have dots and brackets of their own, match them whole
+        for_each_child(0, [&](uint32_t root)
+            {
+                const auto& name = m_nodes[root].name;
+                size_t end = name.size();
+                uint32_t index = 0;
+                if (!node && path.starts_with(name) && ordinal(end, index) && index == m_nodes[root].index)
+                {
+                    node = root;
+                    pos = end;
+                }
+            });
+    }
+    while (node && pos < path.size())
+    {
+        if (path[pos] == '.')
+        {
+            const auto end = std::min(path.find_first_of(".[", pos + 1), path.size());
+            node = child(node, path.substr(pos + 1, end - pos - 1), 0);
+            pos = end;
+        }
+        else
+        {
+            uint32_t index = 0;
+            node = ordinal(pos, index) ? child(node, {}, index) : 0;
+        }
+    }
+    return node;
+}
+
+bool MerkleTree::record_id(const nlohmann::ordered_json& record, int32_t& id)
+{
+    for (const auto* key : { "class", "class_id" })
+    {
+        if (record.contains(key) && record[key].contains("id"))
+        {
+            id = record[key]["id"].get<int32_t>();
+            return true;
+        }
+    }
+    for (const auto* key : { "obj_string_id", "array_id" })
+    {
+        if (record.contains(key))
+        {
+            id = record[key].get<int32_t>();
+            return true;
+        }
+    }
+    return false;
+}
+
+const nlohmann::ordered_json* MerkleTree::class_members(const nlohmann::ordered_json& json)
+{
+    for (const auto* key : { "class", "class_id" })
+    {
+        if (json.is_object() && json.contains(key) && json[key].contains("members"))
+        {
+            return &json[key]["members"];
+        }
+    }
+    return nullptr;
+}
+
+nlohmann::ordered_json* MerkleTree::class_members(nlohmann::ordered_json& json)
+{
+    return const_cast<nlohmann::ordered_json*>(class_members(std::as_const(json)));
+}
+
+bool MerkleTree::element_position(const nlohmann::ordered_json& values, uint32_t index, size_t& position)
+{
+    uint32_t element = 0;
+    for (position = 0; position < values.size(); ++position)
+    {
+        const auto& value = values[position];
+        const uint32_t count = value.is_object() && value.contains("null_packed") ? std::max(1, value["null_packed"].get<int>()) : 1;
+        if (index < element + count)
+        {
+            return count == 1;
+        }
+        element += count;
+    }
+    return false;
+}
+
+std::vector<MerkleTree::JsonEdit> MerkleTree::json_edits(const nlohmann::ordered_json& doc) const
+{
+    std::vector<JsonEdit> edits;
+    if (!doc.contains("records") || !doc["records"].is_array())
+    {
+        return edits;
+    }
+    for (const auto& record : doc["records"])
+    {
+        int32_t id = 0;
+        const auto node = record_id(record, id) ? object(id) : 0;
+        if (node && m_nodes[node].parent == 0)
+        {
+            json_edits(node, record, edits);
+        }
+    }
+    return edits;
+}
+
+void MerkleTree::json_edits(uint32_t node, const nlohmann::ordered_json& json, std::vector<JsonEdit>& edits) const
+{
+    switch (m_nodes[node].kind)
+    {
+        case EKind::Class:
+            if (const auto* members = class_members(json))
+            {
+                for_each_child(node, [&](uint32_t child)
+                    {
+                        const auto name = std::string{ m_nodes[child].name };
+                        if (members->contains(name))
+                        {
+                            json_edits(child, (*members)[name], edits);
+                        }
+                    });
+            }
+            break;
+        case EKind::Array:
+            if (json.is_object() && json.contains("values") && json["values"].is_array())
+            {
+                const auto& values = json["values"];
+                for_each_child(node, [&](uint32_t child)
+                    {
+                        size_t position = 0;
+                        if (element_position(values, m_nodes[child].index, position))
+                        {
+                            json_edits(child, values[position], edits);
+                        }
+                    });
+            }
+            break;
+        case EKind::String:
+            if (json.is_object() && json.contains("value") && !equals(node, json["value"]))
+            {
+                edits.push_back({ node, json["value"] });
+            }
+            break;
+        case EKind::Value:
+            if ((json.is_number() || json.is_boolean()) && !equals(node, json))
+            {
+                edits.push_back({ node, json });
+            }
+            break;
+        default:
+            // references and nulls can't be edited
+            break;
+    }
+}
+
+std::vector<MerkleTree::Change> MerkleTree::diff(const MerkleTree& old_tree, const MerkleTree& new_tree, uint64_t* visited)
+{
+    std::vector<Change> changes;
+    uint64_t count = 0;
+    if (!old_tree.m_nodes.empty() && !new_tree.m_nodes.empty())
+    {
+        diff_node(old_tree, 0, new_tree, 0, changes, count);
+    }
+    if (visited)
+    {
+        *visited += count;
+    }
+    return changes;
+}
+
+void MerkleTree::diff_node(const MerkleTree& a, uint32_t na, const MerkleTree& b, uint32_t nb, std::vector<Change>& changes, uint64_t& visited)
+{
+    ++visited;
+    const auto& x = a.m_nodes[na];
+    const auto& y = b.m_nodes[nb];
+    if (x.hash == y.hash)
+    {
+        return;
+    }
+    const bool same_layout = x.kind == y.kind && (x.kind == EKind::File || x.kind == EKind::Array || (x.kind == EKind::Class && x.type == y.type));
+    if (!same_layout)
+    {
+        changes.push_back({ Change::EType::Changed, b.path(nb), a.value(na), b.value(nb) });
+        return;
+    }
+    if (x.kind == EKind::Array)
+    {
+        // elements by position
+        uint32_t ca = na + 1;
+        uint32_t cb = nb + 1;
+        for (; ca < x.end && cb < y.end; ca = a.m_nodes[ca].end, cb = b.m_nodes[cb].end)
+        {
+            diff_node(a, ca, b, cb, changes, visited);
+        }
+        for (; ca < x.end; ca = a.m_nodes[ca].end)
+        {
+            changes.push_back({ Change::EType::Removed, a.path(ca), a.value(ca), nullptr });
+        }
+        for (; cb < y.end; cb = b.m_nodes[cb].end)
+        {
+            changes.push_back({ Change::EType::Added, b.path(cb), nullptr, b.value(cb) });
+        }
+        return;
+    }
+    // members by name, root records by label and ordinal
+    std::map<std::pair<std::string_view, uint32_t>, uint32_t> others;
+    b.for_each_child(nb, [&](uint32_t child) { others.emplace(std::make_pair(b.m_nodes[child].name, b.m_nodes[child].index), child); });
+    a.for_each_child(na, [&](uint32_t child)
+        {
+            const auto it = others.find({ a.m_nodes[child].name, a.m_nodes[child].index });
+            if (it == others.end())
+            {
+                changes.push_back({ Change::EType::Removed, a.path(child), a.value(child), nullptr });
+                return;
+            }
+            diff_node(a, child, b, it->second, changes, visited);
+            others.erase(it);
+        });
+    b.for_each_child(nb, [&](uint32_t child)
+        {
+            if (others.contains({ b.m_nodes[child].name, b.m_nodes[child].index }))
+            {
+                changes.push_back({ Change::EType::Added, b.path(child), nullptr, b.value(child) });
+            }
+        });
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include <any>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "BinaryFileParser.hpp"
+
+// Structural hashes of the records of a file. Every class, array, string and
+// value is a node whose hash covers its layout (class name, member names and
+// types) and content, inner nodes combine the hashes of their children. File
+// offsets and object ids don't take part, a record keeps its hash when strings
+// before it change length or objects are renumbered; references hash as the
+// path of the object they point to.
+//
+// Nodes are addressed by member paths, '<class>[n]' is the n-th root record of
+// that class ('string[n]', 'array[n]' for root strings and arrays), followed by
+// '.<member>' and '[i]' for array elements: 'Gen.Item0[0].m_array0[3].m_value1'.
+// '@<id>' in place of the root record starts at the object with that id.
+class MerkleTree
+{
+public:
+    enum class EKind : uint8_t
+    {
+        File,
+        Class,
+        Array,
+        String,
+        Value,
+        Reference,
+        Null
+    };
+    using Value = std::variant<std::monostate, bool, int64_t, uint64_t, float, double>;
+    struct Node
+    {
+        uint64_t hash = 0;
+        // nodes are in pre-order, the subtree of a node ends before end
+        uint32_t end = 0;
+        uint32_t parent = 0;
+        // member name or label of root records, empty for array elements
+        std::string_view name;
+        // root ordinal among records with the same label, array element index
+        uint32_t index = 0;
+        EKind kind = EKind::Null;
+        // member BinaryTypeEnum, 0xFF for root records and array elements
+        uint8_t binary_type = 0xFF;
+        // class name, array record or primitive type name
+        std::string_view type;
+        // own id of classes, arrays and strings, referenced id of references
+        int32_t object_id = 0;
+        Value value;
+        std::string_view text; // strings, views into the parser buffer
+        // values and strings (their length prefix) in the decoded stream, not hashed
+        uint64_t offset = 0;
+        uint8_t size = 0; // bytes of values
+    };
+    struct Change
+    {
+        enum class EType
+        {
+            Added,
+            Removed,
+            Changed
+        };
+        EType type = EType::Changed;
+        std::string path;
+        nlohmann::ordered_json old_value;
+        nlohmann::ordered_json new_value;
+    };
+
+    // value of an edited export that differs from the node it was exported from
+    struct JsonEdit
+    {
+        uint32_t node;
+        nlohmann::ordered_json value;
+    };
+
+    // reads and inflates the file, records are parsed by build
+    bool open(const std::filesystem::path& file);
+    // keep_records keeps the parsed root records for records()
+    bool build(bool keep_records = false);
+    // tree of records parsed by another parser, which has to outlive the tree
+    void build(const std::vector<std::any>& records);
+    const BinaryFileParser& parser() const noexcept { return m_parser; }
+    const std::vector<std::any>& records() const noexcept { return m_parser.get_records(); }
+    // decoded stream, equal streams have equal trees
+    std::string_view stream() const noexcept { return m_parser.stream(); }
+    bool valid() const noexcept;
+
+    uint64_t hash() const noexcept { return m_nodes.empty() ? 0 : m_nodes.front().hash; }
+    const std::vector<Node>& nodes() const noexcept { return m_nodes; }
+    std::string path(uint32_t node) const;
+    // leaf values as json, inner nodes as a short description
+    nlohmann::ordered_json value(uint32_t node) const;
+    // value given as json equals the node's value, compared in the node's type
+    bool equals(uint32_t node, const nlohmann::ordered_json& value) const;
+    // member name or array element index of node, 0 if there is none
+    uint32_t child(uint32_t node, std::string_view name, uint32_t index) const;
+    // class, array or string with object id, 0 if there is none
+    uint32_t object(int32_t id) const;
+    // member path starting at the object id of the root record, it doesn't depend on
+    // the order of root records
+    std::string address(uint32_t node) const;
+    // node at a member path, 0 if there is none
+    uint32_t find(std::string_view path) const;
+    // values and strings of an export of this tree that were edited, records are
+    // matched by object id like patching does
+    std::vector<JsonEdit> json_edits(const nlohmann::ordered_json& doc) const;
+
+    template <typename F>
+    void for_each_child(uint32_t node, F&& f) const
+    {
+        for (uint32_t child = node + 1; child < m_nodes[node].end; child = m_nodes[child].end)
+        {
+            f(child);
+        }
+    }
+
+    // member level changes from old_tree to new_tree, only subtrees with differing
+    // hashes are visited; visited counts compared nodes when given
+    static std::vector<Change> diff(const MerkleTree& old_tree, const MerkleTree& new_tree, uint64_t* visited = nullptr);
+
+    static uint64_t hash_bytes(std::string_view bytes) noexcept;
+    static uint64_t combine(uint64_t seed, uint64_t value) noexcept;
+
+    // layout of json exports: object id of a root record, members of a class (nullptr
+    // if json isn't one) and position of array element index in the json values,
+    // packed nulls stand for several elements
+    static bool record_id(const nlohmann::ordered_json& record, int32_t& id);
+    static const nlohmann::ordered_json* class_members(const nlohmann::ordered_json& json);
+    static nlohmann::ordered_json* class_members(nlohmann::ordered_json& json);
+    static bool element_position(const nlohmann::ordered_json& values, uint32_t index, size_t& position);
+private:
+    void begin();
+    void add_root(const std::any& record);
+    uint32_t add(const std::any& value, std::string_view name, uint32_t index, uint8_t binary_type, uint32_t parent);
+    void add_class(uint32_t node, const ufe::ClassInfo& ci, const ufe::MemberTypeInfo& mti);
+    void add_elements(uint32_t node, const std::vector<std::any>& data);
+    // references need every object id, inner hashes need their children
+    void finish();
+    uint64_t name_hash(std::string_view name);
+    void json_edits(uint32_t node, const nlohmann::ordered_json& json, std::vector<JsonEdit>& edits) const;
+    static void diff_node(const MerkleTree& a, uint32_t na, const MerkleTree& b, uint32_t nb, std::vector<Change>& changes, uint64_t& visited);
+
+    BinaryFileParser m_parser;
+    std::vector<Node> m_nodes;
+    std::unordered_map<int32_t, uint32_t> m_ids;
+    std::unordered_map<std::string_view, uint32_t> m_root_counts;
+    // names are interned or literals, keyed by their address
+    std::unordered_map<const char*, uint64_t> m_name_hashes;
+};
@@ -0,0 +1,347 @@
+#include "NrbfGenerator.hpp"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <gzip/compress.hpp>
+#include <spdlog/spdlog.h>
+#include "BinaryFileWriter.hpp"
+
+namespace
+{
+    // primitive types BinaryFileParser and JsonWriter both support
+    constexpr std::array<ufe::EPrimitiveTypeEnumeration, 10> primitive_mix
+    {
+        ufe::EPrimitiveTypeEnumeration::Int32,
+        ufe::EPrimitiveTypeEnumeration::Single,
+        ufe::EPrimitiveTypeEnumeration::Boolean,
+        ufe::EPrimitiveTypeEnumeration::Double,
+        ufe::EPrimitiveTypeEnumeration::Int16,
+        ufe::EPrimitiveTypeEnumeration::Int64,
+        ufe::EPrimitiveTypeEnumeration::Byte,
+        ufe::EPrimitiveTypeEnumeration::UInt32,
+        ufe::EPrimitiveTypeEnumeration::UInt16,
+        ufe::EPrimitiveTypeEnumeration::UInt64
+    };
+}
+
+NrbfGenerator::NrbfGenerator(const GeneratorOptions& options) :
+    m_options{ options },
+    m_rng{ options.seed }
+{
+    m_options.classes = std::max(m_options.classes, 1u);
+    build_layouts();
+}
+
+std::string NrbfGenerator::generate_stream()
+{
+    m_out.clear();
+    m_string_ids.clear();
+    m_records = 0;
+    for (auto& cls : m_classes)
+    {
+        cls.metadata_id = 0;
+    }
+    for (auto& cls : m_leaf_classes)
+    {
+        cls.metadata_id = 0;
+    }
+    // root object gets id 1, checked by BinaryFileParser::check_header
+    m_root_pending = true;
+    m_library_id = 2;
+    m_next_id = 3;
+
+    write_record_type(ufe::ERecordType::SerializedStreamHeader);
+    write<int32_t>(1);
+    write<int32_t>(-1);
+    write<int32_t>(1);
+    write<int32_t>(0);
+
+    write_record_type(ufe::ERecordType::BinaryLibrary);
+    write<int32_t>(m_library_id);
+    write_string("Assembly-CSharp, Version=0.0.0.0, Culture=neutral, PublicKeyToken=null");
+
+    for (uint32_t i = 0; i < m_options.objects; ++i)
+    {
+        write_class(m_classes[i % m_classes.size()]);
+    }
+    write_record_type(ufe::ERecordType::MessageEnd);
+    return std::move(m_out);
+}
+
+std::string NrbfGenerator::generate_file()
+{
+    auto stream = generate_stream();
+    // header content is opaque to the parser, only its size matters
+    std::string file(GZIP_START_OFF, '\0');
+    if (m_options.compressed)
+    {
+        file += gzip::compress(stream.data(), stream.size(), Z_DEFAULT_COMPRESSION);
+    }
+    else
+    {
+        file += stream;
+    }
+    return file;
+}
+
+bool NrbfGenerator::save(const std::filesystem::path& file_path)
+{
+    std::ofstream out{ file_path, std::ios::binary };
+    if (out)
+    {
+        const auto data = generate_file();
+        out.write(data.data(), data.size());
+        return true;
+    }
+    spdlog::error("Could not save '{}'", file_path.string());
+    return false;
+}
+
+void NrbfGenerator::write_record_type(ufe::ERecordType rec)
+{
+    write_byte(static_cast<uint8_t>(rec));
+    ++m_records;
+}
+
+void NrbfGenerator::write_string(std::string_view s)
+{
+    BinaryFileWriter::append_string(m_out, s);
+}
+
+void NrbfGenerator::build_layouts()
+{
+    const auto leaf_count = std::max(m_options.classes / 2, 1u);
+    for (uint32_t i = 0; i < leaf_count; ++i)
+    {
+        ClassLayout leaf;
+        leaf.name = "Gen.Leaf" + std::to_string(i);
+        const auto members = 2 + i % 3;
+        for (uint32_t m = 0; m < members; ++m)
+        {
+            leaf.members.push_back({ "m_value" + std::to_string(m), ufe::EBinaryTypeEnumeration::Primitive,
+                primitive_mix[(i + m) % primitive_mix.size()] });
+        }
+        m_leaf_classes.push_back(std::move(leaf));
+    }
+
+    for (uint32_t i = 0; i < m_options.classes; ++i)
+    {
+        ClassLayout cls;
+        cls.name = "Gen.Item" + std::to_string(i);
+        for (uint32_t m = 0; m < m_options.primitive_members; ++m)
+        {
+            cls.members.push_back({ "m_prim" + std::to_string(m), ufe::EBinaryTypeEnumeration::Primitive,
+                primitive_mix[(i + m) % primitive_mix.size()] });
+        }
+        for (uint32_t m = 0; m < m_options.string_members; ++m)
+        {
+            cls.members.push_back({ "m_str" + std::to_string(m), ufe::EBinaryTypeEnumeration::String });
+        }
+        for (uint32_t m = 0; m < m_options.nested_members; ++m)
+        {
+            MemberLayout member{ "m_nested" + std::to_string(m), ufe::EBinaryTypeEnumeration::Class };
+            member.leaf = (i + m) % m_leaf_classes.size();
+            cls.members.push_back(std::move(member));
+        }
+        for (uint32_t m = 0; m < m_options.array_members; ++m)
+        {
+            MemberLayout member{ "m_array" + std::to_string(m),
+                m % 2 ? ufe::EBinaryTypeEnumeration::Object : ufe::EBinaryTypeEnumeration::StringArray };
+            member.leaf = (i + m) % m_leaf_classes.size();
+            cls.members.push_back(std::move(member));
+        }
+        m_classes.push_back(std::move(cls));
+    }
+}
+
+void NrbfGenerator::write_class(ClassLayout& cls)
+{
+    const int32_t id = m_root_pending ? 1 : m_next_id++;
+    m_root_pending = false;
+    if (cls.metadata_id)
+    {
+        write_record_type(ufe::ERecordType::ClassWithId);
+        write<int32_t>(id);
+        write<int32_t>(cls.metadata_id);
+        write_members(cls);
+        return;
+    }
+
+    cls.metadata_id = id;
+    write_record_type(ufe::ERecordType::ClassWithMembersAndTypes);
+    write<int32_t>(id);
+    write_string(cls.name);
+    write<int32_t>(static_cast<int32_t>(cls.members.size()));
+    for (const auto& member : cls.members)
+    {
+        write_string(member.name);
+    }
+    for (const auto& member : cls.members)
+    {
+        write_byte(static_cast<uint8_t>(member.type));
+    }
+    for (const auto& member : cls.members)
+    {
+        switch (member.type)
+        {
+            case ufe::EBinaryTypeEnumeration::Primitive:
+                write_byte(static_cast<uint8_t>(member.primitive));
+                break;
+            case ufe::EBinaryTypeEnumeration::Class:
+                write_string(m_leaf_classes[member.leaf].name);
+                write<int32_t>(m_library_id);
+                break;
+            default:
+                break;
+        }
+    }
+    write<int32_t>(m_library_id);
+    write_members(cls);
+}
+
+void NrbfGenerator::write_members(const ClassLayout& cls)
+{
+    for (const auto& member : cls.members)
+    {
+        switch (member.type)
+        {
+            case ufe::EBinaryTypeEnumeration::Primitive:
+                write_primitive(member.primitive);
+                break;
+            case ufe::EBinaryTypeEnumeration::String:
+                if (chance(m_options.null_percent))
+                {
+                    if (!m_string_ids.empty() && chance(50))
+                    {
+                        write_record_type(ufe::ERecordType::MemberReference);
+                        write<int32_t>(m_string_ids[m_rng() % m_string_ids.size()]);
+                    }
+                    else
+                    {
+                        write_record_type(ufe::ERecordType::ObjectNull);
+                    }
+                }
+                else
+                {
+                    write_object_string();
+                }
+                break;
+            case ufe::EBinaryTypeEnumeration::Class:
+                write_class(m_leaf_classes[member.leaf]);
+                break;
+            case ufe::EBinaryTypeEnumeration::StringArray:
+                write_string_array();
+                break;
+            case ufe::EBinaryTypeEnumeration::Object:
+                write_class_array(member.leaf);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void NrbfGenerator::write_primitive(ufe::EPrimitiveTypeEnumeration type)
+{
+    const auto r = m_rng();
+    switch (type)
+    {
+        case ufe::EPrimitiveTypeEnumeration::Boolean: write<bool>(r & 1); break;
+        case ufe::EPrimitiveTypeEnumeration::Byte: write<uint8_t>(static_cast<uint8_t>(r)); break;
+        case ufe::EPrimitiveTypeEnumeration::Double: write<double>((r % 100000) / 64.0); break;
+        case ufe::EPrimitiveTypeEnumeration::Int16: write<int16_t>(static_cast<int16_t>(r)); break;
+        case ufe::EPrimitiveTypeEnumeration::Int32: write<int32_t>(static_cast<int32_t>(r % 10000)); break;
+        case ufe::EPrimitiveTypeEnumeration::Int64: write<int64_t>(static_cast<int64_t>(r) << 8); break;
+        case ufe::EPrimitiveTypeEnumeration::Single: write<float>((r % 1000) / 8.0f); break;
+        case ufe::EPrimitiveTypeEnumeration::UInt16: write<uint16_t>(static_cast<uint16_t>(r)); break;
+        case ufe::EPrimitiveTypeEnumeration::UInt32: write<uint32_t>(r); break;
+        case ufe::EPrimitiveTypeEnumeration::UInt64: write<uint64_t>(static_cast<uint64_t>(r) << 16); break;
+        default:
+            write<int32_t>(static_cast<int32_t>(r));
+            break;
+    }
+}
+
+void NrbfGenerator::write_object_string()
+{
+    const int32_t id = m_next_id++;
+    const auto size = m_options.string_size / 2 + (m_options.string_size ? m_rng() % (m_options.string_size + 1) : 0);
+    write_record_type(ufe::ERecordType::BinaryObjectString);
+    write<int32_t>(id);
+    write_string(random_text(size));
+    m_string_ids.push_back(id);
+}
+
+void NrbfGenerator::write_string_array()
+{
+    write_record_type(ufe::ERecordType::ArraySingleString);
+    write<int32_t>(m_next_id++);
+    write<int32_t>(static_cast<int32_t>(m_options.array_length));
+    for (uint32_t i = 0; i < m_options.array_length; )
+    {
+        if (chance(m_options.null_percent))
+        {
+            i += write_null_run(m_options.array_length - i);
+        }
+        else
+        {
+            write_object_string();
+            ++i;
+        }
+    }
+}
+
+void NrbfGenerator::write_class_array(size_t leaf)
+{
+    write_record_type(ufe::ERecordType::BinaryArray);
+    write<int32_t>(m_next_id++);
+    write_byte(static_cast<uint8_t>(ufe::EBinaryArrayTypeEnumeration::Single));
+    write<int32_t>(1);
+    write<int32_t>(static_cast<int32_t>(m_options.array_length));
+    write_byte(static_cast<uint8_t>(ufe::EBinaryTypeEnumeration::Class));
+    write_string(m_leaf_classes[leaf].name);
+    write<int32_t>(m_library_id);
+    for (uint32_t i = 0; i < m_options.array_length; )
+    {
+        if (chance(m_options.null_percent))
+        {
+            i += write_null_run(m_options.array_length - i);
+        }
+        else
+        {
+            write_class(m_leaf_classes[leaf]);
+            ++i;
+        }
+    }
+}
+
+uint32_t NrbfGenerator::write_null_run(uint32_t remaining)
+{
+    const auto nulls = std::min<uint32_t>(remaining, 1 + m_rng() % 4);
+    if (nulls == 1)
+    {
+        write_record_type(ufe::ERecordType::ObjectNull);
+    }
+    else
+    {
+        write_record_type(ufe::ERecordType::ObjectNullMultiple256);
+        write_byte(static_cast<uint8_t>(nulls));
+    }
+    return nulls;
+}
+
+std::string NrbfGenerator::random_text(size_t size)
+{
+    static constexpr std::string_view alphabet = "abcdefghijklmnopqrstuvwxyz     ABCDEFGHIJKLMNOPQRSTUVWXYZ.,";
+    std::string text(size, ' ');
+    for (auto& c : text)
+    {
+        c = alphabet[m_rng() % alphabet.size()];
+    }
+    return text;
+}
+
+bool NrbfGenerator::chance(uint32_t percent)
+{
+    return percent && (m_rng() % 100) < percent;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "Records.hpp"
+
+struct GeneratorOptions
+{
+    uint32_t classes = 8;            // distinct root class layouts
+    uint32_t objects = 64;           // root objects, layouts repeat through ClassWithId
+    uint32_t primitive_members = 6;  // primitive members per class
+    uint32_t string_members = 2;     // BinaryObjectString members per class
+    uint32_t nested_members = 1;     // nested class members per class
+    uint32_t array_members = 1;      // string and class arrays, alternating
+    uint32_t string_size = 32;       // average string length
+    uint32_t array_length = 8;
+    uint32_t null_percent = 10;      // chance of null/reference in place of string or array element
+    bool compressed = true;
+    uint32_t seed = 1;
+};
+
+// Writes synthetic but valid NRBF streams in the layout of Underrail data files,
+// used by benchmarks to get inputs without game files.
+class NrbfGenerator
+{
+public:
+    explicit NrbfGenerator(const GeneratorOptions& options);
+
+    // NRBF stream only, as seen by BinaryFileParser after decompression
+    std::string generate_stream();
+    // 24 bytes header followed by gzip-wrapped or plain stream
+    std::string generate_file();
+    bool save(const std::filesystem::path& file_path);
+
+    // records written by the last generate call, MessageEnd included
+    uint64_t records() const noexcept { return m_records; }
+
+private:
+    struct MemberLayout
+    {
+        std::string name;
+        ufe::EBinaryTypeEnumeration type;
+        ufe::EPrimitiveTypeEnumeration primitive = ufe::EPrimitiveTypeEnumeration::Int32;
+        size_t leaf = 0; // index into m_leaf_classes for Class members and class arrays
+    };
+
+    struct ClassLayout
+    {
+        std::string name;
+        std::vector<MemberLayout> members;
+        int32_t metadata_id = 0; // id of the first emitted instance, 0 until written
+    };
+
+    void write_byte(uint8_t b) { m_out.push_back(static_cast<char>(b)); }
+    void write_record_type(ufe::ERecordType rec);
+    template <typename T>
+    void write(T value)
+    {
+        static_assert(std::is_fundamental_v<T>, "Only fundamental types allowed");
+        m_out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void write_string(std::string_view s);
+
+    void build_layouts();
+    void write_class(ClassLayout& cls);
+    void write_members(const ClassLayout& cls);
+    void write_primitive(ufe::EPrimitiveTypeEnumeration type);
+    void write_object_string();
+    void write_string_array();
+    void write_class_array(size_t leaf);
+    // ObjectNull or an ObjectNullMultiple256 run of up to 4 nulls, at most remaining, returns the nulls written
+    uint32_t write_null_run(uint32_t remaining);
+    std::string random_text(size_t size);
+    bool chance(uint32_t percent);
+
+    GeneratorOptions m_options;
+    std::mt19937 m_rng;
+    std::string m_out;
+    std::vector<ClassLayout> m_classes;
+    std::vector<ClassLayout> m_leaf_classes;
+    std::vector<int32_t> m_string_ids;
+    int32_t m_next_id = 1;
+    int32_t m_library_id = 0;
+    bool m_root_pending = false;
+    uint64_t m_records = 0;
+};
@@ -0,0 +1,188 @@
+#include "ParseCache.hpp"
+#include <spdlog/spdlog.h>
+#include "JsonWriter.hpp"
+#include "MemoryTracker.hpp"
+
+namespace
+{
+    double to_mb(uint64_t bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+}
+
+ParseCache::EntryPtr ParseCache::get(const fs::path& file, bool& hit)
+{
+    hit = false;
+    std::error_code ec;
+    const auto mtime = fs::last_write_time(file, ec);
+    const auto size = ec ? 0 : fs::file_size(file, ec);
+    if (ec)
+    {
+        spdlog::warn("File '{}' can't be read: {}", file.string(), ec.message());
+        return nullptr;
+    }
+    const auto file_key = key(file);
+    {
+        std::lock_guard lock{ m_mutex };
+        if (auto it = m_index.find(file_key); it != m_index.end())
+        {
+            auto entry = *it->second;
+            if (entry->mtime == mtime && entry->size == size)
+            {
+                ++m_hits;
+                m_lru.splice(m_lru.begin(), m_lru, it->second);
+                hit = true;
+                return entry;
+            }
+            if (entry->modified)
+            {
+                spdlog::warn("File '{}' changed on disk, edits not patched yet are dropped", file.string());
+            }
+            ++m_reloads;
+            m_bytes -= entry->bytes;
+            m_lru.erase(it->second);
+            m_index.erase(it);
+        }
+        ++m_misses;
+    }
+
+    // parsed outside the lock, other files are served meanwhile
+    auto entry = std::make_shared<Entry>();
+    entry->file = file;
+    entry->mtime = mtime;
+    entry->size = size;
+    const auto memory = MemoryTracker::file_begin();
+    if (!entry->parser.open(file))
+    {
+        return nullptr;
+    }
+    entry->parser.read_records();
+    if (entry->parser.status() == BinaryFileParser::EFileStatus::Invalid ||
+        entry->parser.status() == BinaryFileParser::EFileStatus::Empty)
+    {
+        spdlog::warn("File '{}' can't be parsed", file.string());
+        return nullptr;
+    }
+    entry->bytes = static_cast<uint64_t>(std::max<int64_t>(MemoryTracker::file_end(memory).retained, 0));
+
+    std::lock_guard lock{ m_mutex };
+    // same file may have been parsed by another request meanwhile
+    if (auto it = m_index.find(file_key); it != m_index.end())
+    {
+        m_bytes -= (*it->second)->bytes;
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+    m_lru.push_front(entry);
+    m_index[file_key] = m_lru.begin();
+    m_bytes += entry->bytes;
+    m_peak = std::max(m_peak, m_bytes);
+    evict_locked(entry.get());
+    return entry;
+}
+
+nlohmann::ordered_json& ParseCache::json(Entry& entry)
+{
+    if (!entry.json)
+    {
+        const auto memory = MemoryTracker::file_begin();
+        JsonWriter writer;
+        entry.json = writer.to_json(entry.parser.get_records());
+        grow(entry, static_cast<uint64_t>(std::max<int64_t>(MemoryTracker::file_end(memory).retained, 0)));
+    }
+    return *entry.json;
+}
+
+void ParseCache::invalidate(const fs::path& file)
+{
+    std::lock_guard lock{ m_mutex };
+    if (auto it = m_index.find(key(file)); it != m_index.end())
+    {
+        m_bytes -= (*it->second)->bytes;
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+}
+
+void ParseCache::clear()
+{
+    std::lock_guard lock{ m_mutex };
+    m_lru.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+std::string ParseCache::key(const fs::path& file)
+{
+    std::error_code ec;
+    auto absolute = fs::absolute(file, ec);
+    return (ec ? file : absolute).lexically_normal().string();
+}
+
+void ParseCache::grow(const Entry& entry, uint64_t bytes)
+{
+    std::lock_guard lock{ m_mutex };
+    const auto it = m_index.find(key(entry.file));
+    if (it == m_index.end() || it->second->get() != &entry)
+    {
+        // evicted or replaced meanwhile, freed with its last request
+        return;
+    }
+    (*it->second)->bytes += bytes;
+    m_bytes += bytes;
+    m_peak = std::max(m_peak, m_bytes);
+    evict_locked(&entry);
+}
+
+void ParseCache::evict_locked(const Entry* keep)
+{
+    auto it = m_lru.end();
+    while (m_bytes > m_limit && it != m_lru.begin())
+    {
+        --it;
+        if (it->get() == keep || (*it)->modified)
+        {
+            continue;
+        }
+        spdlog::debug("Evicting '{}' from cache", (*it)->file.string());
+        m_bytes -= (*it)->bytes;
+        ++m_evictions;
+        m_index.erase(key((*it)->file));
+        it = m_lru.erase(it);
+    }
+    if (m_bytes > m_limit)
+    {
+        spdlog::debug("Cache {:.2f} MB over its limit, the remaining files have edits that weren't patched yet", to_mb(m_bytes - m_limit));
+    }
+}
+
+bool ParseCache::full() const
+{
+    std::lock_guard lock{ m_mutex };
+    return m_bytes > m_limit;
+}
+
+void ParseCache::print() const
+{
+    std::lock_guard lock{ m_mutex };
+    const auto lookups = m_hits + m_misses;
+    spdlog::info("Cache {} files, {:.2f} MB of {:.2f} MB, peak {:.2f} MB", m_lru.size(), to_mb(m_bytes), to_mb(m_limit), to_mb(m_peak));
+    spdlog::info("Cache {} hits, {} misses ({:.1f}% hit rate), {} reloads of changed files, {} evictions",
+        m_hits, m_misses, lookups ? 100.0 * m_hits / lookups : 0.0, m_reloads, m_evictions);
+}
+
+nlohmann::ordered_json ParseCache::to_json() const
+{
+    std::lock_guard lock{ m_mutex };
+    nlohmann::ordered_json js = nlohmann::ordered_json::value_t::object;
+    js["files"] = m_lru.size();
+    js["bytes"] = m_bytes;
+    js["limit"] = m_limit;
+    js["peak"] = m_peak;
+    js["hits"] = m_hits;
+    js["misses"] = m_misses;
+    js["reloads"] = m_reloads;
+    js["evictions"] = m_evictions;
+    return js;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "BinaryFileParser.hpp"
+
+// Parsed files kept between requests of the serve mode, least recently used
+// files are dropped once the cache grows over its memory limit. Entries are
+// checked against file modification time and size on every lookup and parsed
+// again when the file changed on disk. Entries with edits that weren't patched
+// yet are never evicted, new edits are refused while they alone keep the cache
+// over its limit.
+class ParseCache
+{
+public:
+    struct Entry
+    {
+        std::filesystem::path file;
+        std::filesystem::file_time_type mtime;
+        uintmax_t size = 0;
+        BinaryFileParser parser;
+        // export document, built on first use and edited in place by set requests
+        std::optional<nlohmann::ordered_json> json;
+        std::atomic<bool> modified{ false }; // edited by set requests and not patched yet
+        uint64_t bytes = 0;
+        // requests on the same file run one at a time
+        std::mutex mutex;
+    };
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    // limit in bytes, heap usage of entries is measured with MemoryTracker, it has to be enabled
+    explicit ParseCache(uint64_t limit) : m_limit{ limit } {}
+
+    // parsed file, nullptr when it can't be read or isn't a supported NRBF file
+    EntryPtr get(const std::filesystem::path& file, bool& hit);
+    // builds the export document of an entry, lock the entry first
+    nlohmann::ordered_json& json(Entry& entry);
+    // entry is parsed again on next lookup, edits not patched yet are dropped
+    void invalidate(const std::filesystem::path& file);
+    void clear();
+    // over the limit with only entries holding edits that weren't patched yet left
+    bool full() const;
+
+    // hits, misses, evictions and memory, logged at info level
+    void print() const;
+    nlohmann::ordered_json to_json() const;
+private:
+    static std::string key(const std::filesystem::path& file);
+    // entry grew after it was inserted, evicts others when needed
+    void grow(const Entry& entry, uint64_t bytes);
+    void evict_locked(const Entry* keep);
+
+    const uint64_t m_limit;
+    mutable std::mutex m_mutex;
+    std::list<EntryPtr> m_lru; // most recently used first
+    std::unordered_map<std::string, std::list<EntryPtr>::iterator> m_index;
+    uint64_t m_bytes = 0;
+    uint64_t m_peak = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_reloads = 0;
+    uint64_t m_evictions = 0;
+};
@@ -0,0 +1,356 @@
+#include "Patch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <utility>
+#include <spdlog/spdlog.h>
+#include "BinaryFileWriter.hpp"
+
+namespace fs = std::filesystem;
+using ojson = nlohmann::ordered_json;
+
+namespace
+{
+    constexpr std::string_view patch_header = "UFEPATCH 1";
+
+    // little endian bytes of value as T, false if value doesn't fit
+    template <typename T>
+    bool encode(const ojson& value, std::string& bytes)
+    {
+        T v{};
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            if (!value.is_boolean())
+            {
+                return false;
+            }
+            v = value.get<bool>();
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            if (!value.is_number())
+            {
+                return false;
+            }
+            const auto d = value.get<double>();
+            if (!std::isfinite(d) || std::abs(d) > std::numeric_limits<T>::max())
+            {
+                return false;
+            }
+            v = static_cast<T>(d);
+        }
+        else if (value.is_number_unsigned())
+        {
+            const auto u = value.get<uint64_t>();
+            if (!std::in_range<T>(u))
+            {
+                return false;
+            }
+            v = static_cast<T>(u);
+        }
+        else if (value.is_number_integer())
+        {
+            const auto i = value.get<int64_t>();
+            if (!std::in_range<T>(i))
+            {
+                return false;
+            }
+            v = static_cast<T>(i);
+        }
+        else
+        {
+            return false;
+        }
+        bytes.append(reinterpret_cast<const char*>(&v), sizeof(v));
+        return true;
+    }
+
+    bool encode_value(std::string_view type, const ojson& value, std::string& bytes)
+    {
+        if (type == "bool") return encode<bool>(value, bytes);
+        if (type == "char") return encode<int8_t>(value, bytes);
+        if (type == "uint8") return encode<uint8_t>(value, bytes);
+        if (type == "int16") return encode<int16_t>(value, bytes);
+        if (type == "uint16") return encode<uint16_t>(value, bytes);
+        if (type == "int32") return encode<int32_t>(value, bytes);
+        if (type == "uint32") return encode<uint32_t>(value, bytes);
+        if (type == "int64") return encode<int64_t>(value, bytes);
+        if (type == "uint64") return encode<uint64_t>(value, bytes);
+        if (type == "float") return encode<float>(value, bytes);
+        if (type == "double") return encode<double>(value, bytes);
+        return false;
+    }
+
+    // bytes of the length prefixed string at offset including its prefix, 0 if it doesn't fit the stream
+    uint64_t string_size(std::string_view stream, uint64_t offset)
+    {
+        uint64_t len = 0;
+        for (uint64_t pos = offset, shift = 0; pos < stream.size() && shift < 35; ++pos, shift += 7)
+        {
+            const auto seg = static_cast<uint8_t>(stream[pos]);
+            len |= static_cast<uint64_t>(seg & 0x7F) << shift;
+            if (!(seg & 0x80))
+            {
+                const auto size = pos + 1 - offset + len;
+                return offset + size <= stream.size() ? size : 0;
+            }
+        }
+        return 0;
+    }
+}
+
+bool Patch::use_patch(const fs::path& json_path, const fs::path& patch_path)
+{
+    std::error_code ec;
+    if (!fs::is_regular_file(patch_path, ec))
+    {
+        return false;
+    }
+    const auto json_time = fs::last_write_time(json_path, ec);
+    return ec || fs::last_write_time(patch_path, ec) >= json_time;
+}
+
+bool Patch::fits(const MerkleTree::Node& node, const ojson& value)
+{
+    if (node.kind == MerkleTree::EKind::String)
+    {
+        return value.is_string();
+    }
+    std::string bytes;
+    return node.kind == MerkleTree::EKind::Value && encode_value(node.type, value, bytes) && bytes.size() == node.size;
+}
+
+bool Patch::load(const fs::path& patch_path)
+{
+    m_edits.clear();
+    std::ifstream in{ patch_path };
+    if (!in)
+    {
+        spdlog::error("Could not open patch '{}'", patch_path.string());
+        return false;
+    }
+    bool header = false;
+    size_t number = 0;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        ++number;
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.empty() || line.starts_with('#'))
+        {
+            continue;
+        }
+        if (!header)
+        {
+            if (line != patch_header)
+            {
+                spdlog::error("'{}' is not a patch file", patch_path.string());
+                return false;
+            }
+            header = true;
+            continue;
+        }
+        const auto first = line.find('\t');
+        const auto second = first == std::string::npos ? first : line.find('\t', first + 1);
+        if (second == std::string::npos)
+        {
+            spdlog::error("Line {} of '{}' is not '<path>\\t<old value>\\t<new value>'", number, patch_path.string());
+            return false;
+        }
+        try
+        {
+            m_edits.push_back({ line.substr(0, first), ojson::parse(line.substr(first + 1, second - first - 1)),
+                ojson::parse(line.substr(second + 1)) });
+        }
+        catch (std::exception& e)
+        {
+            spdlog::error("Line {} of '{}' has an invalid value: {}", number, patch_path.string(), e.what());
+            return false;
+        }
+    }
+    if (!header)
+    {
+        spdlog::error("'{}' is not a patch file", patch_path.string());
+    }
+    return header;
+}
+
+bool Patch::save(const fs::path& patch_path) const
+{
+    std::ofstream out{ patch_path, std::ios::binary };
+    if (!out)
+    {
+        spdlog::error("Could not save patch '{}'", patch_path.string());
+        return false;
+    }
+    try
+    {
+        out << patch_header << '\n';
+        for (const auto& edit : m_edits)
+        {
+            out << edit.path << '\t' << edit.old_value.dump() << '\t' << edit.new_value.dump() << '\n';
+        }
+    }
+    catch (std::exception& e)
+    {
+        spdlog::error("Could not save patch '{}': {}", patch_path.string(), e.what());
+        return false;
+    }
+    return static_cast<bool>(out);
+}
+
+void Patch::from_json(const MerkleTree& tree, const ojson& doc)
+{
+    m_edits.clear();
+    for (auto& edit : tree.json_edits(doc))
+    {
+        m_edits.push_back({ tree.address(edit.node), tree.value(edit.node), std::move(edit.value) });
+    }
+}
+
+bool Patch::load_json(const MerkleTree& tree, const fs::path& json_path)
+{
+    ojson doc;
+    try
+    {
+        std::ifstream in{ json_path };
+        in >> doc;
+    }
+    catch (std::exception& e)
+    {
+        spdlog::error("Failed to parse json file '{}': {}", json_path.string(), e.what());
+        return false;
+    }
+    from_json(tree, doc);
+    return true;
+}
+
+Patch::Result Patch::apply(const fs::path& binary_path, const BinaryFileParser& parser, FileStats* stats) const
+{
+    if (parser.status() == BinaryFileParser::EFileStatus::Invalid || parser.status() == BinaryFileParser::EFileStatus::Empty)
+    {
+        spdlog::warn("File '{}' not valid for patching", binary_path.string());
+        Result result;
+        ++result.failed;
+        return result;
+    }
+    StageTimer tree_timer{ stats, EStage::Patch };
+    MerkleTree tree;
+    tree.build(parser.get_records());
+    tree_timer.stop();
+    return apply(binary_path, parser, tree, stats);
+}
+
+Patch::Result Patch::apply(const fs::path& binary_path, const BinaryFileParser& parser, const MerkleTree& tree, FileStats* stats) const
+{
+    Result result;
+    StageTimer patch_timer{ stats, EStage::Patch };
+    const auto stream = parser.stream();
+
+    // new bytes for [offset, offset + size) of the stream
+    struct Splice
+    {
+        uint64_t offset;
+        uint64_t size;
+        std::string bytes;
+        const Edit* edit;
+    };
+    std::vector<Splice> splices;
+    for (const auto& edit : m_edits)
+    {
+        const auto node = edit.path.empty() ? 0 : tree.find(edit.path);
+        const auto& n = tree.nodes()[node];
+        if (!node || (n.kind != MerkleTree::EKind::Value && n.kind != MerkleTree::EKind::String))
+        {
+            spdlog::warn("'{}' of '{}' is not a value or string", edit.path, binary_path.string());
+            ++result.failed;
+            continue;
+        }
+        if (tree.equals(node, edit.new_value))
+        {
+            ++result.unchanged;
+            continue;
+        }
+        if (!tree.equals(node, edit.old_value))
+        {
+            spdlog::warn("'{}' of '{}' is {}, patch expects {}", edit.path, binary_path.string(), tree.value(node).dump(),
+                edit.old_value.dump());
+            ++result.mismatched;
+            continue;
+        }
+        Splice splice{ n.offset, n.size, {}, &edit };
+        bool encoded = false;
+        if (n.kind == MerkleTree::EKind::String)
+        {
+            splice.size = string_size(stream, n.offset);
+            encoded = splice.size && edit.new_value.is_string();
+            if (encoded)
+            {
+                BinaryFileWriter::append_string(splice.bytes, edit.new_value.get_ref<const std::string&>());
+            }
+        }
+        else
+        {
+            encoded = encode_value(n.type, edit.new_value, splice.bytes) && splice.bytes.size() == n.size;
+        }
+        if (!encoded)
+        {
+            spdlog::warn("'{}' of '{}' can't be set to {}", edit.path, binary_path.string(), edit.new_value.dump());
+            ++result.failed;
+            continue;
+        }
+        splices.push_back(std::move(splice));
+    }
+    std::sort(splices.begin(), splices.end(), [](const Splice& a, const Splice& b) { return a.offset < b.offset; });
+    for (size_t i = 1; i < splices.size(); ++i)
+    {
+        if (splices[i].offset < splices[i - 1].offset + splices[i - 1].size)
+        {
+            spdlog::warn("'{}' of '{}' is patched twice", splices[i].edit->path, binary_path.string());
+            ++result.failed;
+        }
+    }
+    if (result.failed || result.mismatched)
+    {
+        spdlog::error("File '{}' not patched, {} edits don't match and {} can't be applied", binary_path.string(),
+            result.mismatched, result.failed);
+        return result;
+    }
+    if (splices.empty())
+    {
+        spdlog::info("File '{}' already patched", binary_path.string());
+        result.ok = true;
+        return result;
+    }
+
+    // one pass over the stream, unchanged bytes between splices are copied as they are
+    std::string patched;
+    size_t grown = 0;
+    for (const auto& splice : splices)
+    {
+        grown += splice.bytes.size();
+    }
+    patched.reserve(stream.size() + grown);
+    uint64_t pos = 0;
+    for (const auto& splice : splices)
+    {
+        patched.append(stream.substr(pos, splice.offset - pos));
+        patched.append(splice.bytes);
+        pos = splice.offset + splice.size;
+    }
+    patched.append(stream.substr(pos));
+    patch_timer.stop();
+
+    spdlog::info("Patching file '{}', {} members", binary_path.string(), splices.size());
+    BinaryFileWriter writer;
+    writer.set_stats(stats);
+    result.written = writer.save(binary_path, parser.header(), std::string_view{ patched },
+        parser.file_type() == BinaryFileParser::EFileType::Compressed);
+    result.applied = result.written ? splices.size() : 0;
+    result.ok = result.written;
+    return result;
+}
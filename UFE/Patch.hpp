@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "BinaryFileParser.hpp"
+#include "MerkleTree.hpp"
+#include "Stats.hpp"
+
+// Field level edits of one binary, a compact alternative to patching with a full
+// json export. A patch is a text file, '<binary>.ufepatch' next to the binary:
+//
+//   UFEPATCH 1
+//   # comment
+//   <member path>\t<old value>\t<new value>
+//
+// Paths are MerkleTree member paths, usually '@<id>' of the root record followed
+// by members and elements ('@7.m_array0[3].m_value1'), values are json. Applying
+// resolves every path against the parsed file, checks that the member still has
+// the old value and splices all new values into the decoded stream in a single
+// pass; only strings change length and NRBF keeps no offsets that would have to
+// follow them. Nothing is written when an edit can't be applied.
+class Patch
+{
+public:
+    struct Edit
+    {
+        std::string path;
+        nlohmann::ordered_json old_value;
+        nlohmann::ordered_json new_value;
+    };
+    struct Result
+    {
+        size_t applied = 0;
+        size_t unchanged = 0;  // member already has the new value
+        size_t mismatched = 0; // member has neither the old nor the new value
+        size_t failed = 0;     // path not found, member not patchable or value out of range
+        bool written = false;
+        bool ok = false;       // every member has its new value now
+    };
+
+    // edits of 'x.ufepatch' are used for 'x.json' unless the json was saved after them
+    static bool use_patch(const std::filesystem::path& json_path, const std::filesystem::path& patch_path);
+
+    // value can be written to a value or string node
+    static bool fits(const MerkleTree::Node& node, const nlohmann::ordered_json& value);
+
+    bool load(const std::filesystem::path& patch_path);
+    bool save(const std::filesystem::path& patch_path) const;
+    // members of doc, an edited export of the tree's file, that differ from the file
+    void from_json(const MerkleTree& tree, const nlohmann::ordered_json& doc);
+    bool load_json(const MerkleTree& tree, const std::filesystem::path& json_path);
+    // parser has to keep its records, binary_path is rewritten when every edit applies
+    Result apply(const std::filesystem::path& binary_path, const BinaryFileParser& parser, FileStats* stats) const;
+    // same with the tree of the parser's records at hand
+    Result apply(const std::filesystem::path& binary_path, const BinaryFileParser& parser, const MerkleTree& tree,
+        FileStats* stats) const;
+
+    const std::vector<Edit>& edits() const noexcept { return m_edits; }
+    std::vector<Edit>& edits() noexcept { return m_edits; }
+private:
+    std::vector<Edit> m_edits;
+};
@@ -0,0 +1,62 @@
+#include "Pipeline.hpp"
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    double to_ms(std::chrono::nanoseconds t)
+    {
+        return std::chrono::duration<double, std::milli>(t).count();
+    }
+}
+
+void job_failed(std::string_view stage, std::string_view job, std::string_view reason)
+{
+    spdlog::error("Stage '{}' failed on '{}': {}", stage, job, reason);
+}
+
+void PipelineReport::print() const
+{
+    spdlog::info("Pipeline wall time {:.2f} ms", to_ms(wall));
+    spdlog::info("{:<14}{:>9}{:>8}{:>12}{:>8}", "stage", "workers", "jobs", "busy [ms]", "util %");
+    for (const auto& stage : stages)
+    {
+        spdlog::info("{:<14}{:>9}{:>8}{:>12.2f}{:>8.1f}", stage.name, stage.workers, stage.jobs,
+            to_ms(stage.busy), 100.0 * stage.utilization);
+    }
+    spdlog::info("{:<18}{:>6}{:>6}{:>8}{:>14}{:>14}", "queue", "size", "max", "avg", "push wait", "pop wait");
+    for (const auto& queue : queues)
+    {
+        spdlog::info("{:<18}{:>6}{:>6}{:>8.1f}{:>14.2f}{:>14.2f}", queue.name, queue.stats.capacity, queue.stats.max_depth,
+            queue.stats.avg_depth, to_ms(queue.stats.push_wait), to_ms(queue.stats.pop_wait));
+    }
+}
+
+nlohmann::ordered_json PipelineReport::to_json() const
+{
+    nlohmann::ordered_json js = nlohmann::ordered_json::value_t::object;
+    js["wall_ms"] = to_ms(wall);
+    js["stages"] = nlohmann::ordered_json::value_t::array;
+    for (const auto& stage : stages)
+    {
+        js["stages"].push_back({
+            { "name", stage.name },
+            { "workers", stage.workers },
+            { "jobs", stage.jobs },
+            { "busy_ms", to_ms(stage.busy) },
+            { "utilization", stage.utilization }
+        });
+    }
+    js["queues"] = nlohmann::ordered_json::value_t::array;
+    for (const auto& queue : queues)
+    {
+        js["queues"].push_back({
+            { "name", queue.name },
+            { "capacity", queue.stats.capacity },
+            { "max_depth", queue.stats.max_depth },
+            { "avg_depth", queue.stats.avg_depth },
+            { "push_wait_ms", to_ms(queue.stats.push_wait) },
+            { "pop_wait_ms", to_ms(queue.stats.pop_wait) }
+        });
+    }
+    return js;
+}
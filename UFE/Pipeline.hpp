@@ -0,0 +1,210 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "BoundedQueue.hpp"
+
+struct PipelineReport
+{
+    struct Stage
+    {
+        std::string name;
+        size_t workers = 0;
+        uint64_t jobs = 0;
+        std::chrono::nanoseconds busy{};
+        double utilization = 0.0; // busy time over wall time of all workers
+    };
+    struct Queue
+    {
+        std::string name;
+        QueueStats stats;
+    };
+    std::chrono::nanoseconds wall{};
+    std::vector<Stage> stages;
+    std::vector<Queue> queues;
+
+    // stage utilization and queue depths, logged at info level
+    void print() const;
+    nlohmann::ordered_json to_json() const;
+};
+
+// logs a job that threw, at error level
+void job_failed(std::string_view stage, std::string_view job, std::string_view reason);
+
+// f() with its exceptions logged against job, false after an exception
+template<class F, class Name>
+bool run_guarded(std::string_view stage, Name&& job, F&& f)
+{
+    try
+    {
+        return f();
+    }
+    catch (const std::exception& e)
+    {
+        job_failed(stage, job(), e.what());
+    }
+    catch (...)
+    {
+        job_failed(stage, job(), "unknown exception");
+    }
+    return false;
+}
+
+// Runs jobs through stages connected by bounded queues, every stage has its own
+// worker threads. Jobs are created by the first stage, a stage returning false
+// or throwing drops the job. Order between jobs is not kept.
+template<class Job>
+class Pipeline
+{
+public:
+    explicit Pipeline(size_t queue_depth) : m_queue_depth{ queue_depth } {}
+
+    void add_stage(std::string name, size_t workers, std::function<bool(Job&)> run)
+    {
+        m_stages.push_back({ std::move(name), std::max<size_t>(workers, 1), std::move(run) });
+    }
+
+    // names a job in the log when a stage throws on it
+    void set_job_name(std::function<std::string(const Job&)> name)
+    {
+        m_job_name = std::move(name);
+    }
+
+    // blocks until all count jobs passed every stage or were dropped
+    PipelineReport run(size_t count, std::function<Job(size_t)> make_job)
+    {
+        const auto stage_count = m_stages.size();
+        std::vector<std::unique_ptr<BoundedQueue<Job>>> queues;
+        for (size_t i = 1; i < stage_count; ++i)
+        {
+            queues.emplace_back(std::make_unique<BoundedQueue<Job>>(m_queue_depth));
+        }
+        struct Counters
+        {
+            std::atomic<size_t> workers_left{ 0 };
+            std::atomic<uint64_t> jobs{ 0 };
+            std::atomic<int64_t> busy_ns{ 0 };
+        };
+        std::vector<Counters> counters(stage_count);
+        std::atomic<size_t> next_job{ 0 };
+
+        auto worker = [&](size_t stage)
+            {
+                auto& s = m_stages[stage];
+                auto& c = counters[stage];
+                auto take = [&](Job& job)
+                    {
+                        if (stage == 0)
+                        {
+                            for (;;)
+                            {
+                                const auto index = next_job.fetch_add(1, std::memory_order_relaxed);
+                                if (index >= count)
+                                {
+                                    return false;
+                                }
+                                if (run_guarded(s.name, [index] { return "job " + std::to_string(index); }, [&] { job = make_job(index); return true; }))
+                                {
+                                    return true;
+                                }
+                            }
+                        }
+                        return queues[stage - 1]->pop(job);
+                    };
+                Job job;
+                auto job_name = [this, &job] { return m_job_name ? m_job_name(job) : std::string{ "job" }; };
+                while (take(job))
+                {
+                    const auto start = std::chrono::steady_clock::now();
+                    const bool keep = run_guarded(s.name, job_name, [&] { return s.run(job); });
+                    c.busy_ns.fetch_add((std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+                    c.jobs.fetch_add(1, std::memory_order_relaxed);
+                    if (keep && stage + 1 < stage_count)
+                    {
+                        queues[stage]->push(std::move(job));
+                    }
+                    job = Job{};
+                }
+                // last worker of a stage tells the next one nothing else is coming
+                if (c.workers_left.fetch_sub(1, std::memory_order_acq_rel) == 1 && stage + 1 < stage_count)
+                {
+                    queues[stage]->close();
+                }
+            };
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for (size_t stage = 0; stage < stage_count; ++stage)
+            {
+                counters[stage].workers_left = m_stages[stage].workers;
+            }
+            for (size_t stage = 0; stage < stage_count; ++stage)
+            {
+                for (size_t i = 0; i < m_stages[stage].workers; ++i)
+                {
+                    threads.emplace_back(worker, stage);
+                }
+            }
+        }
+
+        PipelineReport report;
+        report.wall = std::chrono::steady_clock::now() - start;
+        for (size_t stage = 0; stage < stage_count; ++stage)
+        {
+            PipelineReport::Stage s;
+            s.name = m_stages[stage].name;
+            s.workers = m_stages[stage].workers;
+            s.jobs = counters[stage].jobs;
+            s.busy = std::chrono::nanoseconds{ counters[stage].busy_ns.load() };
+            const double capacity = static_cast<double>(report.wall.count()) * s.workers;
+            s.utilization = capacity > 0.0 ? s.busy.count() / capacity : 0.0;
+            report.stages.push_back(std::move(s));
+            if (stage + 1 < stage_count)
+            {
+                report.queues.push_back({ m_stages[stage].name + "->" + m_stages[stage + 1].name, queues[stage]->stats() });
+            }
+        }
+        return report;
+    }
+private:
+    struct Stage
+    {
+        std::string name;
+        size_t workers;
+        std::function<bool(Job&)> run;
+    };
+    size_t m_queue_depth;
+    std::vector<Stage> m_stages;
+    std::function<std::string(const Job&)> m_job_name;
+};
+
+// Calls f(i) for every i below count on up to threads threads, the calling thread
+// included. Items are handed out one by one, results should go to slot i.
+// An item that throws is logged and the others still run.
+template<class F>
+void parallel_for(size_t count, size_t threads, F&& f)
+{
+    std::atomic<size_t> next = 0;
+    auto worker = [&]
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            run_guarded("parallel_for", [i] { return "item " + std::to_string(i); }, [&] { f(i); return true; });
+        }
+    };
+    std::vector<std::jthread> workers;
+    for (size_t i = 1; i < std::min(threads, count); ++i)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+}
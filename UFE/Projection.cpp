@@ -0,0 +1,108 @@
+#include "Projection.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+bool Projection::add(std::string_view pattern)
+{
+    // class names contain dots, members are separated from the class by ':'
+    Pattern p;
+    const auto colon = pattern.find(':');
+    p.class_name = pattern.substr(0, colon);
+    if (colon != std::string_view::npos)
+    {
+        auto path = pattern.substr(colon + 1);
+        while (!path.empty())
+        {
+            const auto dot = path.find('.');
+            p.members.emplace_back(path.substr(0, dot));
+            path = dot == std::string_view::npos ? std::string_view{} : path.substr(dot + 1);
+        }
+    }
+    if (p.class_name.empty() || (colon != std::string_view::npos && p.members.empty()) ||
+        std::find(p.members.cbegin(), p.members.cend(), std::string{}) != p.members.cend())
+    {
+        spdlog::error("Invalid selection '{}', expected '<class>[:<member>.<member>...]'", pattern);
+        return false;
+    }
+    m_patterns.emplace_back(std::move(p));
+    return true;
+}
+
+Projection::Scope Projection::select_class(std::string_view class_name) const
+{
+    Scope scope;
+    for (uint32_t i = 0; i < m_patterns.size(); ++i)
+    {
+        const auto& p = m_patterns[i];
+        if (glob_match(p.class_name, class_name))
+        {
+            if (p.members.empty())
+            {
+                scope.all = true;
+                scope.paths.clear();
+                break;
+            }
+            scope.paths.push_back({ i, 0 });
+        }
+    }
+    return scope;
+}
+
+Projection::Scope Projection::select_member(const Scope& scope, std::string_view member_name) const
+{
+    Scope member;
+    member.all = scope.all;
+    if (scope.all)
+    {
+        return member;
+    }
+    for (const auto& path : scope.paths)
+    {
+        const auto& members = m_patterns[path.pattern].members;
+        if (glob_match(members[path.depth], member_name))
+        {
+            if (path.depth + 1 == members.size())
+            {
+                member.all = true;
+                member.paths.clear();
+                break;
+            }
+            member.paths.push_back({ path.pattern, path.depth + 1 });
+        }
+    }
+    return member;
+}
+
+bool Projection::glob_match(std::string_view pattern, std::string_view text)
+{
+    // iterative matcher, backtracks only to the last '*'
+    size_t p = 0, t = 0;
+    size_t star = std::string_view::npos, star_t = 0;
+    while (t < text.size())
+    {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t]))
+        {
+            ++p;
+            ++t;
+        }
+        else if (p < pattern.size() && pattern[p] == '*')
+        {
+            star = p++;
+            star_t = t;
+        }
+        else if (star != std::string_view::npos)
+        {
+            p = star + 1;
+            t = ++star_t;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+    {
+        ++p;
+    }
+    return p == pattern.size();
+}
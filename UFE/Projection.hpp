@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Record selection pushed down into BinaryFileParser by --select.
+// A pattern is '<class glob>[:<member>.<member>...]', member names may be globs
+// too, '*' matches any run of characters and '?' a single one. Class records
+// matching a pattern are emitted with the selected members only, everything
+// else is walked to keep the stream position but never turned into values.
+class Projection
+{
+public:
+    // selected part of one record, members are matched against the remaining paths
+    struct Scope
+    {
+        struct Path
+        {
+            uint32_t pattern;
+            uint32_t depth; // index of the member name to match next
+        };
+        bool all = false; // whole subtree selected
+        std::vector<Path> paths;
+
+        bool selected() const noexcept { return all || !paths.empty(); }
+    };
+
+    bool add(std::string_view pattern);
+    bool empty() const noexcept { return m_patterns.empty(); }
+
+    Scope select_class(std::string_view class_name) const;
+    Scope select_member(const Scope& scope, std::string_view member_name) const;
+
+    static bool glob_match(std::string_view pattern, std::string_view text);
+private:
+    struct Pattern
+    {
+        std::string class_name;
+        std::vector<std::string> members;
+    };
+    std::vector<Pattern> m_patterns;
+};
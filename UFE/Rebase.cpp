@@ -0,0 +1,315 @@
+#include "Rebase.hpp"
+#include <fstream>
+#include <iomanip>
+#include <unordered_map>
+#include <spdlog/spdlog.h>
+#include "FileRoots.hpp"
+#include "JsonWriter.hpp"
+#include "Pipeline.hpp"
+#include "Report.hpp"
+
+namespace fs = std::filesystem;
+using ojson = nlohmann::ordered_json;
+
+namespace
+{
+    // json value of node in an export of tree, nullptr if it isn't there
+    ojson* locate(ojson& doc, const MerkleTree& tree, uint32_t node, const std::unordered_map<int32_t, size_t>& records)
+    {
+        std::vector<uint32_t> chain;
+        for (uint32_t n = node; n != 0; n = tree.nodes()[n].parent)
+        {
+            chain.push_back(n);
+        }
+        const auto record = records.find(tree.nodes()[chain.back()].object_id);
+        if (record == records.end())
+        {
+            return nullptr;
+        }
+        ojson* json = &doc["records"][record->second];
+        for (size_t i = chain.size() - 1; i > 0; --i)
+        {
+            const auto& parent = tree.nodes()[chain[i]];
+            const auto& child = tree.nodes()[chain[i - 1]];
+            if (parent.kind == MerkleTree::EKind::Class)
+            {
+                auto* members = MerkleTree::class_members(*json);
+                const auto name = std::string{ child.name };
+                if (!members || !members->contains(name))
+                {
+                    return nullptr;
+                }
+                json = &(*members)[name];
+            }
+            else
+            {
+                size_t position = 0;
+                if (!json->contains("values") || !MerkleTree::element_position((*json)["values"], child.index, position))
+                {
+                    return nullptr;
+                }
+                json = &(*json)["values"][position];
+            }
+        }
+        if (tree.nodes()[node].kind == MerkleTree::EKind::String)
+        {
+            return json->contains("value") ? &(*json)["value"] : nullptr;
+        }
+        return json;
+    }
+
+    // root record of new_tree standing for root of old_tree: same content, same object id or same position
+    uint32_t match_root(const MerkleTree& old_tree, uint32_t root, const MerkleTree& new_tree,
+        const std::unordered_multimap<uint64_t, uint32_t>& new_roots)
+    {
+        const auto& r = old_tree.nodes()[root];
+        uint32_t by_hash = 0;
+        const auto [first, last] = new_roots.equal_range(r.hash);
+        for (auto it = first; it != last; ++it)
+        {
+            const auto& candidate = new_tree.nodes()[it->second];
+            if (candidate.name != r.name)
+            {
+                continue;
+            }
+            // identical records, prefer the one that kept its id
+            if (!by_hash || candidate.object_id == r.object_id)
+            {
+                by_hash = it->second;
+            }
+        }
+        if (by_hash)
+        {
+            return by_hash;
+        }
+        const auto by_id = new_tree.object(r.object_id);
+        if (by_id && new_tree.nodes()[by_id].parent == 0 && new_tree.nodes()[by_id].name == r.name)
+        {
+            return by_id;
+        }
+        return new_tree.child(0, r.name, r.index);
+    }
+}
+
+bool Rebase::run(const fs::path& old_root, const fs::path& mod_root, const fs::path& new_root, const fs::path& out_root, size_t threads)
+{
+    m_files.clear();
+    // old and new binary of every mod
+    std::vector<std::pair<fs::path, fs::path>> binaries;
+    auto add = [&](const fs::path& mod, const fs::path& old_file, const fs::path& new_file, fs::path out)
+    {
+        if (out.empty())
+        {
+            out = new_file;
+            out += ".json";
+        }
+        binaries.emplace_back(old_file, new_file);
+        auto& file = m_files.emplace_back();
+        file.mod = mod;
+        file.out = std::move(out);
+    };
+    const auto kind = root_kind({ old_root, mod_root, new_root });
+    if (!kind)
+    {
+        return false;
+    }
+    if (*kind == ERootKind::Files)
+    {
+        auto out = out_root;
+        if (fs::is_directory(out))
+        {
+            out /= new_root.filename();
+            out += ".json";
+        }
+        add(mod_root, old_root, new_root, out);
+    }
+    else
+    {
+        for (const auto& [relative, mod] : edit_files(mod_root, { ".json" }))
+        {
+            fs::path out;
+            if (!out_root.empty())
+            {
+                out = out_root / relative;
+                out += ".json";
+            }
+            add(mod, old_root / relative, new_root / relative, out);
+        }
+    }
+
+    parallel_for(m_files.size(), threads, [&](size_t i) { rebase(binaries[i].first, binaries[i].second, m_files[i]); });
+    return true;
+}
+
+void Rebase::rebase(const fs::path& old_file, const fs::path& new_file, FileRebase& result)
+{
+    if (!fs::is_regular_file(old_file) || !fs::is_regular_file(new_file))
+    {
+        spdlog::error("Mod '{}' has no binary '{}' in both versions", result.mod.string(), old_file.filename().string());
+        return;
+    }
+    ojson mod;
+    try
+    {
+        std::ifstream in{ result.mod };
+        in >> mod;
+    }
+    catch (std::exception& e)
+    {
+        spdlog::error("Failed to parse json file '{}': {}", result.mod.string(), e.what());
+        return;
+    }
+    MerkleTree old_tree;
+    MerkleTree new_tree;
+    if (!old_tree.open(old_file) || !old_tree.build() || !new_tree.open(new_file) || !new_tree.build(true))
+    {
+        spdlog::error("Mod '{}' can't be rebased, '{}' or '{}' is not valid", result.mod.string(), old_file.string(), new_file.string());
+        return;
+    }
+
+    // what the mod changed against the version it was made for
+    const auto edits = old_tree.json_edits(mod);
+    result.edits = edits.size();
+
+    ojson doc = JsonWriter{}.to_json(new_tree.records());
+    std::unordered_map<int32_t, size_t> records;
+    for (size_t i = 0; doc["records"].is_array() && i < doc["records"].size(); ++i)
+    {
+        int32_t id = 0;
+        if (MerkleTree::record_id(doc["records"][i], id))
+        {
+            records.emplace(id, i);
+        }
+    }
+    std::unordered_multimap<uint64_t, uint32_t> new_roots;
+    new_tree.for_each_child(0, [&](uint32_t root) { new_roots.emplace(new_tree.nodes()[root].hash, root); });
+    std::unordered_map<uint32_t, uint32_t> matched_roots;
+
+    for (const auto& edit : edits)
+    {
+        const auto& old_nodes = old_tree.nodes();
+        auto conflict = [&](std::string reason, uint32_t new_node)
+        {
+            result.conflicts.push_back({ old_tree.path(edit.node), std::move(reason), old_tree.value(edit.node),
+                new_node ? new_tree.value(new_node) : ojson{}, edit.value });
+        };
+        std::vector<uint32_t> chain;
+        for (uint32_t n = edit.node; n != 0; n = old_nodes[n].parent)
+        {
+            chain.push_back(n);
+        }
+        auto [root, inserted] = matched_roots.try_emplace(chain.back(), 0);
+        if (inserted)
+        {
+            root->second = match_root(old_tree, chain.back(), new_tree, new_roots);
+        }
+        uint32_t node = root->second;
+        for (size_t i = chain.size() - 1; i > 0 && node; --i)
+        {
+            node = new_tree.child(node, old_nodes[chain[i - 1]].name, old_nodes[chain[i - 1]].index);
+        }
+        if (!node)
+        {
+            conflict("removed in new version", 0);
+            continue;
+        }
+        const auto& old_node = old_nodes[edit.node];
+        const auto& new_node = new_tree.nodes()[node];
+        if (new_node.kind != old_node.kind || new_node.type != old_node.type)
+        {
+            conflict("type changed in new version", node);
+            continue;
+        }
+        if (new_tree.equals(node, edit.value))
+        {
+            ++result.unchanged;
+            continue;
+        }
+        if (new_node.hash != old_node.hash)
+        {
+            conflict("changed in new version", node);
+            continue;
+        }
+        auto* json = locate(doc, new_tree, node, records);
+        if (!json)
+        {
+            conflict("not exported", node);
+            continue;
+        }
+        *json = edit.value;
+        ++result.applied;
+    }
+
+    std::error_code ec;
+    if (result.out.has_parent_path())
+    {
+        fs::create_directories(result.out.parent_path(), ec);
+    }
+    std::ofstream out{ result.out };
+    if (!out)
+    {
+        spdlog::error("Could not save '{}'", result.out.string());
+        return;
+    }
+    out << std::setw(4) << doc;
+    result.ok = static_cast<bool>(out);
+}
+
+void Rebase::print() const
+{
+    size_t rebased = 0;
+    size_t edits = 0;
+    size_t applied = 0;
+    size_t unchanged = 0;
+    size_t conflicts = 0;
+    for (const auto& file : m_files)
+    {
+        if (!file.ok)
+        {
+            continue;
+        }
+        ++rebased;
+        edits += file.edits;
+        applied += file.applied;
+        unchanged += file.unchanged;
+        conflicts += file.conflicts.size();
+        spdlog::info("Rebased '{}' to '{}', {} of {} edits applied, {} already in new version, {} conflicts", file.mod.string(),
+            file.out.string(), file.applied, file.edits, file.unchanged, file.conflicts.size());
+        for (const auto& conflict : file.conflicts)
+        {
+            spdlog::warn("  {} {}: old {}, new {}, mod {}", conflict.path, conflict.reason, conflict.old_value.dump(),
+                conflict.new_value.dump(), conflict.mod_value.dump());
+        }
+    }
+    spdlog::info("Rebased {} of {} mods, {} of {} edits applied, {} already in new version, {} conflicts", rebased, m_files.size(),
+        applied, edits, unchanged, conflicts);
+}
+
+nlohmann::ordered_json Rebase::to_json() const
+{
+    ojson js;
+    js["files"] = ojson::value_t::array;
+    for (const auto& file : m_files)
+    {
+        ojson entry;
+        entry["mod"] = file.mod.string();
+        entry["out"] = file.out.string();
+        entry["ok"] = file.ok;
+        entry["edits"] = file.edits;
+        entry["applied"] = file.applied;
+        entry["unchanged"] = file.unchanged;
+        entry["conflicts"] = ojson::value_t::array;
+        for (const auto& conflict : file.conflicts)
+        {
+            entry["conflicts"].push_back({ { "path", conflict.path }, { "reason", conflict.reason }, { "old", conflict.old_value },
+                { "new", conflict.new_value }, { "mod", conflict.mod_value } });
+        }
+        js["files"].push_back(std::move(entry));
+    }
+    return js;
+}
+
+bool Rebase::save_json(const fs::path& json_path) const
+{
+    return save_report(json_path, to_json(), "Rebase report");
+}
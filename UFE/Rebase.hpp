@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "MerkleTree.hpp"
+
+// Carries json mods over to a new game version. Values a mod changed against the
+// old binary are found by comparing the mod with the old file's Merkle tree. Their
+// root records are matched in the new file by hash, then by object id and then by
+// position among records of the same class, and the member path is followed from
+// there. An edit is applied when the new version still has the old value, skipped
+// when it already has the mod's value and reported as a conflict when the update
+// changed the value as well or the member is gone. The result is an export of the
+// new binary with the mod's values, ready for patching.
+class Rebase
+{
+public:
+    struct Conflict
+    {
+        std::string path;
+        std::string reason;
+        nlohmann::ordered_json old_value; // old game version
+        nlohmann::ordered_json new_value; // new game version
+        nlohmann::ordered_json mod_value;
+    };
+    struct FileRebase
+    {
+        std::filesystem::path mod;  // mod json
+        std::filesystem::path out;  // rebased json
+        bool ok = false;
+        size_t edits = 0;
+        size_t applied = 0;
+        size_t unchanged = 0;       // new version already has the mod's value
+        std::vector<Conflict> conflicts;
+    };
+
+    // old_root and new_root are binaries and mod_root their mod json, or all three are
+    // directories with mods as '<relative binary path>.json'; out_root defaults to
+    // '<new binary>.json' next to the new binaries
+    bool run(const std::filesystem::path& old_root, const std::filesystem::path& mod_root, const std::filesystem::path& new_root,
+        const std::filesystem::path& out_root, size_t threads);
+    const std::vector<FileRebase>& files() const noexcept { return m_files; }
+
+    void print() const;
+    nlohmann::ordered_json to_json() const;
+    bool save_json(const std::filesystem::path& json_path) const;
+private:
+    static void rebase(const std::filesystem::path& old_file, const std::filesystem::path& new_file, FileRebase& result);
+
+    std::vector<FileRebase> m_files;
+};
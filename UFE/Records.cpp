@@ -68,6 +68,29 @@ std::string_view ufe::EPrimitiveTypeEnumeration2str(EPrimitiveTypeEnumeration re
 
 }
 
+size_t ufe::primitive_size(EPrimitiveTypeEnumeration type)
+{
+    switch (type)
+    {
+        case EPrimitiveTypeEnumeration::Boolean: return 1;
+        case EPrimitiveTypeEnumeration::Byte: return 1;
+        case EPrimitiveTypeEnumeration::Char: return 1;
+        case EPrimitiveTypeEnumeration::Double: return 8;
+        case EPrimitiveTypeEnumeration::Int16: return 2;
+        case EPrimitiveTypeEnumeration::Int32: return 4;
+        case EPrimitiveTypeEnumeration::Int64: return 8;
+        case EPrimitiveTypeEnumeration::SByte: return 1;
+        case EPrimitiveTypeEnumeration::Single: return 4;
+        case EPrimitiveTypeEnumeration::TimeSpan: return 8;
+        case EPrimitiveTypeEnumeration::DateTime: return 8;
+        case EPrimitiveTypeEnumeration::UInt16: return 2;
+        case EPrimitiveTypeEnumeration::UInt32: return 4;
+        case EPrimitiveTypeEnumeration::UInt64: return 8;
+        default:
+            return 0;
+    }
+}
+
 bool ufe::operator==(const LengthPrefixedString& lhs, const std::string& rhs)
 {
     return lhs.string == rhs;
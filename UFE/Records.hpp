@@ -10,8 +10,10 @@
 #include <variant>
 #include <source_location>
 #include <iostream>
+#include <string>
 #include <string_view>
 #include "IndexedData.hpp"
+#include "StringInterner.hpp"
 #include <nlohmann/json.hpp>
 
 
@@ -23,6 +25,8 @@ double float2str2double(float f);
 constexpr uint8_t GZIP_MAGIC_1 = 0x1F;
 constexpr uint8_t GZIP_MAGIC_2 = 0x8B;
 constexpr uint8_t GZIP_START_OFF = 24;
+// SerializedStreamHeader record including its type byte, first bytes of every NRBF stream
+constexpr uint8_t STREAM_HEADER_SIZE = 17;
 
 namespace ufe
 {
@@ -93,6 +97,8 @@ namespace ufe
         String = 18
     };
     std::string_view EPrimitiveTypeEnumeration2str(EPrimitiveTypeEnumeration rec);
+    // bytes of one array element as stored in the stream, 0 for types without a fixed size
+    size_t primitive_size(EPrimitiveTypeEnumeration type);
 
     enum class EBinaryArrayTypeEnumeration
     {
@@ -119,12 +125,16 @@ namespace ufe
         ERecordType m_type;
     };
 
+    // string is a view into the decoded file buffer owned by BinaryFileParser,
+    // only values replaced by update_string own their data
     struct LengthPrefixedString
     {
-        std::string string;
+        std::string_view string;
         uint64_t m_original_len;
         uint64_t m_original_len_unmod;
         uint64_t m_new_len = 0;
+        // shared so copies of updated strings keep pointing to valid data
+        std::shared_ptr<const std::string> m_storage;
         void update_string(const std::string& s)
         {
             if (string != s)
@@ -138,7 +148,8 @@ namespace ufe
                         m_new_len |= 0x80UL << (8 * i);
                     }
                 }
-                string = s;
+                m_storage = std::make_shared<const std::string>(s);
+                string = *m_storage;
             }
         }
     };
@@ -151,12 +162,16 @@ namespace ufe
         IndexedData<LengthPrefixedString> Name;
         IndexedData<int32_t> MemberCount;
         std::vector<IndexedData<LengthPrefixedString>> MemberNames;
+        // interned Name and MemberNames, equal across files
+        StringInterner::Id NameId = StringInterner::invalid_id;
+        std::vector<StringInterner::Id> MemberNameIds;
     };
 
     struct ClassTypeInfo
     {
         LengthPrefixedString TypeName;
         int32_t LibraryId;
+        StringInterner::Id TypeNameId = StringInterner::invalid_id;
     };
 
     struct BinaryObjectString
@@ -178,6 +193,11 @@ namespace ufe
     {
         uint8_t NullCount;
     };
+
+    // member left out by --select, not part of the stream
+    struct SkippedValue
+    {
+    };
     struct ClassWithMembersAndTypes;
     using AdditionalInfosType = std::variant<EPrimitiveTypeEnumeration, LengthPrefixedString, ClassTypeInfo>;
     using ClassMembersData = std::variant<uint8_t, int32_t, double, float, bool, LengthPrefixedString, ClassTypeInfo, BinaryObjectString, ClassWithMembersAndTypes, MemberReference, ObjectNull>;
@@ -244,6 +264,7 @@ namespace ufe
     {
         ClassInfo m_ClassInfo;
         MemberTypeInfo m_MemberTypeInfo;
+        bool m_system_class = false; // SystemClassWithMembersAndTypes record, no library id
     };
 
     struct ClassWithId
@@ -0,0 +1,33 @@
+#include "Report.hpp"
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <spdlog/spdlog.h>
+
+bool save_report(const std::filesystem::path& json_path, const nlohmann::ordered_json& js, std::string_view what)
+{
+    std::string lower{ what };
+    if (!lower.empty())
+    {
+        lower[0] = static_cast<char>(std::tolower(static_cast<unsigned char>(lower[0])));
+    }
+    std::ofstream out_json{ json_path };
+    if (!out_json)
+    {
+        spdlog::error("Could not save {} '{}'", lower, json_path.string());
+        return false;
+    }
+    try
+    {
+        out_json << std::setw(4) << js;
+    }
+    catch (std::exception& e)
+    {
+        // strings that aren't valid UTF-8 can't be dumped
+        spdlog::error("Could not save {} '{}': {}", lower, json_path.string(), e.what());
+        return false;
+    }
+    spdlog::info("{} saved to '{}'", what, json_path.string());
+    return true;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <filesystem>
+#include <string_view>
+#include <nlohmann/json.hpp>
+
+// js saved indented to json_path, logged as "<What> saved to '<path>'" or as
+// "Could not save <what> '<path>'" when the file can't be written or js holds
+// strings that aren't valid UTF-8, what names the report such as "Stats report"
+bool save_report(const std::filesystem::path& json_path, const nlohmann::ordered_json& js, std::string_view what);
@@ -0,0 +1,435 @@
+#include "Server.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <spdlog/spdlog.h>
+#include "FileProcessor.hpp"
+#include "JsonReader.hpp"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+    using native_socket = SOCKET;
+    constexpr native_socket invalid_socket = INVALID_SOCKET;
+    constexpr int shutdown_both = SD_BOTH;
+    constexpr int send_flags = 0;
+    void close_socket(native_socket s) { ::closesocket(s); }
+#else
+    using native_socket = int;
+    constexpr native_socket invalid_socket = -1;
+    constexpr int shutdown_both = SHUT_RDWR;
+    // closed connections are reported by send instead of SIGPIPE
+    constexpr int send_flags = MSG_NOSIGNAL;
+    void close_socket(native_socket s) { ::close(s); }
+#endif
+    // larger frames are treated as a broken connection
+    constexpr uint32_t max_frame_size = 256 * 1024 * 1024;
+
+    native_socket native(uintptr_t s) { return static_cast<native_socket>(s); }
+
+    bool make_address(const fs::path& socket_path, sockaddr_un& address)
+    {
+        const auto path = socket_path.string();
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            spdlog::error("Socket path '{}' longer than {} characters", path, sizeof(address.sun_path) - 1);
+            return false;
+        }
+        std::memcpy(address.sun_path, path.data(), path.size());
+        return true;
+    }
+
+    bool read_exact(native_socket s, char* data, size_t size)
+    {
+        while (size)
+        {
+            const auto n = ::recv(s, data, static_cast<int>(std::min<size_t>(size, 1 << 20)), 0);
+            if (n <= 0)
+            {
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool write_exact(native_socket s, const char* data, size_t size)
+    {
+        while (size)
+        {
+            const auto n = ::send(s, data, static_cast<int>(std::min<size_t>(size, 1 << 20)), send_flags);
+            if (n <= 0)
+            {
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool read_frame(native_socket s, std::string& frame)
+    {
+        unsigned char prefix[4];
+        if (!read_exact(s, reinterpret_cast<char*>(prefix), sizeof(prefix)))
+        {
+            return false;
+        }
+        const uint32_t size = prefix[0] | (prefix[1] << 8) | (prefix[2] << 16) | (static_cast<uint32_t>(prefix[3]) << 24);
+        if (size > max_frame_size)
+        {
+            spdlog::warn("Request of {} bytes refused", size);
+            return false;
+        }
+        frame.resize(size);
+        return read_exact(s, frame.data(), frame.size());
+    }
+
+    bool write_frame(native_socket s, const std::string& frame)
+    {
+        const auto size = static_cast<uint32_t>(frame.size());
+        const unsigned char prefix[4] = { static_cast<unsigned char>(size), static_cast<unsigned char>(size >> 8),
+            static_cast<unsigned char>(size >> 16), static_cast<unsigned char>(size >> 24) };
+        return write_exact(s, reinterpret_cast<const char*>(prefix), sizeof(prefix)) && write_exact(s, frame.data(), frame.size());
+    }
+
+    // connects and disconnects right away
+    bool connectable(const sockaddr_un& address)
+    {
+        const auto s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (s == invalid_socket)
+        {
+            return false;
+        }
+        const bool connected = ::connect(s, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        close_socket(s);
+        return connected;
+    }
+
+    nlohmann::ordered_json error(std::string_view message)
+    {
+        return { { "ok", false }, { "error", message } };
+    }
+
+    // set keeps the shape of the document, values only change within their kind
+    bool same_kind(const nlohmann::ordered_json& current, const nlohmann::ordered_json& value)
+    {
+        return (current.is_number() && value.is_number()) ||
+            (current.is_string() && value.is_string()) ||
+            (current.is_boolean() && value.is_boolean());
+    }
+}
+
+Server::Server(fs::path socket_path, uint64_t cache_limit) : m_socket_path{ std::move(socket_path) }, m_cache{ cache_limit }
+{
+}
+
+bool Server::run()
+{
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (::WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    {
+        spdlog::error("Winsock initialization failed");
+        return false;
+    }
+#endif
+    sockaddr_un address;
+    bool listening = false;
+    native_socket listener = invalid_socket;
+    if (make_address(m_socket_path, address))
+    {
+        if (connectable(address))
+        {
+            spdlog::error("Server already running on '{}'", m_socket_path.string());
+        }
+        else
+        {
+            listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            // stale socket file of a previous run
+            std::error_code ec;
+            fs::remove(m_socket_path, ec);
+            listening = listener != invalid_socket &&
+                ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0 &&
+                ::listen(listener, SOMAXCONN) == 0;
+            if (!listening)
+            {
+                spdlog::error("Could not listen on '{}'", m_socket_path.string());
+            }
+        }
+    }
+
+    if (listening)
+    {
+        spdlog::info("Serving on '{}'", m_socket_path.string());
+        while (!m_stop)
+        {
+            const auto client = ::accept(listener, nullptr, nullptr);
+            if (m_stop)
+            {
+                if (client != invalid_socket)
+                {
+                    close_socket(client);
+                }
+                break;
+            }
+            if (client == invalid_socket)
+            {
+                spdlog::warn("Accepting connection failed");
+                continue;
+            }
+            {
+                std::lock_guard lock{ m_clients_mutex };
+                m_clients.push_back(static_cast<Socket>(client));
+            }
+            std::thread{ &Server::serve_client, this, static_cast<Socket>(client) }.detach();
+        }
+        // connected clients are shut down, their threads end after the current request
+        std::unique_lock lock{ m_clients_mutex };
+        for (auto client : m_clients)
+        {
+            ::shutdown(native(client), shutdown_both);
+        }
+        m_clients_cv.wait(lock, [this] { return m_clients.empty(); });
+    }
+    if (listener != invalid_socket)
+    {
+        close_socket(listener);
+    }
+    if (listening)
+    {
+        std::error_code ec;
+        fs::remove(m_socket_path, ec);
+    }
+#ifdef _WIN32
+    ::WSACleanup();
+#endif
+    if (listening)
+    {
+        spdlog::info("Served {} requests", m_requests.load());
+        m_cache.print();
+    }
+    return listening;
+}
+
+void Server::serve_client(Socket client)
+{
+    std::string frame;
+    bool stopping = false;
+    while (!m_stop && read_frame(native(client), frame))
+    {
+        const auto start = std::chrono::steady_clock::now();
+        nlohmann::ordered_json response;
+        try
+        {
+            response = handle(nlohmann::ordered_json::parse(frame));
+            stopping = m_stop;
+        }
+        catch (std::exception& e)
+        {
+            response = error(e.what());
+        }
+        response["time_us"] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        if (!write_frame(native(client), response.dump()))
+        {
+            break;
+        }
+    }
+    if (stopping)
+    {
+        stop();
+    }
+    close_socket(native(client));
+    std::lock_guard lock{ m_clients_mutex };
+    std::erase(m_clients, client);
+    m_clients_cv.notify_all();
+}
+
+void Server::stop()
+{
+    // accept is woken up by a connection of its own
+    sockaddr_un address;
+    if (make_address(m_socket_path, address))
+    {
+        connectable(address);
+    }
+}
+
+nlohmann::ordered_json Server::handle(const nlohmann::ordered_json& request)
+{
+    ++m_requests;
+    if (!request.is_object() || !request.contains("op") || !request["op"].is_string())
+    {
+        return error("request needs an 'op'");
+    }
+    const auto op = request["op"].get<std::string>();
+    spdlog::debug("Request '{}'", op);
+    nlohmann::ordered_json response;
+    const bool file_op = op == "export" || op == "get" || op == "set" || op == "patch" || op == "validate";
+    if (op == "stats")
+    {
+        response = { { "ok", true }, { "requests", m_requests.load() }, { "cache", m_cache.to_json() } };
+    }
+    else if (op == "shutdown")
+    {
+        m_stop = true;
+        response = { { "ok", true } };
+    }
+    else if (op == "evict" && !request.contains("file"))
+    {
+        m_cache.clear();
+        response = { { "ok", true } };
+    }
+    else if (!file_op && op != "evict")
+    {
+        response = error("unknown op '" + op + "'");
+    }
+    else if (!request.contains("file") || !request["file"].is_string())
+    {
+        response = error("request needs a 'file'");
+    }
+    else if (op == "evict")
+    {
+        m_cache.invalidate(request["file"].get<std::string>());
+        response = { { "ok", true } };
+    }
+    else
+    {
+        const fs::path file = request["file"].get<std::string>();
+        bool hit = false;
+        if (auto entry = m_cache.get(file, hit))
+        {
+            std::lock_guard lock{ entry->mutex };
+            if (op == "export")
+            {
+                response = op_export(*entry, request);
+            }
+            else if (op == "get")
+            {
+                response = op_get(*entry, request);
+            }
+            else if (op == "set")
+            {
+                response = op_set(*entry, request);
+            }
+            else if (op == "patch")
+            {
+                response = op_patch(*entry, request);
+            }
+            else
+            {
+                response = op_validate(*entry, request);
+            }
+            response["cached"] = hit;
+        }
+        else
+        {
+            response = error("file can't be parsed");
+        }
+    }
+    if (request.contains("id"))
+    {
+        response["id"] = request["id"];
+    }
+    return response;
+}
+
+nlohmann::ordered_json Server::op_export(ParseCache::Entry& entry, const nlohmann::ordered_json& request)
+{
+    const auto& json = m_cache.json(entry);
+    if (request.value("save", false))
+    {
+        auto json_path = entry.file;
+        json_path += ".json";
+        std::error_code ec;
+        fs::remove(json_path, ec);
+        std::ofstream out{ json_path };
+        // same text as an export run
+        out << json.dump(4);
+        if (!out)
+        {
+            return error("could not save '" + json_path.string() + "'");
+        }
+        spdlog::info("Exporting data to '{}'", json_path.string());
+    }
+    return { { "ok", true }, { "json", json } };
+}
+
+nlohmann::ordered_json Server::op_get(ParseCache::Entry& entry, const nlohmann::ordered_json& request)
+{
+    const nlohmann::ordered_json::json_pointer pointer{ request.value("pointer", std::string{}) };
+    const auto& json = m_cache.json(entry);
+    if (!json.contains(pointer))
+    {
+        return error("no value at '" + pointer.to_string() + "'");
+    }
+    return { { "ok", true }, { "value", json[pointer] } };
+}
+
+nlohmann::ordered_json Server::op_set(ParseCache::Entry& entry, const nlohmann::ordered_json& request)
+{
+    if (!request.contains("value"))
+    {
+        return error("request needs a 'value'");
+    }
+    const nlohmann::ordered_json::json_pointer pointer{ request.value("pointer", std::string{}) };
+    // only files with pending edits are left in a full cache, they can't be dropped
+    if (!entry.modified && m_cache.full())
+    {
+        spdlog::warn("Edit of '{}' refused, cache is full of files with edits that weren't patched yet", entry.file.string());
+        return error("cache is full of files with edits that weren't patched yet, patch or evict them first");
+    }
+    auto& json = m_cache.json(entry);
+    if (!json.contains(pointer))
+    {
+        return error("no value at '" + pointer.to_string() + "'");
+    }
+    auto& current = json[pointer];
+    if (!same_kind(current, request["value"]))
+    {
+        return error("value at '" + pointer.to_string() + "' is " + current.type_name() + ", got " + request["value"].type_name());
+    }
+    current = request["value"];
+    entry.modified = true;
+    return { { "ok", true } };
+}
+
+nlohmann::ordered_json Server::op_patch(ParseCache::Entry& entry, const nlohmann::ordered_json& request)
+{
+    JsonReader reader;
+    const bool patched = request.contains("json") ?
+        reader.patch(request["json"], entry.file, entry.parser) :
+        reader.patch(m_cache.json(entry), entry.file, entry.parser);
+    if (!patched)
+    {
+        return error("patching failed");
+    }
+    // file changed on disk, parsed again by the next request
+    entry.modified = false;
+    m_cache.invalidate(entry.file);
+    return { { "ok", true } };
+}
+
+nlohmann::ordered_json Server::op_validate(ParseCache::Entry& entry, const nlohmann::ordered_json&)
+{
+    const auto status = entry.parser.status();
+    const bool round_trip = status == BinaryFileParser::EFileStatus::FullRead && validate_round_trip(entry.file, entry.parser, nullptr);
+    return { { "ok", true }, { "status", EFileStatus2str(status) }, { "round_trip", round_trip } };
+}
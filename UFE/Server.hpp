@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "ParseCache.hpp"
+
+// Long running mode for tools making many small requests against the same files.
+// Listens on a unix domain socket, every connection is served by its own thread
+// from a shared cache of parsed files.
+//
+// Messages in both directions are frames of a 4 bytes little endian length
+// followed by that many bytes of json. Requests are objects with "op" and
+// usually "file", an optional "id" is echoed in the response. Responses carry
+// "ok", "error" when ok is false, "cached" for file requests and "time_us".
+//   export   {"file", "save"}           "json" export document, save also writes '<file>.json'
+//   get      {"file", "pointer"}        "value" at json pointer into the export document
+//   set      {"file", "pointer", "value"} replaces a value, kept until patch
+//   patch    {"file", "json"}           writes the edited document, or json when given, into the file
+//   validate {"file"}                   "status" and "round_trip" of the re-serialized record tree
+//   evict    {"file"}                   drops the file, or the whole cache without file
+//   stats    {}                         cache counters
+//   shutdown {}
+class Server
+{
+public:
+    Server(std::filesystem::path socket_path, uint64_t cache_limit);
+    // blocks until a shutdown request arrives, false when the socket can't be opened
+    bool run();
+    nlohmann::ordered_json handle(const nlohmann::ordered_json& request);
+private:
+    // native socket handle
+    using Socket = uintptr_t;
+    void serve_client(Socket client);
+    void stop();
+
+    nlohmann::ordered_json op_export(ParseCache::Entry& entry, const nlohmann::ordered_json& request);
+    nlohmann::ordered_json op_get(ParseCache::Entry& entry, const nlohmann::ordered_json& request);
+    nlohmann::ordered_json op_set(ParseCache::Entry& entry, const nlohmann::ordered_json& request);
+    nlohmann::ordered_json op_patch(ParseCache::Entry& entry, const nlohmann::ordered_json& request);
+    nlohmann::ordered_json op_validate(ParseCache::Entry& entry, const nlohmann::ordered_json& request);
+
+    std::filesystem::path m_socket_path;
+    ParseCache m_cache;
+    std::atomic<bool> m_stop{ false };
+    std::atomic<uint64_t> m_requests{ 0 };
+    // open connections, shut down when the server stops
+    std::mutex m_clients_mutex;
+    std::condition_variable m_clients_cv;
+    std::vector<Socket> m_clients;
+};
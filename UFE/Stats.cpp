@@ -0,0 +1,230 @@
+#include "Stats.hpp"
+#include "Report.hpp"
+#include "StringInterner.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    double to_ms(std::chrono::nanoseconds t)
+    {
+        return std::chrono::duration<double, std::milli>(t).count();
+    }
+
+    double mb_per_sec(uint64_t bytes, std::chrono::nanoseconds t)
+    {
+        const double sec = std::chrono::duration<double>(t).count();
+        return sec > 0.0 ? (static_cast<double>(bytes) / (1024.0 * 1024.0)) / sec : 0.0;
+    }
+
+    nlohmann::ordered_json memory_json(const StageMemory& mem)
+    {
+        return {
+            { "allocs", mem.allocs },
+            { "bytes_allocated", mem.bytes_allocated },
+            { "peak_bytes", mem.peak },
+            { "retained_bytes", mem.retained }
+        };
+    }
+
+    nlohmann::ordered_json file_stats_json(const FileStats& fs)
+    {
+        nlohmann::ordered_json js = nlohmann::ordered_json::value_t::object;
+        if (!fs.file.empty())
+        {
+            js["file"] = fs.file.string();
+        }
+        auto& stages = js["stages_ms"];
+        stages = nlohmann::ordered_json::value_t::object;
+        for (size_t i = 0; i < static_cast<size_t>(EStage::Count); ++i)
+        {
+            stages[std::string{ EStage2str(static_cast<EStage>(i)) }] = to_ms(fs.stage_time[i]);
+        }
+        js["total_ms"] = to_ms(fs.total_time());
+        js["bytes_in"] = fs.bytes_in;
+        js["bytes_inflated"] = fs.bytes_inflated;
+        js["bytes_out"] = fs.bytes_out;
+        js["bytes_skipped"] = fs.bytes_skipped;
+        js["records"] = fs.records;
+        js["members"] = fs.members;
+        js["parse_mb_s"] = mb_per_sec(fs.bytes_inflated, fs.time(EStage::Parse));
+        js["total_mb_s"] = mb_per_sec(fs.bytes_in, fs.total_time());
+        if (MemoryTracker::enabled())
+        {
+            auto& memory = js["memory"];
+            memory = memory_json(fs.memory);
+            for (size_t i = 0; i < static_cast<size_t>(EStage::Count); ++i)
+            {
+                if (fs.stage_memory[i].allocs)
+                {
+                    memory["stages"][std::string{ EStage2str(static_cast<EStage>(i)) }] = memory_json(fs.stage_memory[i]);
+                }
+            }
+        }
+        return js;
+    }
+}
+
+std::string_view EStage2str(EStage stage)
+{
+    switch (stage)
+    {
+        case EStage::Read: return "read";
+        case EStage::Inflate: return "inflate";
+        case EStage::Parse: return "parse";
+        case EStage::JsonBuild: return "json_build";
+        case EStage::JsonWrite: return "json_write";
+        case EStage::Patch: return "patch";
+        case EStage::Serialize: return "serialize";
+        case EStage::Deflate: return "deflate";
+        case EStage::BinaryWrite: return "binary_write";
+        default:
+            return "invalid";
+    }
+}
+
+std::chrono::nanoseconds FileStats::total_time() const
+{
+    std::chrono::nanoseconds total{};
+    for (const auto& t : stage_time)
+    {
+        total += t;
+    }
+    return total;
+}
+
+FileStats& FileStats::operator+=(const FileStats& rhs)
+{
+    for (size_t i = 0; i < stage_time.size(); ++i)
+    {
+        stage_time[i] += rhs.stage_time[i];
+    }
+    bytes_in += rhs.bytes_in;
+    bytes_inflated += rhs.bytes_inflated;
+    bytes_out += rhs.bytes_out;
+    bytes_skipped += rhs.bytes_skipped;
+    records += rhs.records;
+    members += rhs.members;
+    for (size_t i = 0; i < stage_memory.size(); ++i)
+    {
+        stage_memory[i] += rhs.stage_memory[i];
+    }
+    memory += rhs.memory;
+    return *this;
+}
+
+FileStats StatsCollector::total() const
+{
+    FileStats total;
+    for (const auto& fs : m_files)
+    {
+        total += fs;
+    }
+    return total;
+}
+
+void StatsCollector::print_table(size_t slowest_count /* = 10 */) const
+{
+    const auto tot = total();
+    const auto tot_time = tot.total_time();
+    spdlog::info("Processed {} file(s), {} records, {} members, {:.2f} ms",
+        m_files.size(), tot.records, tot.members, to_ms(tot_time));
+    spdlog::info("{:<14}{:>12}{:>8}", "stage", "time [ms]", "%");
+    for (size_t i = 0; i < static_cast<size_t>(EStage::Count); ++i)
+    {
+        const auto t = tot.stage_time[i];
+        if (t.count() == 0)
+        {
+            continue;
+        }
+        const double pct = tot_time.count() ? 100.0 * t.count() / tot_time.count() : 0.0;
+        spdlog::info("{:<14}{:>12.2f}{:>8.1f}", EStage2str(static_cast<EStage>(i)), to_ms(t), pct);
+    }
+    spdlog::info("bytes in {}, inflated {}, out {}", tot.bytes_in, tot.bytes_inflated, tot.bytes_out);
+    if (tot.bytes_skipped)
+    {
+        spdlog::info("bytes skipped by selection {}", tot.bytes_skipped);
+    }
+    spdlog::info("parse {:.2f} MB/s, overall {:.2f} MB/s",
+        mb_per_sec(tot.bytes_inflated, tot.time(EStage::Parse)), mb_per_sec(tot.bytes_in, tot_time));
+    spdlog::info("interned names {}, {} bytes", StringInterner::size(), StringInterner::bytes());
+
+    if (MemoryTracker::enabled())
+    {
+        spdlog::info("{:<14}{:>12}{:>14}{:>14}{:>14}", "stage", "allocs", "alloc [KB]", "peak [KB]", "retained [KB]");
+        for (size_t i = 0; i < static_cast<size_t>(EStage::Count); ++i)
+        {
+            const auto& mem = tot.stage_memory[i];
+            if (mem.allocs)
+            {
+                spdlog::info("{:<14}{:>12}{:>14.1f}{:>14.1f}{:>14.1f}", EStage2str(static_cast<EStage>(i)), mem.allocs,
+                    mem.bytes_allocated / 1024.0, mem.peak / 1024.0, mem.retained / 1024.0);
+            }
+        }
+        spdlog::info("largest file peak {:.1f} KB, heap peak {:.1f} KB, process peak RSS {:.1f} KB",
+            tot.memory.peak / 1024.0, MemoryTracker::process_peak() / 1024.0, MemoryTracker::peak_rss() / 1024.0);
+    }
+
+    if (m_files.size() > 1 && slowest_count)
+    {
+        std::vector<const FileStats*> sorted;
+        sorted.reserve(m_files.size());
+        for (const auto& fs : m_files)
+        {
+            sorted.push_back(&fs);
+        }
+        const auto count = std::min(slowest_count, sorted.size());
+        std::partial_sort(sorted.begin(), sorted.begin() + count, sorted.end(),
+            [](const FileStats* lhs, const FileStats* rhs) { return lhs->total_time() > rhs->total_time(); });
+        spdlog::info("Slowest files:");
+        spdlog::info("{:>12}{:>12}{:>10}  {}", "time [ms]", "bytes in", "MB/s", "file");
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto& fs = *sorted[i];
+            spdlog::info("{:>12.2f}{:>12}{:>10.2f}  {}", to_ms(fs.total_time()), fs.bytes_in,
+                mb_per_sec(fs.bytes_in, fs.total_time()), fs.file.string());
+        }
+
+        if (MemoryTracker::enabled())
+        {
+            std::partial_sort(sorted.begin(), sorted.begin() + count, sorted.end(),
+                [](const FileStats* lhs, const FileStats* rhs) { return lhs->memory.peak > rhs->memory.peak; });
+            spdlog::info("Largest files by peak heap usage:");
+            spdlog::info("{:>12}{:>12}  {}", "peak [KB]", "allocs", "file");
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto& fs = *sorted[i];
+                spdlog::info("{:>12.1f}{:>12}  {}", fs.memory.peak / 1024.0, fs.memory.allocs, fs.file.string());
+            }
+        }
+    }
+}
+
+nlohmann::ordered_json StatsCollector::to_json() const
+{
+    nlohmann::ordered_json js = nlohmann::ordered_json::value_t::object;
+    js["total"] = file_stats_json(total());
+    js["total"]["files"] = m_files.size();
+    js["total"]["interned_names"] = StringInterner::size();
+    js["total"]["interned_bytes"] = StringInterner::bytes();
+    if (MemoryTracker::enabled())
+    {
+        js["total"]["memory"]["process_peak_bytes"] = MemoryTracker::process_peak();
+        js["total"]["memory"]["peak_rss_bytes"] = MemoryTracker::peak_rss();
+    }
+    if (!m_pipeline.is_null())
+    {
+        js["pipeline"] = m_pipeline;
+    }
+    js["files"] = nlohmann::ordered_json::value_t::array;
+    for (const auto& fs : m_files)
+    {
+        js["files"].push_back(file_stats_json(fs));
+    }
+    return js;
+}
+
+bool StatsCollector::save_json(const std::filesystem::path& json_path) const
+{
+    return save_report(json_path, to_json(), "Stats report");
+}
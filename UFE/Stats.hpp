@@ -0,0 +1,123 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "MemoryTracker.hpp"
+#include "Trace.hpp"
+
+// processing stages measured by --stats, order matches report columns
+enum class EStage : size_t
+{
+    Read,
+    Inflate,
+    Parse,
+    JsonBuild,
+    JsonWrite,
+    Patch,
+    Serialize,
+    Deflate,
+    BinaryWrite,
+    Count
+};
+
+std::string_view EStage2str(EStage stage);
+
+struct FileStats
+{
+    std::filesystem::path file;
+    std::array<std::chrono::nanoseconds, static_cast<size_t>(EStage::Count)> stage_time{};
+    uint64_t bytes_in = 0;       // bytes read from disk
+    uint64_t bytes_inflated = 0; // decoded NRBF stream size
+    uint64_t bytes_out = 0;      // bytes written (json or patched binary)
+    uint64_t bytes_skipped = 0;  // stream bytes stepped over by --select without decoding
+    uint64_t records = 0;
+    uint64_t members = 0;
+    // filled only while MemoryTracker is enabled
+    std::array<StageMemory, static_cast<size_t>(EStage::Count)> stage_memory{};
+    StageMemory memory;
+
+    void add_time(EStage stage, std::chrono::nanoseconds t) { stage_time[static_cast<size_t>(stage)] += t; }
+    std::chrono::nanoseconds time(EStage stage) const { return stage_time[static_cast<size_t>(stage)]; }
+    std::chrono::nanoseconds total_time() const;
+    FileStats& operator+=(const FileStats& rhs);
+};
+
+// adds elapsed wall time (and heap usage when tracked) to a stage on destruction
+// and emits a trace span while tracing, no-op otherwise
+class StageTimer
+{
+public:
+    // per record timers pass trace = false to keep the timeline readable
+    StageTimer(FileStats* stats, EStage stage, bool trace = true) : m_stats{ stats }, m_stage{ stage }, m_trace{ trace && Tracer::enabled() }
+    {
+        if (m_stats)
+        {
+            m_track_memory = MemoryTracker::enabled();
+            if (m_track_memory)
+            {
+                m_memory = MemoryTracker::stage_begin();
+            }
+        }
+        if (m_stats || m_trace)
+        {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+    ~StageTimer() { stop(); }
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    void stop()
+    {
+        if (m_trace)
+        {
+            Tracer::add_span(EStage2str(m_stage).data(), m_start, std::chrono::steady_clock::now());
+            m_trace = false;
+        }
+        if (m_stats)
+        {
+            m_stats->add_time(m_stage, std::chrono::steady_clock::now() - m_start);
+            if (m_track_memory)
+            {
+                m_stats->stage_memory[static_cast<size_t>(m_stage)] += MemoryTracker::stage_end(m_memory);
+            }
+            m_stats = nullptr;
+        }
+    }
+private:
+    FileStats* m_stats;
+    EStage m_stage;
+    bool m_trace;
+    std::chrono::steady_clock::time_point m_start;
+    bool m_track_memory = false;
+    MemoryTracker::Snapshot m_memory;
+};
+
+class StatsCollector
+{
+public:
+    // files may be added from several threads
+    void add(FileStats&& stats)
+    {
+        std::lock_guard lock{ m_mutex };
+        m_files.emplace_back(std::move(stats));
+    }
+    const std::vector<FileStats>& files() const noexcept { return m_files; }
+    FileStats total() const;
+
+    // per stage totals and slowest files, logged at info level
+    void print_table(size_t slowest_count = 10) const;
+    nlohmann::ordered_json to_json() const;
+    bool save_json(const std::filesystem::path& json_path) const;
+    // stage utilization and queue depths of a pipelined run, saved with the report
+    void set_pipeline(nlohmann::ordered_json pipeline) { m_pipeline = std::move(pipeline); }
+private:
+    std::mutex m_mutex;
+    std::vector<FileStats> m_files;
+    nlohmann::ordered_json m_pipeline;
+};
@@ -0,0 +1,72 @@
+#include "StringInterner.hpp"
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace
+{
+    // low id bits select the shard, threads interning different names rarely contend
+    constexpr uint32_t shard_bits = 4;
+    constexpr uint32_t shard_count = 1u << shard_bits;
+
+    struct Shard
+    {
+        std::shared_mutex mutex;
+        // keys view strings in names, deque never relocates its elements
+        std::unordered_map<std::string_view, StringInterner::Id> ids;
+        std::deque<std::string> names;
+    };
+
+    std::array<Shard, shard_count> s_shards;
+    std::atomic<size_t> s_size{ 0 };
+    std::atomic<size_t> s_bytes{ 0 };
+}
+
+StringInterner::Id StringInterner::intern(std::string_view s)
+{
+    const auto shard_index = static_cast<uint32_t>(std::hash<std::string_view>{}(s) & (shard_count - 1));
+    auto& shard = s_shards[shard_index];
+    {
+        std::shared_lock lock{ shard.mutex };
+        if (const auto it = shard.ids.find(s); it != shard.ids.cend())
+        {
+            return it->second;
+        }
+    }
+
+    std::unique_lock lock{ shard.mutex };
+    // another thread could add the same name between the locks
+    if (const auto it = shard.ids.find(s); it != shard.ids.cend())
+    {
+        return it->second;
+    }
+    const Id id = static_cast<Id>(shard.names.size() << shard_bits) | shard_index;
+    shard.names.emplace_back(s);
+    shard.ids.emplace(shard.names.back(), id);
+    s_size.fetch_add(1, std::memory_order_relaxed);
+    s_bytes.fetch_add(s.size(), std::memory_order_relaxed);
+    return id;
+}
+
+const std::string& StringInterner::str(Id id)
+{
+    static const std::string empty;
+    auto& shard = s_shards[id & (shard_count - 1)];
+    std::shared_lock lock{ shard.mutex };
+    const auto index = id >> shard_bits;
+    return index < shard.names.size() ? shard.names[index] : empty;
+}
+
+size_t StringInterner::size() noexcept
+{
+    return s_size.load(std::memory_order_relaxed);
+}
+
+size_t StringInterner::bytes() noexcept
+{
+    return s_bytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Process-wide table of class, member and library names shared by all files
+// of a run. Names map to small stable ids, equal names always get the same id,
+// interned strings live until the process exits. Safe to use from many threads.
+class StringInterner
+{
+public:
+    using Id = uint32_t;
+    static constexpr Id invalid_id = ~Id{ 0 };
+
+    static Id intern(std::string_view s);
+    // reference stays valid for the whole run
+    static const std::string& str(Id id);
+
+    static size_t size() noexcept;
+    // interned characters, without container overhead
+    static size_t bytes() noexcept;
+};
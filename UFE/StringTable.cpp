@@ -0,0 +1,219 @@
+#include "StringTable.hpp"
+#include <fstream>
+#include <map>
+#include <unordered_map>
+#include <spdlog/spdlog.h>
+#include "FileRoots.hpp"
+#include "Pipeline.hpp"
+#include "Report.hpp"
+
+namespace fs = std::filesystem;
+using ojson = nlohmann::ordered_json;
+
+namespace
+{
+    // table paths are relative to the scanned directory or to the directory of a scanned file
+    fs::path base_of(const fs::path& root)
+    {
+        return fs::is_directory(root) ? root : root.parent_path();
+    }
+
+    // table files are relative paths that stay under the base when joined to it,
+    // absolute paths and paths climbing out with '..' are rejected
+    bool under_base(const fs::path& file)
+    {
+        if (file.empty() || file.has_root_name() || file.has_root_directory())
+        {
+            return false;
+        }
+        const auto normal = file.lexically_normal();
+        return !normal.empty() && normal != "." && *normal.begin() != "..";
+    }
+
+    struct Found
+    {
+        std::string text;
+        uint64_t offset;
+        std::string path;
+    };
+}
+
+bool StringTable::extract(const fs::path& root, size_t threads)
+{
+    m_entries.clear();
+    std::vector<fs::path> files;
+    for (auto& [relative, file] : supported_files(root))
+    {
+        files.push_back(std::move(file));
+    }
+    if (files.empty())
+    {
+        spdlog::error("No supported files in '{}'", root.string());
+        return false;
+    }
+    // files are scanned in parallel and merged in path order, ids don't depend on scheduling
+    std::vector<std::vector<Found>> found(files.size());
+    parallel_for(files.size(), threads, [&](size_t i)
+        {
+            MerkleTree tree;
+            if (!tree.open(files[i]) || !tree.build())
+            {
+                spdlog::warn("File '{}' skipped, parsing failed", files[i].string());
+                return;
+            }
+            const auto& nodes = tree.nodes();
+            for (uint32_t node = 1; node < nodes.size(); ++node)
+            {
+                if (nodes[node].kind == MerkleTree::EKind::String && !nodes[node].text.empty())
+                {
+                    found[i].push_back({ std::string{ nodes[node].text }, nodes[node].offset, tree.address(node) });
+                }
+            }
+        });
+
+    const auto base = base_of(root);
+    std::unordered_map<std::string, size_t> ids;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const auto file = files[i].lexically_relative(base).generic_string();
+        for (auto& f : found[i])
+        {
+            const auto [it, inserted] = ids.try_emplace(f.text, m_entries.size());
+            if (inserted)
+            {
+                m_entries.push_back({ std::move(f.text), {} });
+            }
+            m_entries[it->second].occurrences.push_back({ file, f.offset, std::move(f.path) });
+        }
+    }
+    return true;
+}
+
+bool StringTable::save(const fs::path& table_path) const
+{
+    ojson js;
+    auto& strings = js["strings"] = ojson::value_t::array;
+    size_t occurrences = 0;
+    for (size_t id = 0; id < m_entries.size(); ++id)
+    {
+        const auto& entry = m_entries[id];
+        ojson string;
+        string["id"] = id;
+        string["source"] = entry.text;
+        string["text"] = entry.text;
+        auto& places = string["occurrences"] = ojson::value_t::array;
+        for (const auto& occurrence : entry.occurrences)
+        {
+            places.push_back({ { "file", occurrence.file }, { "offset", occurrence.offset }, { "path", occurrence.path } });
+        }
+        occurrences += entry.occurrences.size();
+        strings.push_back(std::move(string));
+    }
+    if (!save_report(table_path, js, "String table"))
+    {
+        return false;
+    }
+    spdlog::info("{} strings, {} occurrences", m_entries.size(), occurrences);
+    return true;
+}
+
+bool StringTable::import(const fs::path& root, const fs::path& table_path, size_t threads)
+{
+    m_imported.clear();
+    ojson table;
+    try
+    {
+        std::ifstream in{ table_path };
+        in >> table;
+    }
+    catch (std::exception& e)
+    {
+        spdlog::error("Failed to parse string table '{}': {}", table_path.string(), e.what());
+        return false;
+    }
+    if (!table.contains("strings") || !table["strings"].is_array())
+    {
+        spdlog::error("'{}' is not a string table", table_path.string());
+        return false;
+    }
+
+    // translated occurrences grouped by file, every file is patched once
+    std::map<std::string, Patch> patches;
+    const auto& strings = table["strings"];
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+        const auto& string = strings[i];
+        if (!string.is_object() || !string.contains("source") || !string.contains("text") || !string["text"].is_string() ||
+            string["source"] == string["text"] || !string.contains("occurrences") || !string["occurrences"].is_array())
+        {
+            continue;
+        }
+        for (const auto& occurrence : string["occurrences"])
+        {
+            if (!occurrence.is_object() || !occurrence.contains("file") || !occurrence["file"].is_string() ||
+                !occurrence.contains("path") || !occurrence["path"].is_string())
+            {
+                spdlog::warn("String {} of '{}' has an occurrence without file or path, skipped", i, table_path.string());
+                continue;
+            }
+            const auto file = fs::path{ occurrence["file"].get<std::string>() };
+            if (!under_base(file))
+            {
+                spdlog::warn("String {} of '{}' has file '{}' outside of '{}', skipped", i, table_path.string(), file.string(), root.string());
+                continue;
+            }
+            patches[file.lexically_normal().generic_string()].edits().push_back(
+                { occurrence["path"].get<std::string>(), string["source"], string["text"] });
+        }
+    }
+
+    const auto base = base_of(root);
+    std::vector<const Patch*> file_patches;
+    for (const auto& [file, patch] : patches)
+    {
+        auto& imported = m_imported.emplace_back();
+        imported.file = base / fs::path{ file };
+        imported.strings = patch.edits().size();
+        file_patches.push_back(&patch);
+    }
+    parallel_for(m_imported.size(), threads, [&](size_t i)
+        {
+            auto& imported = m_imported[i];
+            MerkleTree tree;
+            if (!tree.open(imported.file) || !tree.build())
+            {
+                spdlog::error("File '{}' not patched, it can't be parsed", imported.file.string());
+                ++imported.result.failed;
+                return;
+            }
+            imported.result = file_patches[i]->apply(imported.file, tree.parser(), tree, nullptr);
+        });
+    return true;
+}
+
+void StringTable::print_import() const
+{
+    size_t patched = 0;
+    size_t strings = 0;
+    size_t unchanged = 0;
+    size_t mismatched = 0;
+    size_t failed = 0;
+    for (const auto& imported : m_imported)
+    {
+        if (imported.result.ok)
+        {
+            ++patched;
+            strings += imported.result.applied;
+            unchanged += imported.result.unchanged;
+        }
+        else
+        {
+            spdlog::warn("File '{}' not patched, {} strings changed since export, {} can't be applied", imported.file.string(),
+                imported.result.mismatched, imported.result.failed);
+        }
+        mismatched += imported.result.mismatched;
+        failed += imported.result.failed;
+    }
+    spdlog::info("Imported strings into {} of {} files, {} strings written, {} already translated, {} changed since export, {} failed",
+        patched, m_imported.size(), strings, unchanged, mismatched, failed);
+}
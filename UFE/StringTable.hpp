@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "Patch.hpp"
+
+// Every string of a corpus in one table for translation. Each distinct text is
+// listed once with the places it occurs, a file relative to the table's root, the
+// offset of its length prefix in the decoded stream and its member path:
+//
+//   {"strings": [{"id": 0, "source": "Boots", "text": "Boots",
+//                 "occurrences": [{"file": "items/boots.item", "offset": 1234, "path": "@1.Name"}]}]}
+//
+// Translators change "text", importing groups the strings whose text differs from
+// their source by file and patches every affected binary once; a string that no
+// longer has its source text is reported and its file left alone. Files are
+// scanned and patched in parallel, empty strings aren't listed.
+class StringTable
+{
+public:
+    struct Occurrence
+    {
+        std::string file;
+        uint64_t offset;
+        std::string path;
+    };
+    struct Entry
+    {
+        std::string text;
+        std::vector<Occurrence> occurrences;
+    };
+    struct FileImport
+    {
+        std::filesystem::path file;
+        size_t strings = 0; // translated occurrences
+        Patch::Result result;
+    };
+
+    bool extract(const std::filesystem::path& root, size_t threads);
+    bool save(const std::filesystem::path& table_path) const;
+    const std::vector<Entry>& entries() const noexcept { return m_entries; }
+
+    // root is the file or directory the table was extracted from
+    bool import(const std::filesystem::path& root, const std::filesystem::path& table_path, size_t threads);
+    const std::vector<FileImport>& imported() const noexcept { return m_imported; }
+    void print_import() const;
+private:
+    std::vector<Entry> m_entries;
+    std::vector<FileImport> m_imported;
+};
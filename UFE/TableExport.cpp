@@ -0,0 +1,602 @@
+#include "TableExport.hpp"
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
+#include <spdlog/spdlog.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    using EColumnType = TableSet::EColumnType;
+
+    size_t width(EColumnType type)
+    {
+        switch (type)
+        {
+            case EColumnType::Bool:
+            case EColumnType::Int8:
+            case EColumnType::UInt8:
+                return 1;
+            case EColumnType::Int16:
+            case EColumnType::UInt16:
+                return 2;
+            case EColumnType::Int32:
+            case EColumnType::UInt32:
+            case EColumnType::Float:
+            case EColumnType::Reference:
+                return 4;
+            case EColumnType::Int64:
+            case EColumnType::UInt64:
+            case EColumnType::Double:
+                return 8;
+            case EColumnType::String:
+            default:
+                return 0;
+        }
+    }
+
+    template <typename T>
+    constexpr EColumnType column_type_of()
+    {
+        if constexpr (std::is_same_v<T, bool>) return EColumnType::Bool;
+        else if constexpr (std::is_same_v<T, char>) return EColumnType::Int8;
+        else if constexpr (std::is_same_v<T, unsigned char>) return EColumnType::UInt8;
+        else if constexpr (std::is_same_v<T, int16_t>) return EColumnType::Int16;
+        else if constexpr (std::is_same_v<T, uint16_t>) return EColumnType::UInt16;
+        else if constexpr (std::is_same_v<T, int32_t>) return EColumnType::Int32;
+        else if constexpr (std::is_same_v<T, uint32_t>) return EColumnType::UInt32;
+        else if constexpr (std::is_same_v<T, int64_t>) return EColumnType::Int64;
+        else if constexpr (std::is_same_v<T, uint64_t>) return EColumnType::UInt64;
+        else if constexpr (std::is_same_v<T, float>) return EColumnType::Float;
+        else return EColumnType::Double;
+    }
+
+    // member type from BinaryTypeEnums and its AdditionalInfos entry
+    EColumnType column_type(ufe::EBinaryTypeEnumeration type, const ufe::AdditionalInfosType* info)
+    {
+        if (type == ufe::EBinaryTypeEnumeration::String)
+        {
+            return EColumnType::String;
+        }
+        if (type != ufe::EBinaryTypeEnumeration::Primitive || !info || !std::holds_alternative<ufe::EPrimitiveTypeEnumeration>(*info))
+        {
+            return EColumnType::Reference;
+        }
+        switch (std::get<ufe::EPrimitiveTypeEnumeration>(*info))
+        {
+            case ufe::EPrimitiveTypeEnumeration::Boolean: return EColumnType::Bool;
+            case ufe::EPrimitiveTypeEnumeration::Byte: return EColumnType::UInt8;
+            case ufe::EPrimitiveTypeEnumeration::Char:
+            case ufe::EPrimitiveTypeEnumeration::SByte: return EColumnType::Int8;
+            case ufe::EPrimitiveTypeEnumeration::Double: return EColumnType::Double;
+            case ufe::EPrimitiveTypeEnumeration::Int16: return EColumnType::Int16;
+            case ufe::EPrimitiveTypeEnumeration::Int32: return EColumnType::Int32;
+            case ufe::EPrimitiveTypeEnumeration::Single: return EColumnType::Float;
+            case ufe::EPrimitiveTypeEnumeration::UInt16: return EColumnType::UInt16;
+            case ufe::EPrimitiveTypeEnumeration::UInt32: return EColumnType::UInt32;
+            case ufe::EPrimitiveTypeEnumeration::UInt64: return EColumnType::UInt64;
+            case ufe::EPrimitiveTypeEnumeration::Int64:
+            case ufe::EPrimitiveTypeEnumeration::TimeSpan:
+            case ufe::EPrimitiveTypeEnumeration::DateTime:
+            default:
+                return EColumnType::Int64;
+        }
+    }
+
+    // member types with an entry in AdditionalInfos
+    bool has_additional_info(ufe::EBinaryTypeEnumeration type)
+    {
+        return type == ufe::EBinaryTypeEnumeration::Primitive || type == ufe::EBinaryTypeEnumeration::SystemClass ||
+            type == ufe::EBinaryTypeEnumeration::Class || type == ufe::EBinaryTypeEnumeration::PrimitiveArray;
+    }
+
+    template <typename T>
+    std::string to_text(T value)
+    {
+        char buffer[32];
+        const auto [end, ec] = std::to_chars(std::begin(buffer), std::end(buffer), value);
+        return { buffer, end };
+    }
+
+    template <typename T>
+    T load(const uint8_t* p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+
+    // class names become file names, generic arguments and namespaces included
+    std::string file_name(const std::string& name)
+    {
+        std::string result = name;
+        for (auto& c : result)
+        {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '_' && c != '-')
+            {
+                c = '_';
+            }
+        }
+        return result;
+    }
+
+    // file systems may ignore case, names are compared lower cased
+    std::string file_key(std::string name)
+    {
+        for (auto& c : name)
+        {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return name;
+    }
+
+    void csv_field(std::ostream& out, std::string_view text)
+    {
+        if (text.find_first_of(",\"\r\n") == std::string_view::npos)
+        {
+            out << text;
+            return;
+        }
+        out << '"';
+        for (auto c : text)
+        {
+            if (c == '"')
+            {
+                out << '"';
+            }
+            out << c;
+        }
+        out << '"';
+    }
+
+    template <typename T>
+    void put(std::string& out, T value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void put(std::string& out, std::string_view text)
+    {
+        put(out, static_cast<uint32_t>(text.size()));
+        out.append(text);
+    }
+}
+
+void TableSet::begin_file(const fs::path& file)
+{
+    m_ctx = {};
+    m_ctx.file = static_cast<uint32_t>(m_files.size());
+    m_files.push_back(file.string());
+}
+
+void TableSet::add(const std::any& record)
+{
+    walk(record);
+}
+
+void TableSet::end_file()
+{
+    for (const auto& fixup : m_ctx.fixups)
+    {
+        if (const auto it = m_ctx.strings.find(fixup.string_id); it != m_ctx.strings.end())
+        {
+            auto& column = m_tables[fixup.table].columns[fixup.column];
+            column.strings[fixup.row] = it->second;
+            column.valid[fixup.row] = 1;
+        }
+    }
+    m_ctx = {};
+}
+
+void TableSet::walk(const std::any& record)
+{
+    const auto type = std::type_index(record.type());
+    if (type == std::type_index(typeid(ufe::ClassWithMembersAndTypes)))
+    {
+        const auto& cmt = std::any_cast<const ufe::ClassWithMembersAndTypes&>(record);
+        add_class(cmt.m_ClassInfo, cmt.m_MemberTypeInfo);
+    }
+    else if (type == std::type_index(typeid(ufe::ClassWithId)))
+    {
+        const auto& cwi = std::any_cast<const ufe::ClassWithId&>(record);
+        add_class(cwi.m_ClassInfo, cwi.m_MemberTypeInfo);
+    }
+    else if (type == std::type_index(typeid(ufe::BinaryObjectString)))
+    {
+        const auto& bos = std::any_cast<const ufe::BinaryObjectString&>(record);
+        m_ctx.strings[bos.m_ObjectId] = bos.m_Value.value.string;
+    }
+    else if (type == std::type_index(typeid(ufe::BinaryArray)))
+    {
+        for (const auto& element : std::any_cast<const ufe::BinaryArray&>(record).Data)
+        {
+            walk(element);
+        }
+    }
+    else if (type == std::type_index(typeid(ufe::ArraySingleString)))
+    {
+        for (const auto& element : std::any_cast<const ufe::ArraySingleString&>(record).Data)
+        {
+            walk(element);
+        }
+    }
+}
+
+void TableSet::add_class(const ufe::ClassInfo& ci, const ufe::MemberTypeInfo& mti)
+{
+    const auto t = table(StringInterner::str(ci.NameId));
+    add_row(m_tables[t]);
+    const auto row = m_tables[t].rows - 1;
+    m_tables[t].files[row] = m_ctx.file;
+    m_tables[t].object_ids[row] = ci.ObjectId.value;
+
+    const auto members = std::min({ mti.BinaryTypeEnums.size(), mti.Data.size(), ci.MemberNameIds.size() });
+    size_t add_info = 0;
+    for (size_t i = 0; i < members; ++i)
+    {
+        const auto binary_type = mti.BinaryTypeEnums[i];
+        const ufe::AdditionalInfosType* info = nullptr;
+        if (has_additional_info(binary_type) && add_info < mti.AdditionalInfos.size())
+        {
+            info = &mti.AdditionalInfos[add_info++];
+        }
+        const auto& data = mti.Data[i];
+        if (data.type() == typeid(ufe::SkippedValue))
+        {
+            // not selected by --select
+            continue;
+        }
+        const auto c = column(m_tables[t], StringInterner::str(ci.MemberNameIds[i]), column_type(binary_type, info));
+        set_value(t, c, row, data);
+        // nested objects get rows of their own, tables may be added meanwhile
+        walk(data);
+    }
+}
+
+void TableSet::set_value(size_t t, size_t c, size_t row, const std::any& value)
+{
+    auto& table = m_tables[t];
+    auto& column = table.columns[c];
+    auto set_fixed = [&]<typename T>(const T& v)
+    {
+        if (column.type != column_type_of<T>())
+        {
+            ++table.type_conflicts;
+            return;
+        }
+        std::memcpy(&column.data[row * sizeof(T)], &v, sizeof(T));
+        column.valid[row] = 1;
+    };
+    auto set_reference = [&](int32_t id)
+    {
+        if (column.type != EColumnType::Reference)
+        {
+            ++table.type_conflicts;
+            return;
+        }
+        std::memcpy(&column.data[row * sizeof(int32_t)], &id, sizeof(int32_t));
+        column.valid[row] = 1;
+    };
+
+    const auto type = std::type_index(value.type());
+    if (type == std::type_index(typeid(IndexedData<bool>))) set_fixed(std::any_cast<const IndexedData<bool>&>(value).value);
+    else if (type == std::type_index(typeid(IndexedData<char>))) set_fixed(std::any_cast<const IndexedData<char>&>(value).value);
+    else if (type == std::type_index(typeid(IndexedData<unsigned char>))) set_fixed(std::any_cast<const IndexedData<unsigned char>&>(value).value);
+    else if (type == std::type_index(typeid(IndexedData<int16_t>))) set_fixed(std::any_cast<const IndexedData<int16_t>&>(value).value);
+    else if (type == std::type_index(typeid(IndexedData<uint16_t>))) set_fixed(std::any_cast<const IndexedData<uint16_t>&>(value).value);
+    else if (type == std::type_index(typeid(IndexedData<int32_t>))) set_fixed(std::any_cast<const IndexedData<int32_t>&>(value).value);
+    else if (type == std::type_index(typeid(IndexedData<uint32_t>))) set_fixed(std::any_cast<const IndexedData<uint32_t>&>(value).value);
+    else if (type == std::type_index(typeid(IndexedData<int64_t>))) set_fixed(std::any_cast<const IndexedData<int64_t>&>(value).value);
+    else if (type == std::type_index(typeid(IndexedData<uint64_t>))) set_fixed(std::any_cast<const IndexedData<uint64_t>&>(value).value);
+    else if (type == std::type_index(typeid(IndexedData<float>))) set_fixed(std::any_cast<const IndexedData<float>&>(value).value);
+    else if (type == std::type_index(typeid(IndexedData<double>))) set_fixed(std::any_cast<const IndexedData<double>&>(value).value);
+    else if (type == std::type_index(typeid(ufe::BinaryObjectString)))
+    {
+        const auto& bos = std::any_cast<const ufe::BinaryObjectString&>(value);
+        if (column.type == EColumnType::String)
+        {
+            column.strings[row] = bos.m_Value.value.string;
+            column.valid[row] = 1;
+        }
+        else
+        {
+            set_reference(bos.m_ObjectId);
+        }
+    }
+    else if (type == std::type_index(typeid(ufe::MemberReference)))
+    {
+        const auto id = std::any_cast<const ufe::MemberReference&>(value).m_idRef;
+        if (column.type == EColumnType::String)
+        {
+            m_ctx.fixups.push_back({ t, c, row, id });
+        }
+        else
+        {
+            set_reference(id);
+        }
+    }
+    else if (type == std::type_index(typeid(ufe::ClassWithMembersAndTypes))) set_reference(std::any_cast<const ufe::ClassWithMembersAndTypes&>(value).m_ClassInfo.ObjectId.value);
+    else if (type == std::type_index(typeid(ufe::ClassWithId))) set_reference(std::any_cast<const ufe::ClassWithId&>(value).m_ClassInfo.ObjectId.value);
+    else if (type == std::type_index(typeid(ufe::BinaryArray))) set_reference(std::any_cast<const ufe::BinaryArray&>(value).ObjectId);
+    else if (type == std::type_index(typeid(ufe::ArraySingleString))) set_reference(std::any_cast<const ufe::ArraySingleString&>(value).ObjectId);
+    else if (type == std::type_index(typeid(ufe::ArraySinglePrimitive))) set_reference(std::any_cast<const ufe::ArraySinglePrimitive&>(value).ObjectId);
+    // ObjectNull and anything unknown stay null
+}
+
+size_t TableSet::table(const std::string& name)
+{
+    if (const auto it = m_table_index.find(name); it != m_table_index.end())
+    {
+        return it->second;
+    }
+    m_tables.emplace_back().name = name;
+    m_table_index.emplace(name, m_tables.size() - 1);
+    return m_tables.size() - 1;
+}
+
+size_t TableSet::column(Table& table, const std::string& name, EColumnType type)
+{
+    if (const auto it = table.column_index.find(name); it != table.column_index.end())
+    {
+        return it->second;
+    }
+    // earlier rows don't have the member
+    auto& column = table.columns.emplace_back();
+    column.name = name;
+    column.type = type;
+    column.valid.resize(table.rows);
+    column.data.resize(table.rows * width(type));
+    if (type == EColumnType::String)
+    {
+        column.strings.resize(table.rows);
+    }
+    table.column_index.emplace(name, table.columns.size() - 1);
+    return table.columns.size() - 1;
+}
+
+void TableSet::add_row(Table& table)
+{
+    ++table.rows;
+    table.files.push_back(0);
+    table.object_ids.push_back(0);
+    for (auto& column : table.columns)
+    {
+        column.valid.push_back(0);
+        column.data.resize(column.data.size() + width(column.type));
+        if (column.type == EColumnType::String)
+        {
+            column.strings.emplace_back();
+        }
+    }
+}
+
+void TableSet::append(TableSet&& other)
+{
+    const auto file_offset = static_cast<uint32_t>(m_files.size());
+    m_files.insert(m_files.end(), std::make_move_iterator(other.m_files.begin()), std::make_move_iterator(other.m_files.end()));
+    for (auto& src : other.m_tables)
+    {
+        auto& dst = m_tables[table(src.name)];
+        const auto first = dst.rows;
+        for (size_t row = 0; row < src.rows; ++row)
+        {
+            add_row(dst);
+            dst.files[first + row] = src.files[row] + file_offset;
+            dst.object_ids[first + row] = src.object_ids[row];
+        }
+        dst.type_conflicts += src.type_conflicts;
+        for (auto& src_column : src.columns)
+        {
+            auto& dst_column = dst.columns[column(dst, src_column.name, src_column.type)];
+            if (dst_column.type != src_column.type)
+            {
+                dst.type_conflicts += std::count(src_column.valid.begin(), src_column.valid.end(), 1);
+                continue;
+            }
+            std::copy(src_column.valid.begin(), src_column.valid.end(), dst_column.valid.begin() + first);
+            std::copy(src_column.data.begin(), src_column.data.end(), dst_column.data.begin() + first * width(dst_column.type));
+            std::move(src_column.strings.begin(), src_column.strings.end(), dst_column.strings.begin() + first);
+        }
+    }
+    other = {};
+}
+
+bool TableSet::save(const fs::path& dir) const
+{
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    bool saved = true;
+    // different classes can map to the same file name, later ones get a numbered suffix
+    std::unordered_set<std::string> used;
+    for (const auto& table : m_tables)
+    {
+        auto name = file_name(table.name);
+        if (!used.insert(file_key(name)).second)
+        {
+            const auto base = name;
+            size_t n = 2;
+            do
+            {
+                name = base + '_' + std::to_string(n++);
+            } while (!used.insert(file_key(name)).second);
+            spdlog::warn("Class '{}' has the same file name as another class, saved as '{}'", table.name, name);
+        }
+        saved = save_csv(dir / (name + ".csv"), table) && saved;
+        saved = save_binary(dir / (name + ".ufetable"), table) && saved;
+    }
+    spdlog::info("Saved {} tables to '{}'", m_tables.size(), dir.string());
+    return saved;
+}
+
+bool TableSet::save_csv(const fs::path& path, const Table& table) const
+{
+    std::ofstream out{ path, std::ios::binary };
+    if (!out)
+    {
+        spdlog::error("Could not save '{}'", path.string());
+        return false;
+    }
+    out << "file,object_id";
+    for (const auto& column : table.columns)
+    {
+        out << ',';
+        csv_field(out, column.name);
+    }
+    out << '\n';
+    for (size_t row = 0; row < table.rows; ++row)
+    {
+        csv_field(out, m_files[table.files[row]]);
+        out << ',' << table.object_ids[row];
+        for (const auto& column : table.columns)
+        {
+            out << ',';
+            if (!column.valid[row])
+            {
+                continue;
+            }
+            const auto* p = column.data.data() + row * width(column.type);
+            switch (column.type)
+            {
+                case EColumnType::Bool: out << (load<bool>(p) ? "true" : "false"); break;
+                case EColumnType::Int8: out << static_cast<int>(load<char>(p)); break;
+                case EColumnType::UInt8: out << static_cast<int>(load<unsigned char>(p)); break;
+                case EColumnType::Int16: out << load<int16_t>(p); break;
+                case EColumnType::UInt16: out << load<uint16_t>(p); break;
+                case EColumnType::Int32:
+                case EColumnType::Reference: out << load<int32_t>(p); break;
+                case EColumnType::UInt32: out << load<uint32_t>(p); break;
+                case EColumnType::Int64: out << load<int64_t>(p); break;
+                case EColumnType::UInt64: out << load<uint64_t>(p); break;
+                // shortest text that reads back to the same value
+                case EColumnType::Float: out << to_text(load<float>(p)); break;
+                case EColumnType::Double: out << to_text(load<double>(p)); break;
+                case EColumnType::String: csv_field(out, column.strings[row]); break;
+            }
+        }
+        out << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool TableSet::save_binary(const fs::path& path, const Table& table) const
+{
+    struct Block
+    {
+        std::string_view name;
+        EColumnType type;
+        std::string data;
+    };
+    const size_t bitmap_size = (table.rows + 7) / 8;
+    auto make_block = [&](std::string_view name, EColumnType type)
+    {
+        Block block{ name, type, {} };
+        block.data.assign(bitmap_size, '\0');
+        return block;
+    };
+
+    std::vector<Block> blocks;
+    blocks.reserve(table.columns.size() + 2);
+    {
+        auto& files = blocks.emplace_back(make_block("file", EColumnType::UInt32));
+        auto& ids = blocks.emplace_back(make_block("object_id", EColumnType::Int32));
+        for (size_t row = 0; row < table.rows; ++row)
+        {
+            files.data[row / 8] |= static_cast<char>(1 << (row % 8));
+            ids.data[row / 8] |= static_cast<char>(1 << (row % 8));
+        }
+        files.data.append(reinterpret_cast<const char*>(table.files.data()), table.files.size() * sizeof(uint32_t));
+        ids.data.append(reinterpret_cast<const char*>(table.object_ids.data()), table.object_ids.size() * sizeof(int32_t));
+    }
+    for (const auto& column : table.columns)
+    {
+        auto& block = blocks.emplace_back(make_block(column.name, column.type));
+        for (size_t row = 0; row < table.rows; ++row)
+        {
+            if (column.valid[row])
+            {
+                block.data[row / 8] |= static_cast<char>(1 << (row % 8));
+            }
+        }
+        if (column.type == EColumnType::String)
+        {
+            uint64_t offset = 0;
+            put(block.data, offset);
+            for (const auto& s : column.strings)
+            {
+                offset += s.size();
+                put(block.data, offset);
+            }
+            for (const auto& s : column.strings)
+            {
+                block.data.append(s);
+            }
+        }
+        else
+        {
+            block.data.append(reinterpret_cast<const char*>(column.data.data()), column.data.size());
+        }
+    }
+
+    std::string header{ "UFETAB1", 8 };
+    put(header, static_cast<uint64_t>(table.rows));
+    put(header, static_cast<uint32_t>(blocks.size()));
+    put(header, static_cast<uint32_t>(m_files.size()));
+    for (const auto& file : m_files)
+    {
+        put(header, std::string_view{ file });
+    }
+    size_t header_size = header.size();
+    for (const auto& block : blocks)
+    {
+        header_size += sizeof(uint32_t) + block.name.size() + sizeof(uint8_t) + 2 * sizeof(uint64_t);
+    }
+    auto align = [](uint64_t offset) { return (offset + 7) & ~uint64_t{ 7 }; };
+    uint64_t offset = align(header_size);
+    for (const auto& block : blocks)
+    {
+        put(header, block.name);
+        put(header, static_cast<uint8_t>(block.type));
+        put(header, offset);
+        put(header, static_cast<uint64_t>(block.data.size()));
+        offset = align(offset + block.data.size());
+    }
+
+    std::ofstream out{ path, std::ios::binary };
+    if (!out)
+    {
+        spdlog::error("Could not save '{}'", path.string());
+        return false;
+    }
+    out.write(header.data(), header.size());
+    const char padding[8] = {};
+    uint64_t written = header.size();
+    for (const auto& block : blocks)
+    {
+        out.write(padding, align(written) - written);
+        out.write(block.data.data(), block.data.size());
+        written = align(written) + block.data.size();
+    }
+    return static_cast<bool>(out);
+}
+
+void TableSet::print() const
+{
+    size_t rows = 0;
+    for (const auto& table : m_tables)
+    {
+        rows += table.rows;
+    }
+    spdlog::info("{} tables with {} rows from {} files", m_tables.size(), rows, m_files.size());
+    spdlog::info("{:>8}{:>9}  {}", "rows", "columns", "class");
+    for (const auto& table : m_tables)
+    {
+        spdlog::info("{:>8}{:>9}  {}", table.rows, table.columns.size() + 2, table.name);
+        if (table.type_conflicts)
+        {
+            spdlog::warn("Class '{}' has {} values of members typed differently across files, left empty", table.name, table.type_conflicts);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <any>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Records.hpp"
+
+// Columnar export for analysis across a corpus. Every class name gets one table
+// with a row per instance, wherever the instance sits in the record tree, and a
+// typed column per member next to the source file and object id columns.
+// Members typed as classes, objects or arrays hold the object id they refer to.
+//
+// Tables are saved as '<class>.csv' and as '<class>.ufetable', a binary layout
+// where every column is one contiguous block (host byte order, little endian on
+// all supported platforms):
+//   char[8]   "UFETAB1"
+//   uint64    rows
+//   uint32    columns
+//   uint32    files, followed by uint32 length and bytes of every file path
+//   columns x uint32 name length, name bytes, uint8 EColumnType,
+//             uint64 block offset from the start of the file, uint64 block size
+//   blocks    8 bytes aligned, validity bitmap of (rows + 7) / 8 bytes (bit set
+//             when the row has a value), then rows fixed width values, or for
+//             strings rows + 1 uint64 offsets into the character data after them
+// The file column is a UInt32 index into the file paths.
+class TableSet
+{
+public:
+    enum class EColumnType : uint8_t
+    {
+        Bool,
+        Int8,
+        UInt8,
+        Int16,
+        UInt16,
+        Int32,
+        UInt32,
+        Int64,
+        UInt64,
+        Float,
+        Double,
+        String,
+        Reference // int32 object id
+    };
+
+    // rows for every class record in the root records of a file, string members
+    // referencing strings of the same file are resolved by end_file; the parser
+    // has to outlive end_file since strings are views into its buffer
+    void begin_file(const std::filesystem::path& file);
+    void add(const std::any& record);
+    void end_file();
+    // rows of other are appended after the rows of this set
+    void append(TableSet&& other);
+
+    bool empty() const noexcept { return m_tables.empty(); }
+    // '<class>.csv' and '<class>.ufetable' for every table, class names mapping to
+    // the same file name, ignoring case, get a numbered suffix and a warning
+    bool save(const std::filesystem::path& dir) const;
+    // tables with row and column counts, logged at info level
+    void print() const;
+private:
+    struct Column
+    {
+        std::string name;
+        EColumnType type = EColumnType::Int32;
+        std::vector<uint8_t> valid; // one byte per row
+        std::vector<uint8_t> data;  // fixed width values
+        std::vector<std::string> strings;
+    };
+    struct Table
+    {
+        std::string name;
+        size_t rows = 0;
+        std::vector<uint32_t> files;
+        std::vector<int32_t> object_ids;
+        std::vector<Column> columns;
+        std::unordered_map<std::string, size_t> column_index;
+        uint64_t type_conflicts = 0; // values dropped because their member type differs from the column
+    };
+    // string member referencing a string object of the same file
+    struct StringFixup
+    {
+        size_t table;
+        size_t column;
+        size_t row;
+        int32_t string_id;
+    };
+    struct FileContext
+    {
+        uint32_t file = 0;
+        std::unordered_map<int32_t, std::string_view> strings;
+        std::vector<StringFixup> fixups;
+    };
+
+    void walk(const std::any& record);
+    void add_class(const ufe::ClassInfo& ci, const ufe::MemberTypeInfo& mti);
+    void set_value(size_t table, size_t column, size_t row, const std::any& value);
+    // index into m_tables, tables are added while rows of others are filled
+    size_t table(const std::string& name);
+    size_t column(Table& table, const std::string& name, EColumnType type);
+    static void add_row(Table& table);
+
+    bool save_csv(const std::filesystem::path& path, const Table& table) const;
+    bool save_binary(const std::filesystem::path& path, const Table& table) const;
+
+    FileContext m_ctx;
+    std::vector<std::string> m_files;
+    std::vector<Table> m_tables;
+    std::unordered_map<std::string, size_t> m_table_index;
+};
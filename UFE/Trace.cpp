@@ -0,0 +1,122 @@
+#include "Trace.hpp"
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char* name;
+        uint32_t file_id;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::duration duration;
+    };
+
+    struct ThreadBuffer
+    {
+        uint32_t tid = 0;
+        std::vector<TraceEvent> events;
+    };
+
+    std::atomic<bool> s_enabled{ false };
+    const auto s_origin = std::chrono::steady_clock::now();
+    std::mutex s_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> s_buffers;
+    std::vector<std::string> s_files{ "" };
+    thread_local uint32_t t_current_file = 0;
+
+    ThreadBuffer& thread_buffer()
+    {
+        thread_local std::shared_ptr<ThreadBuffer> buffer = []
+        {
+            auto buf = std::make_shared<ThreadBuffer>();
+            std::lock_guard lock{ s_mutex };
+            buf->tid = static_cast<uint32_t>(s_buffers.size() + 1);
+            s_buffers.push_back(buf);
+            return buf;
+        }();
+        return *buffer;
+    }
+
+    double to_us(std::chrono::steady_clock::duration d)
+    {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+}
+
+void Tracer::enable(bool enabled /* = true */) noexcept
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Tracer::enabled() noexcept
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::add_span(const char* name, std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end)
+{
+    thread_buffer().events.push_back({ name, t_current_file, start, end - start });
+}
+
+uint32_t Tracer::current_file() noexcept
+{
+    return t_current_file;
+}
+
+uint32_t Tracer::set_current_file(uint32_t file_id) noexcept
+{
+    auto prev = t_current_file;
+    t_current_file = file_id;
+    return prev;
+}
+
+uint32_t Tracer::register_file(const std::filesystem::path& file)
+{
+    std::lock_guard lock{ s_mutex };
+    s_files.push_back(file.string());
+    return static_cast<uint32_t>(s_files.size() - 1);
+}
+
+bool Tracer::save(const std::filesystem::path& trace_path)
+{
+    std::ofstream out{ trace_path };
+    if (!out)
+    {
+        spdlog::error("Could not save trace '{}'", trace_path.string());
+        return false;
+    }
+
+    std::lock_guard lock{ s_mutex };
+    size_t count = 0;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << R"({"name":"process_name","ph":"M","pid":1,"tid":0,"args":{"name":"UFE"}})";
+    for (const auto& buf : s_buffers)
+    {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buf->tid
+            << ",\"args\":{\"name\":\"worker " << buf->tid << "\"}}";
+        for (const auto& ev : buf->events)
+        {
+            out << ",\n{\"name\":\"" << ev.name << "\",\"cat\":\"ufe\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buf->tid
+                << ",\"ts\":" << to_us(ev.start - s_origin) << ",\"dur\":" << to_us(ev.duration);
+            if (ev.file_id)
+            {
+                out << ",\"args\":{\"file\":" << nlohmann::json(s_files[ev.file_id]).dump() << "}";
+            }
+            out << "}";
+            ++count;
+        }
+    }
+    out << "\n]}\n";
+    spdlog::info("Trace with {} spans saved to '{}'", count, trace_path.string());
+    return true;
+}
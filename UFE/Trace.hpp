@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+// Chrome trace event format recorder (chrome://tracing, ui.perfetto.dev).
+// Always compiled in, disabled spans only cost one relaxed atomic load.
+class Tracer
+{
+public:
+    static void enable(bool enabled = true) noexcept;
+    static bool enabled() noexcept;
+
+    // spans are buffered per thread and written out at once
+    static bool save(const std::filesystem::path& trace_path);
+
+    // name must have static storage duration
+    static void add_span(const char* name, std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end);
+
+    // file tagged on spans of the current thread, 0 means no file
+    static uint32_t current_file() noexcept;
+    static uint32_t set_current_file(uint32_t file_id) noexcept;
+    static uint32_t register_file(const std::filesystem::path& file);
+};
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name) noexcept : m_name{ name }
+    {
+        if (Tracer::enabled())
+        {
+            m_active = true;
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+    // top level span of a file, nested spans on this thread are tagged with it
+    TraceScope(const char* name, const std::filesystem::path& file) : TraceScope(name)
+    {
+        if (m_active)
+        {
+            m_prev_file = Tracer::set_current_file(Tracer::register_file(file));
+            m_file_scope = true;
+        }
+    }
+    ~TraceScope() { stop(); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    void stop()
+    {
+        if (m_active)
+        {
+            Tracer::add_span(m_name, m_start, std::chrono::steady_clock::now());
+            if (m_file_scope)
+            {
+                Tracer::set_current_file(m_prev_file);
+            }
+            m_active = false;
+        }
+    }
+private:
+    const char* m_name;
+    bool m_active = false;
+    bool m_file_scope = false;
+    uint32_t m_prev_file = 0;
+    std::chrono::steady_clock::time_point m_start;
+};
@@ -0,0 +1,445 @@
+#include "Transform.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <spdlog/spdlog.h>
+#include "FileRoots.hpp"
+#include "Patch.hpp"
+#include "Pipeline.hpp"
+#include "Projection.hpp"
+#include "Report.hpp"
+
+namespace fs = std::filesystem;
+using ojson = nlohmann::ordered_json;
+
+namespace
+{
+    std::string_view trim(std::string_view text)
+    {
+        const auto begin = text.find_first_not_of(" \t");
+        if (begin == std::string_view::npos)
+        {
+            return {};
+        }
+        return text.substr(begin, text.find_last_not_of(" \t") - begin + 1);
+    }
+
+    // one of ops at the start of text, longer ops have to come first
+    bool take_op(std::string_view& text, std::initializer_list<std::string_view> ops, std::string& op)
+    {
+        text = trim(text);
+        for (const auto candidate : ops)
+        {
+            if (text.starts_with(candidate))
+            {
+                op = candidate;
+                text.remove_prefix(candidate.size());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // json literal at the start of text, strings may contain blanks
+    bool take_literal(std::string_view& text, ojson& value)
+    {
+        text = trim(text);
+        size_t end = 0;
+        if (text.starts_with('"'))
+        {
+            for (end = 1; end < text.size() && text[end] != '"'; ++end)
+            {
+                end += text[end] == '\\';
+            }
+            if (end >= text.size())
+            {
+                return false;
+            }
+            ++end;
+        }
+        else
+        {
+            end = std::min(text.find_first_of(" \t"), text.size());
+        }
+        try
+        {
+            value = ojson::parse(text.substr(0, end));
+        }
+        catch (std::exception&)
+        {
+            return false;
+        }
+        text.remove_prefix(end);
+        return true;
+    }
+
+    bool compare(const ojson& a, std::string_view op, const ojson& b)
+    {
+        int order = 0;
+        if (a.is_number() && b.is_number())
+        {
+            const auto x = a.get<double>();
+            const auto y = b.get<double>();
+            order = x < y ? -1 : (x > y ? 1 : 0);
+        }
+        else if (a.is_string() && b.is_string())
+        {
+            order = a.get_ref<const std::string&>().compare(b.get_ref<const std::string&>());
+        }
+        else if (op == "==" || op == "!=")
+        {
+            return (a == b) == (op == "==");
+        }
+        else
+        {
+            return false;
+        }
+        if (op == "==") return order == 0;
+        if (op == "!=") return order != 0;
+        if (op == "<") return order < 0;
+        if (op == "<=") return order <= 0;
+        if (op == ">") return order > 0;
+        return order >= 0;
+    }
+
+    // current updated with op and operand, false if the update doesn't apply to the value
+    bool update(const ojson& current, std::string_view op, const ojson& operand, ojson& result)
+    {
+        if (op == "=")
+        {
+            result = operand;
+            return true;
+        }
+        if (current.is_string())
+        {
+            if (op != "+=" || !operand.is_string())
+            {
+                return false;
+            }
+            result = current.get<std::string>() + operand.get<std::string>();
+            return true;
+        }
+        if (!current.is_number() || !operand.is_number())
+        {
+            return false;
+        }
+        const bool integer = current.is_number_integer();
+        if (integer && operand.is_number_integer() && (op == "+=" || op == "-=") && !current.is_number_unsigned())
+        {
+            constexpr auto max = std::numeric_limits<int64_t>::max();
+            constexpr auto min = std::numeric_limits<int64_t>::min();
+            const auto a = current.get<int64_t>();
+            const auto b = operand.get<int64_t>();
+            const bool overflow = op == "+=" ? (b > 0 ? a > max - b : a < min - b) : (b > 0 ? a < min + b : a > max + b);
+            if (overflow)
+            {
+                return false;
+            }
+            result = op == "+=" ? a + b : a - b;
+            return true;
+        }
+        const auto a = current.get<double>();
+        const auto b = operand.get<double>();
+        double r = 0;
+        if (op == "+=") r = a + b;
+        else if (op == "-=") r = a - b;
+        else if (op == "*=") r = a * b;
+        else if (b != 0) r = a / b;
+        else return false;
+        // members check their own range in Patch::fits, a float member rejects results beyond float range
+        if (!integer)
+        {
+            result = r;
+            return std::isfinite(r);
+        }
+        // integers are rounded
+        r = std::round(r);
+        if (!(r > -9.2e18 && r < 1.8e19))
+        {
+            return false;
+        }
+        if (r < 0)
+        {
+            result = static_cast<int64_t>(r);
+        }
+        else
+        {
+            result = static_cast<uint64_t>(r);
+        }
+        return true;
+    }
+}
+
+bool Transform::add(std::string_view text)
+{
+    Rule rule;
+    rule.text = text;
+    auto rest = trim(text);
+    const auto target = rest.substr(0, std::min(rest.find_first_of(" \t"), rest.size()));
+    rest.remove_prefix(target.size());
+    const auto colon = target.find(':');
+    if (colon == std::string_view::npos || colon == 0 || colon + 1 == target.size())
+    {
+        spdlog::error("Rule '{}' has no '<class>:<member path>'", text);
+        return false;
+    }
+    rule.class_name = target.substr(0, colon);
+    const auto path = target.substr(colon + 1);
+    for (size_t pos = 0; pos < path.size();)
+    {
+        if (path[pos] == '[')
+        {
+            const auto end = path.find(']', pos);
+            const auto index = path.substr(pos + 1, end == std::string_view::npos ? 0 : end - pos - 1);
+            int64_t value = -1;
+            if (end == std::string_view::npos || (index != "*" &&
+                std::from_chars(index.data(), index.data() + index.size(), value).ptr != index.data() + index.size()) || value < -1)
+            {
+                spdlog::error("Rule '{}' has an invalid element '{}'", text, path.substr(pos));
+                return false;
+            }
+            rule.steps.push_back({ {}, value });
+            pos = end + 1;
+            continue;
+        }
+        if (path[pos] == '.' && !rule.steps.empty())
+        {
+            ++pos;
+        }
+        const auto end = std::min(path.find_first_of(".[", pos), path.size());
+        if (end == pos)
+        {
+            spdlog::error("Rule '{}' has an empty member name", text);
+            return false;
+        }
+        rule.steps.push_back({ std::string{ path.substr(pos, end - pos) }, -1 });
+        pos = end;
+    }
+
+    rest = trim(rest);
+    if (rest.starts_with("if ") || rest.starts_with("if\t"))
+    {
+        rest.remove_prefix(2);
+        if (!take_op(rest, { "==", "!=", "<=", ">=", "<", ">" }, rule.compare) || !take_literal(rest, rule.compare_value))
+        {
+            spdlog::error("Rule '{}' has an invalid condition, 'if <==|!=|<|<=|>|>=> <value>'", text);
+            return false;
+        }
+    }
+    if (!take_op(rest, { "+=", "-=", "*=", "/=", "=" }, rule.update) || !take_literal(rest, rule.value) || !trim(rest).empty())
+    {
+        spdlog::error("Rule '{}' has an invalid update, '<=|+=|-=|*=|/=> <value>'", text);
+        return false;
+    }
+    if (rule.update != "=" && !rule.value.is_number() && !(rule.update == "+=" && rule.value.is_string()))
+    {
+        spdlog::error("Rule '{}' needs a number for '{}'", text, rule.update);
+        return false;
+    }
+    m_rules.push_back(std::move(rule));
+    return true;
+}
+
+bool Transform::run(const fs::path& root, size_t threads, bool dry_run, size_t preview)
+{
+    m_files.clear();
+    if (m_rules.empty())
+    {
+        spdlog::error("No transform rules");
+        return false;
+    }
+    // supported files in path order
+    for (auto& [relative, file] : supported_files(root))
+    {
+        m_files.emplace_back().file = std::move(file);
+    }
+    parallel_for(m_files.size(), threads, [&](size_t i) { transform(m_files[i], dry_run, preview); });
+    return true;
+}
+
+void Transform::match(const MerkleTree& tree, uint32_t node, const std::vector<Step>& steps, size_t step, std::vector<uint32_t>& targets)
+{
+    // members holding objects by reference continue at the object
+    if (tree.nodes()[node].kind == MerkleTree::EKind::Reference)
+    {
+        node = tree.object(tree.nodes()[node].object_id);
+        if (!node)
+        {
+            return;
+        }
+    }
+    if (step == steps.size())
+    {
+        targets.push_back(node);
+        return;
+    }
+    const auto& s = steps[step];
+    tree.for_each_child(node, [&](uint32_t child)
+        {
+            const auto& c = tree.nodes()[child];
+            const bool matches = s.name.empty() ? c.name.empty() && (s.index < 0 || c.index == s.index) :
+                !c.name.empty() && Projection::glob_match(s.name, c.name);
+            if (matches)
+            {
+                match(tree, child, steps, step + 1, targets);
+            }
+        });
+}
+
+void Transform::transform(FileTransform& file, bool dry_run, size_t preview) const
+{
+    MerkleTree tree;
+    if (!tree.open(file.file) || !tree.build())
+    {
+        spdlog::warn("File '{}' can't be transformed, parsing failed", file.file.string());
+        return;
+    }
+    const auto& nodes = tree.nodes();
+    // values set so far, in the order members were first edited
+    std::vector<uint32_t> edited;
+    std::unordered_map<uint32_t, ojson> values;
+    std::vector<uint32_t> targets;
+    for (const auto& rule : m_rules)
+    {
+        targets.clear();
+        for (uint32_t node = 1; node < nodes.size(); ++node)
+        {
+            if (nodes[node].kind == MerkleTree::EKind::Class && Projection::glob_match(rule.class_name, nodes[node].type))
+            {
+                match(tree, node, rule.steps, 0, targets);
+            }
+        }
+        // objects reached from several records are updated once
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        for (const auto target : targets)
+        {
+            const auto& n = nodes[target];
+            if (n.kind != MerkleTree::EKind::Value && n.kind != MerkleTree::EKind::String)
+            {
+                continue;
+            }
+            const auto it = values.find(target);
+            const auto current = it != values.end() ? it->second : tree.value(target);
+            if (!rule.compare.empty() && !compare(current, rule.compare, rule.compare_value))
+            {
+                continue;
+            }
+            // results that don't fit the member's type are rejected before they count as edits
+            ojson result;
+            if (!update(current, rule.update, rule.value, result) || !Patch::fits(n, result))
+            {
+                spdlog::debug("'{}' of '{}' can't be updated by '{}'", tree.path(target), file.file.string(), rule.text);
+                ++file.rejected;
+                continue;
+            }
+            if (it != values.end())
+            {
+                it->second = std::move(result);
+            }
+            else
+            {
+                edited.push_back(target);
+                values.emplace(target, std::move(result));
+            }
+        }
+    }
+
+    Patch patch;
+    for (const auto node : edited)
+    {
+        auto& value = values[node];
+        if (tree.equals(node, value))
+        {
+            continue;
+        }
+        if (file.preview.size() < preview)
+        {
+            file.preview.push_back({ tree.path(node), tree.value(node), value });
+        }
+        patch.edits().push_back({ tree.address(node), tree.value(node), std::move(value) });
+    }
+    file.edits = patch.edits().size();
+    file.ok = true;
+    if (!dry_run && file.edits)
+    {
+        const auto result = patch.apply(file.file, tree.parser(), tree, nullptr);
+        file.written = result.written;
+        file.ok = result.ok;
+    }
+}
+
+void Transform::print(size_t preview) const
+{
+    size_t changed = 0;
+    size_t written = 0;
+    size_t edits = 0;
+    size_t rejected = 0;
+    size_t failed = 0;
+    for (const auto& file : m_files)
+    {
+        failed += !file.ok;
+        edits += file.edits;
+        rejected += file.rejected;
+        written += file.written;
+        if (!file.edits)
+        {
+            continue;
+        }
+        ++changed;
+        spdlog::info("{} '{}', {} edits", file.written ? "Transformed" : "Would transform", file.file.string(), file.edits);
+        for (const auto& change : file.preview)
+        {
+            if (!preview)
+            {
+                break;
+            }
+            --preview;
+            spdlog::info("  ~ {}: {} -> {}", change.path, change.old_value.dump(), change.new_value.dump());
+        }
+    }
+    spdlog::info("Transformed {} files with {} rules: {} edits in {} files, {} files written, {} values rejected, {} files failed",
+        m_files.size(), m_rules.size(), edits, changed, written, rejected, failed);
+}
+
+nlohmann::ordered_json Transform::to_json() const
+{
+    ojson js;
+    js["rules"] = ojson::value_t::array;
+    for (const auto& rule : m_rules)
+    {
+        js["rules"].push_back(rule.text);
+    }
+    js["files"] = ojson::value_t::array;
+    size_t edits = 0;
+    for (const auto& file : m_files)
+    {
+        edits += file.edits;
+        if (!file.edits && file.ok && !file.rejected)
+        {
+            continue;
+        }
+        ojson entry;
+        entry["file"] = file.file.string();
+        entry["ok"] = file.ok;
+        entry["written"] = file.written;
+        entry["edits"] = file.edits;
+        entry["rejected"] = file.rejected;
+        entry["preview"] = ojson::value_t::array;
+        for (const auto& change : file.preview)
+        {
+            entry["preview"].push_back({ { "path", change.path }, { "old", change.old_value }, { "new", change.new_value } });
+        }
+        js["files"].push_back(std::move(entry));
+    }
+    js["scanned"] = m_files.size();
+    js["edits"] = edits;
+    return js;
+}
+
+bool Transform::save_json(const fs::path& json_path) const
+{
+    return save_report(json_path, to_json(), "Transform report");
+}
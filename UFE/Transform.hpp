@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "MerkleTree.hpp"
+
+// Scripted edits of every file of a tree. A rule is
+//
+//   <class>:<member path> [if <compare> <value>] <update> <value>
+//
+// where class and member names may be globs ('*', '?'), '[n]' or '[*]' select
+// array elements and references are followed along the path. compare is one of
+// == != < <= > >=, update one of = += -= *= /= ('+=' appends to strings) and
+// values are json literals:
+//
+//   'Weapon*:Damage *= 1.1'   '*:Weight if > 10 = 10'   'Item:Name += " (mod)"'
+//
+// Rules match class records at any depth and run in order, a later rule sees the
+// values set by earlier ones. Integer members are rounded after '*=' and '/=',
+// results that don't fit a member are dropped. The edits of a file are spliced
+// into its stream with Patch in one pass and files without edits aren't written.
+class Transform
+{
+public:
+    struct Change
+    {
+        std::string path;
+        nlohmann::ordered_json old_value;
+        nlohmann::ordered_json new_value;
+    };
+    struct FileTransform
+    {
+        std::filesystem::path file;
+        bool ok = false;
+        bool written = false;
+        size_t edits = 0;
+        size_t rejected = 0;         // results that don't fit their member
+        std::vector<Change> preview; // first edits
+    };
+
+    // false if rule doesn't parse, the reason is logged
+    bool add(std::string_view rule);
+    // dry_run reports edits without writing, preview edits of each file are kept
+    bool run(const std::filesystem::path& root, size_t threads, bool dry_run, size_t preview);
+    const std::vector<FileTransform>& files() const noexcept { return m_files; }
+
+    // changed files, up to preview edits and totals, logged at info level
+    void print(size_t preview) const;
+    nlohmann::ordered_json to_json() const;
+    bool save_json(const std::filesystem::path& json_path) const;
+private:
+    struct Step
+    {
+        std::string name; // glob, empty for array elements
+        int64_t index = -1; // element index, -1 for any
+    };
+    struct Rule
+    {
+        std::string text;
+        std::string class_name;
+        std::vector<Step> steps;
+        std::string compare; // empty without a condition
+        nlohmann::ordered_json compare_value;
+        std::string update;
+        nlohmann::ordered_json value;
+    };
+
+    void transform(FileTransform& file, bool dry_run, size_t preview) const;
+    static void match(const MerkleTree& tree, uint32_t node, const std::vector<Step>& steps, size_t step, std::vector<uint32_t>& targets);
+
+    std::vector<Rule> m_rules;
+    std::vector<FileTransform> m_files;
+};
@@ -0,0 +1,215 @@
+#include "Triage.hpp"
+#include "BinaryFileParser.hpp"
+#include "Records.hpp"
+#include "Report.hpp"
+#include "Trace.hpp"
+#include <array>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr size_t inflate_chunk = 4096;
+
+    // inflates gzip data from in until out is full, compressed bytes already read are passed in first
+    bool inflate_prefix(std::ifstream& in, std::string_view first, std::string& out)
+    {
+        z_stream zs{};
+        if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+        {
+            return false;
+        }
+        std::string input{ first };
+        size_t produced = 0;
+        int ret = Z_OK;
+        while (produced < out.size())
+        {
+            if (input.empty())
+            {
+                input.resize(inflate_chunk);
+                in.read(input.data(), input.size());
+                input.resize(static_cast<size_t>(in.gcount()));
+                if (input.empty())
+                {
+                    break;
+                }
+            }
+            zs.next_in = reinterpret_cast<Bytef*>(input.data());
+            zs.avail_in = static_cast<uInt>(input.size());
+            zs.next_out = reinterpret_cast<Bytef*>(out.data() + produced);
+            zs.avail_out = static_cast<uInt>(out.size() - produced);
+            ret = inflate(&zs, Z_NO_FLUSH);
+            produced = out.size() - zs.avail_out;
+            input.erase(0, input.size() - zs.avail_in);
+            if (ret != Z_OK)
+            {
+                break;
+            }
+        }
+        inflateEnd(&zs);
+        out.resize(produced);
+        return ret == Z_OK || ret == Z_STREAM_END;
+    }
+
+    TriageEntry::EType type_from_str(std::string_view type)
+    {
+        for (auto t : { TriageEntry::EType::Compressed, TriageEntry::EType::Uncompressed })
+        {
+            if (ETriageType2str(t) == type)
+            {
+                return t;
+            }
+        }
+        return TriageEntry::EType::Unsupported;
+    }
+}
+
+std::string_view ETriageType2str(TriageEntry::EType type)
+{
+    switch (type)
+    {
+        case TriageEntry::EType::Compressed: return "compressed";
+        case TriageEntry::EType::Uncompressed: return "uncompressed";
+        case TriageEntry::EType::Unsupported:
+        default:
+            return "unsupported";
+    }
+}
+
+TriageEntry Triage::classify(const fs::path& file)
+{
+    TriageEntry entry;
+    entry.file = file;
+    std::error_code ec;
+    entry.file_size = fs::file_size(file, ec);
+    std::ifstream in{ file, std::ios::binary };
+    if (ec || !in)
+    {
+        return entry;
+    }
+    std::string head(GZIP_START_OFF + STREAM_HEADER_SIZE, '\0');
+    in.read(head.data(), head.size());
+    head.resize(static_cast<size_t>(in.gcount()));
+    if (!BinaryFileParser::is_supported(head))
+    {
+        return entry;
+    }
+
+    const std::string_view stream_start{ head.data() + GZIP_START_OFF, head.size() - GZIP_START_OFF };
+    if (static_cast<uint8_t>(head[GZIP_START_OFF]) == GZIP_MAGIC_1 &&
+        static_cast<uint8_t>(head[GZIP_START_OFF + 1]) == GZIP_MAGIC_2)
+    {
+        std::string stream(STREAM_HEADER_SIZE, '\0');
+        if (inflate_prefix(in, stream_start, stream) && BinaryFileParser::is_stream_header(stream))
+        {
+            entry.type = TriageEntry::EType::Compressed;
+            // gzip trailer ends with the inflated size modulo 2^32
+            uint32_t isize = 0;
+            in.clear();
+            in.seekg(-4, std::ios::end);
+            in.read(reinterpret_cast<char*>(&isize), sizeof(isize));
+            entry.stream_size = in ? BinaryFileParser::stream_size_hint(entry.file_size - GZIP_START_OFF, isize) : 0;
+        }
+    }
+    else if (BinaryFileParser::is_stream_header(stream_start))
+    {
+        entry.type = TriageEntry::EType::Uncompressed;
+        entry.stream_size = entry.file_size - GZIP_START_OFF;
+    }
+    return entry;
+}
+
+std::vector<TriageEntry> Triage::scan(const fs::path& path)
+{
+    TraceScope trace{ "triage" };
+    std::vector<TriageEntry> entries;
+    auto add = [&entries](const fs::path& p)
+        {
+            // exports and listings sit next to the data
+            if (p.extension() != ".json")
+            {
+                entries.emplace_back(classify(p));
+            }
+        };
+    if (fs::is_regular_file(path))
+    {
+        add(path);
+    }
+    else if (fs::is_directory(path))
+    {
+        for (const auto& p : fs::recursive_directory_iterator{ path })
+        {
+            if (p.is_regular_file())
+            {
+                add(p.path());
+            }
+        }
+    }
+    return entries;
+}
+
+void Triage::print(const std::vector<TriageEntry>& entries)
+{
+    std::array<size_t, 3> counts{};
+    uint64_t stream_total = 0;
+    spdlog::info("{:<14}{:>12}{:>12}  {}", "type", "file size", "stream", "file");
+    for (const auto& entry : entries)
+    {
+        ++counts[static_cast<size_t>(entry.type)];
+        stream_total += entry.stream_size;
+        spdlog::info("{:<14}{:>12}{:>12}  {}", ETriageType2str(entry.type), entry.file_size, entry.stream_size, entry.file.string());
+    }
+    spdlog::info("{} file(s): {} compressed, {} uncompressed, {} unsupported, {} stream bytes",
+        entries.size(), counts[0], counts[1], counts[2], stream_total);
+}
+
+bool Triage::save_json(const fs::path& json_path, const std::vector<TriageEntry>& entries)
+{
+    nlohmann::ordered_json js;
+    js["files"] = nlohmann::ordered_json::value_t::array;
+    for (const auto& entry : entries)
+    {
+        nlohmann::ordered_json file;
+        file["file"] = entry.file.string();
+        file["type"] = ETriageType2str(entry.type);
+        file["file_size"] = entry.file_size;
+        file["stream_size"] = entry.stream_size;
+        js["files"].push_back(std::move(file));
+    }
+    return save_report(json_path, js, "Triage listing");
+}
+
+bool Triage::load_json(const fs::path& json_path, std::vector<TriageEntry>& entries)
+{
+    std::ifstream in_json{ json_path };
+    auto js = nlohmann::ordered_json::parse(in_json, nullptr, false);
+    if (js.is_discarded() || !js.contains("files") || !js["files"].is_array())
+    {
+        spdlog::error("Invalid triage listing '{}'", json_path.string());
+        return false;
+    }
+    std::vector<TriageEntry> loaded;
+    try
+    {
+        for (const auto& file : js["files"])
+        {
+            TriageEntry entry;
+            entry.file = file.value("file", std::string{});
+            entry.type = type_from_str(file.value("type", std::string{}));
+            entry.file_size = file.value("file_size", uint64_t{ 0 });
+            entry.stream_size = file.value("stream_size", uint64_t{ 0 });
+            loaded.emplace_back(std::move(entry));
+        }
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        // entry that is not an object or a field of the wrong type
+        spdlog::error("Invalid triage listing '{}': {}", json_path.string(), e.what());
+        return false;
+    }
+    entries.insert(entries.end(), std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+    return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+struct TriageEntry
+{
+    enum class EType
+    {
+        Compressed,
+        Uncompressed,
+        Unsupported
+    };
+    std::filesystem::path file;
+    EType type = EType::Unsupported;
+    uint64_t file_size = 0;
+    uint64_t stream_size = 0; // decoded NRBF stream, gzip trailer size hint for compressed files
+};
+
+std::string_view ETriageType2str(TriageEntry::EType type);
+
+// Classifies files from their first bytes only. Uncompressed files are checked
+// on the stream header after the 24 bytes file header, compressed ones inflate
+// just enough of the first deflate block to check it, nothing is read whole.
+// Listings saved as json are plans for later runs over the same files.
+class Triage
+{
+public:
+    static TriageEntry classify(const std::filesystem::path& file);
+    // every file under path except json files, path may be a single file
+    static std::vector<TriageEntry> scan(const std::filesystem::path& path);
+
+    // one line per file and totals, logged at info level
+    static void print(const std::vector<TriageEntry>& entries);
+    static bool save_json(const std::filesystem::path& json_path, const std::vector<TriageEntry>& entries);
+    static bool load_json(const std::filesystem::path& json_path, std::vector<TriageEntry>& entries);
+};
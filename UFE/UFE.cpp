@@ -3,6 +3,9 @@
 #include <fstream>
 #include <string>
 #include <filesystem>
+#include <algorithm>
+#include <memory>
+#include <sstream>
 //#include <cereal/cereal.hpp>
 //#include <cereal/archives/binary.hpp>
 //#include <cereal/types/array.hpp>
@@ -15,7 +18,25 @@
 #include "BinaryFileParser.hpp"
 #include "JsonWriter.hpp"
 #include "JsonReader.hpp"
+#include "BinaryFileWriter.hpp"
 #include "CLIParser.hpp"
+#include "Projection.hpp"
+#include "Rebase.hpp"
+#include "StringTable.hpp"
+#include "Transform.hpp"
+#include "Triage.hpp"
+#include "AsyncFileReader.hpp"
+#include "ContentIndex.hpp"
+#include "Diff.hpp"
+#include "Layers.hpp"
+#include "FileProcessor.hpp"
+#include "MemoryBudget.hpp"
+#include "Pipeline.hpp"
+#include "Server.hpp"
+#include "Stats.hpp"
+#include "TableExport.hpp"
+#include "Trace.hpp"
+#include "Watcher.hpp"
 #include <windows.h>
 #define WIN32_LEAN_AND_MEAN
 
@@ -29,103 +50,416 @@ bool skip_path(const std::filesystem::path& p)
     return false;
 }
 
-void parse_file(const fs::path& p, const CLIParser& cli)
+ProcessOptions process_options(const CLIParser& cli)
 {
+    return { cli.export_mode(), cli.patch(), cli.validate(), cli.make_patch() };
+}
+
+// streaming reads and inflates the file in chunks while parsing instead of loading it whole,
+// reserving at most stream_limit bytes for the decoded stream
+void parse_file(const fs::path& p, const ProcessOptions& options, const Projection* projection, StatsCollector* stats,
+    bool streaming = false, uint64_t stream_limit = 0)
+{
+    if (skip_path(p))
+    {
+        return;
+    }
+    TraceScope trace{ "parse_file", p };
     BinaryFileParser parser;
-    auto file_status = [](BinaryFileParser::EFileStatus status) -> std::string_view
+    FileStats file_stats;
+    FileStats* pstats = stats ? &file_stats : nullptr;
+    const auto memory_begin = MemoryTracker::file_begin();
+    parser.set_stats(pstats);
+    parser.set_projection(projection);
+    parser.set_stream_limit(stream_limit);
+    if (streaming ? parser.open_stream(p) : parser.open(p))
     {
-        switch (status)
+        process_records(p, parser, options, pstats, nullptr);
+        if (stats)
         {
-            case BinaryFileParser::EFileStatus::Empty:
-                return "empty";
-            case BinaryFileParser::EFileStatus::PartialRead:
-                return "partial read";
-            case BinaryFileParser::EFileStatus::FullRead:
-                return "validated";
-            case BinaryFileParser::EFileStatus::Invalid:
-            default:
-                return "invalid";
+            if (MemoryTracker::enabled())
+            {
+                file_stats.memory = MemoryTracker::file_end(memory_begin);
+            }
+            stats->add(std::move(file_stats));
         }
-    };
+    }
+}
+
+// one file passing through the directory pipeline
+struct FileJob
+{
+    // released last, after everything the file held is freed
+    MemoryBudget::Lease lease;
+    fs::path file;
+    bool streaming = false;
+    // submitted by the read stage, taken by the inflate stage
+    std::future<AsyncFileReader::Result> read;
+    BinaryFileParser parser;
+    FileStats stats;
+    FileStats* pstats = nullptr;
+    // export of the parse stage, written out by the emit stage
+    std::ostringstream json;
+    bool exported = false;
+    ProcessResult result;
+};
 
-    if (!skip_path(p) && parser.open(p))
+// only submits the read, it completes while earlier files are inflated and parsed
+bool read_stage(FileJob& job, AsyncFileReader& reader)
+{
+    if (job.streaming)
     {
-        parser.read_records();
+        // read in chunks by the parse stage
+        return true;
+    }
+    TraceScope trace{ "read_stage", job.file };
+    spdlog::info("Reading file: {} ", job.file.string());
+    job.read = reader.read(job.file);
+    return true;
+}
+
+bool inflate_stage(FileJob& job, ContentIndex& contents)
+{
+    TraceScope trace{ "inflate_stage", job.file };
+    if (job.streaming)
+    {
+        return job.parser.open_stream(job.file);
+    }
+    auto result = job.read.get();
+    job.stats.add_time(EStage::Read, result.read_time);
+    // copies of content read before are not processed again
+    return result.ok && contents.claim(job.file, result.data) && job.parser.load(job.file, std::move(result.data));
+}
+
+bool parse_stage(FileJob& job, const CLIParser& cli)
+{
+    TraceScope trace{ "parse_stage", job.file };
+    // patching reads the exported json back, it has to be on disk before,
+    // streamed files don't keep their export in memory either
+    const bool buffered = !cli.patch() && !job.streaming;
+    job.result = process_records(job.file, job.parser, process_options(cli), job.pstats, buffered ? &job.json : nullptr);
+    job.exported = job.result.exported && buffered;
+    return true;
+}
 
-        if (parser.status() != BinaryFileParser::EFileStatus::Invalid &&
-            parser.status() != BinaryFileParser::EFileStatus::Empty)
+bool emit_stage(FileJob& job, ContentIndex& contents, StatsCollector* stats)
+{
+    TraceScope trace{ "emit_stage", job.file };
+    fs::path json_path = job.file;
+    json_path += ".json";
+    // streamed files wrote their export while parsing
+    bool written = job.result.exported && !job.exported;
+    if (job.exported)
+    {
+        StageTimer timer{ job.pstats, EStage::JsonWrite };
+        // a json hard linked by --dedup link is replaced, not written through to the other names
+        std::error_code ec;
+        fs::remove(json_path, ec);
+        std::ofstream out{ json_path };
+        if (out)
         {
-            //reader.export_json(json_path);
-            if (parser.status() == BinaryFileParser::EFileStatus::PartialRead)
-            {
-                spdlog::warn("Partial file read!");
-                //continue;
-            }
-            fs::path json_path = p;
-            json_path += ".json";
-            if (cli.export_mode())
-            {
-                JsonWriter writer;
-                writer.save(json_path, parser.get_records());
-            }
+            spdlog::info("Exporting data to '{}'", json_path.string());
+            const auto text = job.json.view();
+            written = static_cast<bool>(out.write(text.data(), text.size()));
+        }
+        else
+        {
+            spdlog::error("Could not save '{}'", json_path.string());
+        }
+    }
+    // copies of the file get this result
+    ContentIndex::Outcome outcome;
+    outcome.validated = job.result.round_trip;
+    outcome.status = job.parser.status() == BinaryFileParser::EFileStatus::FullRead ? "re-serialized with differences" :
+        EFileStatus2str(job.parser.status());
+    if (written)
+    {
+        outcome.json = json_path;
+    }
+    contents.finish(job.file, std::move(outcome));
+    if (stats)
+    {
+        stats->add(std::move(job.stats));
+    }
+    return true;
+}
 
-            if (cli.patch())
-            {
-                JsonReader reader;
-                reader.patch(json_path, p, parser);
-            }
+void parse_directory(const CLIParser& cli, const Projection* projection, StatsCollector* stats)
+{
+    // files are classified from their headers first, rejected ones are never read whole
+    std::vector<TriageEntry> plan;
+    if (!cli.plan().empty())
+    {
+        if (!Triage::load_json(cli.plan(), plan))
+        {
+            return;
         }
+    }
+    else
+    {
+        plan = Triage::scan(cli.base_path());
+    }
+    std::vector<TriageEntry> files;
+    for (auto& entry : plan)
+    {
+        if (entry.type != TriageEntry::EType::Unsupported)
+        {
+            files.push_back(std::move(entry));
+        }
+        else
+        {
+            spdlog::debug("Skipping unsupported file '{}'", entry.file.string());
+        }
+    }
+    const bool keep_records = cli.patch() || cli.validate() || cli.make_patch();
+    MemoryBudget budget{ cli.mem_limit() };
+    // heap tracking is per thread, a file must be processed start to end on one thread
+    if (cli.io_threads() == 0 || MemoryTracker::enabled())
+    {
+        for (const auto& file : files)
+        {
+            const bool streaming = budget.limit() && MemoryBudget::estimate(file, keep_records, false) > budget.limit();
+            parse_file(file.file, process_options(cli), projection, stats, streaming, budget.limit());
+        }
+        return;
+    }
 
-        if (cli.validate())
+    // files that would take more than their share of the budget while all parse workers are busy are streamed
+    const uint64_t share = budget.limit() / cli.parse_threads();
+    AsyncFileReader reader{ cli.io_depth(), cli.io_threads() };
+    Pipeline<std::unique_ptr<FileJob>> pipeline{ cli.queue_depth() };
+    // patching uses a json of each copy, they all have to be processed
+    ContentIndex contents{ cli.patch() || cli.make_patch() ? ContentIndex::EMode::Off : ContentIndex::mode_from_str(cli.dedup()) };
+    // submitting never waits on the disk, one worker keeps io_depth reads going
+    pipeline.add_stage("read", 1, [&reader](auto& job) { return read_stage(*job, reader); });
+    pipeline.add_stage("inflate", cli.inflate_threads(), [&contents](auto& job) { return inflate_stage(*job, contents); });
+    pipeline.add_stage("parse", cli.parse_threads(), [&cli](auto& job) { return parse_stage(*job, cli); });
+    pipeline.add_stage("emit", cli.emit_threads(), [&contents, stats](auto& job) { return emit_stage(*job, contents, stats); });
+    pipeline.set_job_name([](const auto& job) { return job ? job->file.string() : std::string{}; });
+    const auto report = pipeline.run(files.size(), [&](size_t index)
         {
-            if (parser.status() != BinaryFileParser::EFileStatus::Invalid &&
-                parser.status() != BinaryFileParser::EFileStatus::Empty)
+            const auto& entry = files[index];
+            auto job = std::make_unique<FileJob>();
+            auto working_set = MemoryBudget::estimate(entry, keep_records, !cli.patch());
+            if (share && working_set > share)
             {
-                if (parser.file_type() == BinaryFileParser::EFileType::Compressed)
-                {
-                    spdlog::info("File '{}' is compressed, validation status '{}'", p.string(), file_status(parser.status()));
-                }
-                else if (parser.file_type() == BinaryFileParser::EFileType::Uncompressed)
-                {
-                    spdlog::info("File '{}' is uncompressed, validation status '{}'", p.string(), file_status(parser.status()));
-                }
-                else
-                {
-                    spdlog::info("File '{}' is raw, validation status '{}'", p.string(), file_status(parser.status()));
-                }
-            }
-            else
-            {
-                spdlog::trace("File '{}' not supported");
+                spdlog::debug("Streaming file '{}', estimated {} bytes loaded whole", entry.file.string(), working_set);
+                job->streaming = true;
+                working_set = MemoryBudget::estimate_streaming(entry, keep_records);
+                budget.count_streamed();
             }
+            job->lease = budget.acquire(working_set);
+            job->file = entry.file;
+            job->pstats = stats ? &job->stats : nullptr;
+            job->parser.set_stats(job->pstats);
+            job->parser.set_projection(projection);
+            job->parser.set_stream_limit(budget.limit());
+            return job;
+        });
+    contents.apply(cli.export_mode(), cli.validate());
+    if (stats)
+    {
+        report.print();
+        auto pipeline_json = report.to_json();
+        if (contents.mode() != ContentIndex::EMode::Off)
+        {
+            contents.print();
+            pipeline_json["dedup"] = contents.to_json();
+        }
+        if (budget.limit())
+        {
+            budget.print();
+            pipeline_json["memory_budget"] = budget.to_json();
         }
+        stats->set_pipeline(std::move(pipeline_json));
+    }
+}
+
+void triage(const CLIParser& cli)
+{
+    const auto entries = Triage::scan(cli.base_path());
+    Triage::print(entries);
+    if (!cli.triage_json().empty())
+    {
+        Triage::save_json(cli.triage_json(), entries);
     }
 }
 
-void parse_directory(const CLIParser& cli)
+bool make_projection(const CLIParser& cli, Projection& projection)
 {
-    for (const auto& p : fs::recursive_directory_iterator{ cli.base_path() })
+    for (const auto& pattern : cli.select())
     {
-        parse_file(p, cli);
+        if (!projection.add(pattern))
+        {
+            return false;
+        }
     }
+    return true;
 }
 
 void parse(const CLIParser& cli)
 {
-    if (fs::is_regular_file(cli.base_path()))
+    StatsCollector stats;
+    StatsCollector* pstats = cli.stats() ? &stats : nullptr;
+    Projection projection;
+    if (!make_projection(cli, projection))
     {
-        parse_file(cli.base_path(), cli);
+        return;
     }
-    else if (fs::is_directory(cli.base_path()))
+    if (cli.plan().empty() && fs::is_regular_file(cli.base_path()))
     {
-        parse_directory(cli);
+        const bool streaming = cli.mem_limit() &&
+            MemoryBudget::estimate(Triage::classify(cli.base_path()), cli.patch() || cli.validate() || cli.make_patch(), false) > cli.mem_limit();
+        parse_file(cli.base_path(), process_options(cli), &projection, pstats, streaming, cli.mem_limit());
+    }
+    else if (!cli.plan().empty() || fs::is_directory(cli.base_path()))
+    {
+        parse_directory(cli, &projection, pstats);
     }
     else
     {
         spdlog::error("Path '{}' cannot be parsed", cli.base_path().string());
     }
+
+    if (pstats)
+    {
+        stats.print_table();
+        if (!cli.stats_json().empty())
+        {
+            stats.save_json(cli.stats_json());
+        }
+    }
 }
 
+// every binary touched by the layers is parsed and written once with their merged edits
+void patch_layers(const CLIParser& cli)
+{
+    Layers layers;
+    if (layers.run(cli.base_path(), cli.layers(), cli.parse_threads()))
+    {
+        layers.print();
+        if (!cli.layer_json().empty())
+        {
+            layers.save_json(cli.layer_json());
+        }
+    }
+}
+
+// one table per class across all files, files are parsed in parallel into their
+// own sets which are merged in path order so rows don't depend on scheduling or on
+// the directory listing order of the file system
+void export_tables(const CLIParser& cli)
+{
+    Projection projection;
+    if (!make_projection(cli, projection))
+    {
+        return;
+    }
+    std::vector<TriageEntry> plan;
+    if (!cli.plan().empty())
+    {
+        if (!Triage::load_json(cli.plan(), plan))
+        {
+            return;
+        }
+    }
+    else
+    {
+        plan = Triage::scan(cli.base_path());
+    }
+    std::erase_if(plan, [](const TriageEntry& entry) { return entry.type == TriageEntry::EType::Unsupported; });
+    std::sort(plan.begin(), plan.end(), [](const TriageEntry& a, const TriageEntry& b) { return a.file < b.file; });
+
+    std::vector<TableSet> sets(plan.size());
+    parallel_for(plan.size(), cli.parse_threads(), [&](size_t i)
+        {
+            BinaryFileParser parser;
+            if (!parser.open(plan[i].file))
+            {
+                spdlog::warn("File '{}' can't be read, skipped", plan[i].file.string());
+                return;
+            }
+            parser.set_projection(&projection);
+            sets[i].begin_file(plan[i].file);
+            parser.read_records([&](const std::any& record) { sets[i].add(record); });
+            sets[i].end_file();
+            if (parser.status() == BinaryFileParser::EFileStatus::Invalid)
+            {
+                spdlog::warn("File '{}' parsed partially, tables have its rows read so far", plan[i].file.string());
+            }
+        });
+
+    TableSet tables;
+    for (auto& set : sets)
+    {
+        tables.append(std::move(set));
+    }
+    tables.print();
+    tables.save(cli.table_dir());
+}
+
+// keeps exports and binaries under base_path in sync after the initial run, only
+// files reported by the watcher are processed again
+void watch(const CLIParser& cli)
+{
+    Projection projection;
+    if (!make_projection(cli, projection))
+    {
+        return;
+    }
+    Watcher watcher{ cli.base_path(), cli.debounce() };
+    if (!watcher.start())
+    {
+        return;
+    }
+    spdlog::info("Watching '{}' for changes", cli.base_path().string());
+    const ProcessOptions export_options{ true, false, cli.validate() };
+    const ProcessOptions patch_options{ false, true, false };
+    for (auto changed = watcher.next(); !changed.empty(); changed = watcher.next())
+    {
+        // binaries first, a json just replaced by a new export isn't patched back
+        std::vector<fs::path> exported;
+        for (const auto& file : changed)
+        {
+            if (!cli.export_mode() || file.extension() == ".json")
+            {
+                continue;
+            }
+            if (Triage::classify(file).type == TriageEntry::EType::Unsupported)
+            {
+                spdlog::debug("Skipping unsupported file '{}'", file.string());
+                continue;
+            }
+            spdlog::info("File '{}' changed, exporting", file.string());
+            parse_file(file, export_options, &projection, nullptr);
+            auto json_path = file;
+            json_path += ".json";
+            watcher.written(json_path);
+            exported.push_back(std::move(json_path));
+        }
+        for (const auto& file : changed)
+        {
+            if (!cli.patch() || file.extension() != ".json")
+            {
+                continue;
+            }
+            auto binary = file;
+            binary.replace_extension();
+            if (!fs::is_regular_file(binary))
+            {
+                continue;
+            }
+            if (std::find(exported.cbegin(), exported.cend(), file) != exported.cend())
+            {
+                spdlog::warn("File '{}' and its json changed together, json was replaced by the export", binary.string());
+                continue;
+            }
+            spdlog::info("File '{}' changed, patching '{}'", file.string(), binary.string());
+            parse_file(binary, patch_options, nullptr, nullptr);
+            watcher.written(binary);
+        }
+    }
+}
 
 void validate_directory(fs::path dir)
 {
@@ -204,9 +538,100 @@ int main(int arg, char** argv)
     }
     spdlog::set_pattern("[%H:%M:%S][%^%l%$] %v");
 	spdlog::set_level(cli.logging_level());
-    if (cli.export_mode() || cli.validate() || cli.patch())
+    // serve measures its cache entries, every allocation is counted then
+    MemoryTracker::enable(cli.memory_stats() || cli.serve());
+    Tracer::enable(!cli.trace_file().empty());
+    if (cli.serve())
+    {
+        Server server{ cli.socket_path(), cli.cache_limit() };
+        return server.run() ? 0 : 1;
+    }
+    if (cli.diff())
+    {
+        Diff diff;
+        if (!diff.run(cli.diff_old(), cli.diff_new(), cli.parse_threads()))
+        {
+            return 1;
+        }
+        diff.print();
+        if (!cli.diff_json().empty())
+        {
+            diff.save_json(cli.diff_json());
+        }
+        return 0;
+    }
+    if (cli.rebase())
+    {
+        Rebase rebase;
+        if (!rebase.run(cli.rebase_old(), cli.rebase_mod(), cli.rebase_new(), cli.rebase_out(), cli.parse_threads()))
+        {
+            return 1;
+        }
+        rebase.print();
+        if (!cli.rebase_json().empty())
+        {
+            rebase.save_json(cli.rebase_json());
+        }
+        return 0;
+    }
+    if (cli.transform())
+    {
+        Transform transform;
+        for (const auto& rule : cli.transform_rules())
+        {
+            if (!transform.add(rule))
+            {
+                return 1;
+            }
+        }
+        if (!transform.run(cli.transform_path(), cli.parse_threads(), cli.transform_dry_run(), cli.transform_preview()))
+        {
+            return 1;
+        }
+        transform.print(cli.transform_preview());
+        if (!cli.transform_json().empty())
+        {
+            transform.save_json(cli.transform_json());
+        }
+        return 0;
+    }
+    if (cli.strings())
+    {
+        StringTable table;
+        if (!cli.strings_import().empty())
+        {
+            if (!table.import(cli.strings_path(), cli.strings_import(), cli.parse_threads()))
+            {
+                return 1;
+            }
+            table.print_import();
+            return 0;
+        }
+        return table.extract(cli.strings_path(), cli.parse_threads()) && table.save(cli.strings_export()) ? 0 : 1;
+    }
+    if (cli.triage())
+    {
+        triage(cli);
+    }
+    if (!cli.layers().empty())
+    {
+        patch_layers(cli);
+    }
+    else if (cli.export_mode() || cli.validate() || cli.patch() || cli.make_patch())
     {
         parse(cli);
+    }
+    if (!cli.table_dir().empty())
+    {
+        export_tables(cli);
+    }
+    if (cli.watch())
+    {
+        watch(cli);
+    }
+    if (Tracer::enabled())
+    {
+        Tracer::save(cli.trace_file());
     }
 	return 0;
 }
\ No newline at end of file
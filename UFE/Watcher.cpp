@@ -0,0 +1,283 @@
+#include "Watcher.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+#ifdef _WIN32
+struct Watcher::Impl
+{
+    HANDLE dir = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped{};
+    // FILE_NOTIFY_INFORMATION entries are DWORD aligned
+    std::vector<DWORD> buffer = std::vector<DWORD>(16 * 1024);
+
+    ~Impl()
+    {
+        if (dir != INVALID_HANDLE_VALUE)
+        {
+            ::CancelIo(dir);
+            ::CloseHandle(dir);
+        }
+        if (overlapped.hEvent)
+        {
+            ::CloseHandle(overlapped.hEvent);
+        }
+    }
+
+    bool read()
+    {
+        return ::ReadDirectoryChangesW(dir, buffer.data(), static_cast<DWORD>(buffer.size() * sizeof(DWORD)), TRUE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, nullptr, &overlapped, nullptr);
+    }
+};
+#else
+struct Watcher::Impl
+{
+    int fd = -1;
+    // inotify isn't recursive, every directory has its own watch
+    std::unordered_map<int, fs::path> dirs;
+
+    ~Impl()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+
+    void add(const fs::path& dir)
+    {
+        const int wd = ::inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd >= 0)
+        {
+            dirs[wd] = dir;
+        }
+        else
+        {
+            spdlog::warn("Directory '{}' can't be watched", dir.string());
+        }
+    }
+
+    void add_tree(const fs::path& root)
+    {
+        add(root);
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it{ root, ec }, end; !ec && it != end; it.increment(ec))
+        {
+            if (it->is_directory(ec))
+            {
+                add(it->path());
+            }
+        }
+    }
+};
+#endif
+
+Watcher::Watcher(fs::path root, std::chrono::milliseconds debounce) : m_root{ std::move(root) }, m_debounce{ debounce }
+{
+}
+
+Watcher::~Watcher() = default;
+
+bool Watcher::start()
+{
+    m_impl = std::make_unique<Impl>();
+#ifdef _WIN32
+    m_impl->dir = ::CreateFileW(m_root.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    m_impl->overlapped.hEvent = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (m_impl->dir == INVALID_HANDLE_VALUE || !m_impl->overlapped.hEvent || !m_impl->read())
+    {
+        spdlog::error("Directory '{}' can't be watched", m_root.string());
+        return false;
+    }
+#else
+    m_impl->fd = ::inotify_init1(IN_CLOEXEC);
+    if (m_impl->fd < 0)
+    {
+        spdlog::error("Directory '{}' can't be watched", m_root.string());
+        return false;
+    }
+    m_impl->add_tree(m_root);
+#endif
+    return true;
+}
+
+bool Watcher::wait_events(int timeout_ms, std::vector<fs::path>& changed)
+{
+#ifdef _WIN32
+    const auto wait = ::WaitForSingleObject(m_impl->overlapped.hEvent, timeout_ms < 0 ? INFINITE : static_cast<DWORD>(timeout_ms));
+    if (wait == WAIT_TIMEOUT)
+    {
+        return true;
+    }
+    DWORD bytes = 0;
+    if (wait != WAIT_OBJECT_0 || !::GetOverlappedResult(m_impl->dir, &m_impl->overlapped, &bytes, FALSE))
+    {
+        spdlog::error("Watching '{}' failed", m_root.string());
+        return false;
+    }
+    if (bytes == 0)
+    {
+        spdlog::warn("Too many changes at once under '{}', some were missed", m_root.string());
+    }
+    const auto* data = reinterpret_cast<const char*>(m_impl->buffer.data());
+    for (size_t offset = 0; bytes;)
+    {
+        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data + offset);
+        if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+        {
+            changed.push_back(m_root / std::wstring{ info->FileName, info->FileNameLength / sizeof(WCHAR) });
+        }
+        if (!info->NextEntryOffset)
+        {
+            break;
+        }
+        offset += info->NextEntryOffset;
+    }
+    ::ResetEvent(m_impl->overlapped.hEvent);
+    if (!m_impl->read())
+    {
+        spdlog::error("Watching '{}' failed", m_root.string());
+        return false;
+    }
+    return true;
+#else
+    pollfd pfd{ m_impl->fd, POLLIN, 0 };
+    const int ready = ::poll(&pfd, 1, timeout_ms);
+    if (ready <= 0)
+    {
+        return ready == 0 || errno == EINTR;
+    }
+    alignas(inotify_event) char buffer[64 * 1024];
+    const auto bytes = ::read(m_impl->fd, buffer, sizeof(buffer));
+    if (bytes <= 0)
+    {
+        spdlog::error("Watching '{}' failed", m_root.string());
+        return false;
+    }
+    for (const char* p = buffer; p < buffer + bytes;)
+    {
+        const auto* event = reinterpret_cast<const inotify_event*>(p);
+        p += sizeof(inotify_event) + event->len;
+        if (event->mask & IN_Q_OVERFLOW)
+        {
+            spdlog::warn("Too many changes at once under '{}', some were missed", m_root.string());
+            continue;
+        }
+        if (event->mask & IN_IGNORED)
+        {
+            // directory removed
+            m_impl->dirs.erase(event->wd);
+            continue;
+        }
+        const auto dir = m_impl->dirs.find(event->wd);
+        if (dir == m_impl->dirs.end() || !event->len)
+        {
+            continue;
+        }
+        auto path = dir->second / event->name;
+        if (event->mask & IN_ISDIR)
+        {
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+            {
+                m_impl->add_tree(path);
+            }
+        }
+        else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+        {
+            changed.push_back(std::move(path));
+        }
+    }
+    return true;
+#endif
+}
+
+std::vector<fs::path> Watcher::next()
+{
+    using clock = std::chrono::steady_clock;
+    std::vector<fs::path> settled;
+    while (settled.empty())
+    {
+        int timeout_ms = -1;
+        if (!m_pending.empty())
+        {
+            auto oldest = clock::time_point::max();
+            for (const auto& [file, last] : m_pending)
+            {
+                oldest = std::min(oldest, last);
+            }
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(oldest + m_debounce - clock::now());
+            timeout_ms = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+        }
+        std::vector<fs::path> changed;
+        if (!wait_events(timeout_ms, changed))
+        {
+            return {};
+        }
+        const auto now = clock::now();
+        for (const auto& file : changed)
+        {
+            m_pending[file.native()] = now;
+        }
+        for (auto it = m_pending.begin(); it != m_pending.end();)
+        {
+            if (now - it->second < m_debounce)
+            {
+                ++it;
+                continue;
+            }
+            fs::path file = it->first;
+            it = m_pending.erase(it);
+            std::error_code ec;
+            if (fs::is_regular_file(file, ec) && !self_written(file))
+            {
+                settled.push_back(std::move(file));
+            }
+        }
+    }
+    std::sort(settled.begin(), settled.end());
+    return settled;
+}
+
+void Watcher::written(const fs::path& file)
+{
+    std::error_code ec;
+    FileState state;
+    state.mtime = fs::last_write_time(file, ec);
+    state.size = ec ? 0 : fs::file_size(file, ec);
+    if (!ec)
+    {
+        m_written[file.native()] = state;
+    }
+}
+
+bool Watcher::self_written(const fs::path& file)
+{
+    const auto it = m_written.find(file.native());
+    if (it == m_written.end())
+    {
+        return false;
+    }
+    std::error_code ec;
+    const auto mtime = fs::last_write_time(file, ec);
+    const auto size = ec ? 0 : fs::file_size(file, ec);
+    if (!ec && mtime == it->second.mtime && size == it->second.size)
+    {
+        return true;
+    }
+    // changed by someone else since
+    m_written.erase(it);
+    return false;
+}
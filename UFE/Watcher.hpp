@@ -0,0 +1,40 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Reports files changed under a directory tree, ReadDirectoryChangesW on Windows
+// and inotify elsewhere. Events of a file are debounced, it is reported once it
+// stayed quiet for the debounce time, so a save in several writes is one change.
+class Watcher
+{
+public:
+    Watcher(std::filesystem::path root, std::chrono::milliseconds debounce);
+    ~Watcher();
+    // false when the tree can't be watched
+    bool start();
+    // blocks until files changed and settled, empty when watching failed
+    std::vector<std::filesystem::path> next();
+    // file was just written by ufe itself, its own change is not reported
+    void written(const std::filesystem::path& file);
+private:
+    struct FileState
+    {
+        std::filesystem::file_time_type mtime;
+        uintmax_t size = 0;
+    };
+    // platform notification handles
+    struct Impl;
+    // waits up to timeout_ms (-1 forever) and collects changed files
+    bool wait_events(int timeout_ms, std::vector<std::filesystem::path>& changed);
+    bool self_written(const std::filesystem::path& file);
+
+    std::filesystem::path m_root;
+    std::chrono::milliseconds m_debounce;
+    std::unique_ptr<Impl> m_impl;
+    std::unordered_map<std::filesystem::path::string_type, std::chrono::steady_clock::time_point> m_pending;
+    std::unordered_map<std::filesystem::path::string_type, FileState> m_written;
+};
@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include "CLI/App.hpp"
+#include "CLI/Formatter.hpp"
+#include "CLI/Config.hpp"
+#include "BinaryFileParser.hpp"
+#include "JsonWriter.hpp"
+#include "JsonReader.hpp"
+#include "BinaryFileWriter.hpp"
+#include "NrbfGenerator.hpp"
+
+namespace fs = std::filesystem;
+using bench_clock = std::chrono::steady_clock;
+
+struct BenchResult
+{
+    std::string name;
+    size_t iterations = 0;
+    std::chrono::nanoseconds time{};
+    uint64_t bytes = 0;   // decoded NRBF stream bytes processed
+    uint64_t records = 0;
+};
+
+// results go through their own logger, library code is silenced during benchmarks
+spdlog::logger& report()
+{
+    static auto logger = [] {
+        auto log = spdlog::default_logger()->clone("bench");
+        log->set_level(spdlog::level::info);
+        return log;
+    }();
+    return *logger;
+}
+
+void print_header()
+{
+    report().info("{:<20}{:>8}{:>14}{:>12}{:>14}", "benchmark", "iters", "ms/iter", "MB/s", "records/s");
+}
+
+void print_result(const BenchResult& r)
+{
+    const double sec = std::chrono::duration<double>(r.time).count();
+    const double ms_iter = sec * 1000.0 / std::max<size_t>(r.iterations, 1);
+    const double mb_s = sec > 0.0 ? r.bytes / (1024.0 * 1024.0) / sec : 0.0;
+    const double rec_s = sec > 0.0 ? r.records / sec : 0.0;
+    report().info("{:<20}{:>8}{:>14.3f}{:>12.2f}{:>14.0f}", r.name, r.iterations, ms_iter, mb_s, rec_s);
+}
+
+// body returns the timed part of one iteration, setup work stays outside of it
+BenchResult run(const std::string& name, size_t iterations, uint64_t bytes, uint64_t records,
+    const std::function<std::chrono::nanoseconds()>& body)
+{
+    BenchResult result{ name, iterations };
+    body(); // warm up
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        result.time += body();
+        result.bytes += bytes;
+        result.records += records;
+    }
+    print_result(result);
+    return result;
+}
+
+void write_file(const fs::path& path, const std::string& data)
+{
+    std::ofstream out{ path, std::ios::binary };
+    out.write(data.data(), data.size());
+}
+
+// appends a suffix to every BinaryObjectString value, forcing the string update path
+void modify_strings(nlohmann::ordered_json& js)
+{
+    if (js.is_object())
+    {
+        if (js.contains("obj_string_id") && js.contains("value"))
+        {
+            js["value"] = js["value"].get<std::string>() + " (modified)";
+            return;
+        }
+        for (auto& [key, value] : js.items())
+        {
+            modify_strings(value);
+        }
+    }
+    else if (js.is_array())
+    {
+        for (auto& value : js)
+        {
+            modify_strings(value);
+        }
+    }
+}
+
+int generate_corpus(const fs::path& dir, uint32_t files, GeneratorOptions options)
+{
+    fs::create_directories(dir);
+    for (uint32_t i = 0; i < files; ++i)
+    {
+        options.seed += 1;
+        NrbfGenerator generator{ options };
+        auto path = dir / ("gen_" + std::to_string(i) + ".item");
+        if (!generator.save(path))
+        {
+            return 1;
+        }
+    }
+    spdlog::info("Generated {} file(s) in '{}'", files, dir.string());
+    return 0;
+}
+
+// generated files with dense null runs must parse fully and re-serialize unchanged,
+// ObjectNullMultiple256 in arrays covers NullCount elements including its own slot
+int check_round_trip(GeneratorOptions options, uint32_t files)
+{
+    options.null_percent = std::max<uint32_t>(options.null_percent, 50);
+    // array members alternate string and class arrays, two give both
+    options.array_members = std::max<uint32_t>(options.array_members, 2);
+    uint32_t failed = 0;
+    for (uint32_t i = 0; i < files; ++i)
+    {
+        options.seed += 1;
+        options.compressed = i % 2 == 0;
+        NrbfGenerator generator{ options };
+        BinaryFileParser parser;
+        parser.load("check.item", generator.generate_file());
+        parser.read_records();
+        std::string stream;
+        const auto raw_data = parser.raw_data();
+        // header, library and the root objects, elements left over by an array that ended early become extra roots
+        if (parser.status() != BinaryFileParser::EFileStatus::FullRead || parser.get_records().size() != options.objects + 2 ||
+            !BinaryFileWriter{}.serialize(parser.get_records(), stream) || !std::equal(raw_data.cbegin(), raw_data.cend(), stream.cbegin(), stream.cend()))
+        {
+            report().error("Seed {} ({}) failed the round trip", options.seed, options.compressed ? "gzip" : "plain");
+            ++failed;
+        }
+    }
+    report().info("{} of {} generated file(s) parsed and re-serialized without differences", files - failed, files);
+    return failed ? 1 : 0;
+}
+
+void run_benchmarks(const GeneratorOptions& options, size_t iterations)
+{
+    const auto tmp_dir = fs::temp_directory_path() / "ufe_bench";
+    fs::create_directories(tmp_dir);
+    const auto bin_path = tmp_dir / "bench.item";
+    const auto json_path = tmp_dir / "bench.item.json";
+    const auto mod_json_path = tmp_dir / "bench_mod.item.json";
+
+    NrbfGenerator generator{ options };
+    const auto file_data = generator.generate_file();
+    write_file(bin_path, file_data);
+
+    BinaryFileParser reference;
+    reference.load(bin_path, std::string{ file_data });
+    reference.read_records();
+    if (reference.status() != BinaryFileParser::EFileStatus::FullRead)
+    {
+        spdlog::error("Generated stream was not fully parsed, benchmarks aborted");
+        return;
+    }
+    const uint64_t bytes = reference.raw_data().size();
+    const uint64_t records = reference.records_count();
+    report().info("Input: {} bytes on disk ({}), {} bytes stream, {} records",
+        file_data.size(), options.compressed ? "gzip" : "plain", bytes, records);
+
+    JsonWriter{}.save(json_path, reference.get_records());
+    {
+        std::ifstream in{ json_path };
+        auto js = nlohmann::ordered_json::parse(in);
+        modify_strings(js);
+        std::ofstream out{ mod_json_path };
+        out << std::setw(4) << js;
+    }
+
+    print_header();
+    run("read_records", iterations, bytes, records, [&]
+        {
+            BinaryFileParser parser;
+            parser.load(bin_path, std::string{ file_data });
+            const auto start = bench_clock::now();
+            parser.read_records();
+            return bench_clock::now() - start;
+        });
+
+    run("load+read_records", iterations, bytes, records, [&]
+        {
+            std::string data{ file_data };
+            const auto start = bench_clock::now();
+            BinaryFileParser parser;
+            parser.load(bin_path, std::move(data));
+            parser.read_records();
+            return bench_clock::now() - start;
+        });
+
+    run("JsonWriter::save", iterations, bytes, records, [&]
+        {
+            JsonWriter writer;
+            const auto start = bench_clock::now();
+            writer.save(json_path, reference.get_records());
+            return bench_clock::now() - start;
+        });
+
+    run("serialize", iterations, bytes, records, [&]
+        {
+            BinaryFileWriter writer;
+            std::string stream;
+            const auto start = bench_clock::now();
+            writer.serialize(reference.get_records(), stream);
+            return std::chrono::nanoseconds{ bench_clock::now() - start };
+        });
+
+    auto patch_with = [&](const fs::path& patch_json)
+    {
+        return [&, patch_json]
+        {
+            write_file(bin_path, file_data);
+            BinaryFileParser parser;
+            parser.load(bin_path, std::string{ file_data });
+            parser.read_records();
+            JsonReader reader;
+            const auto start = bench_clock::now();
+            reader.patch(patch_json, bin_path, parser);
+            return std::chrono::nanoseconds{ bench_clock::now() - start };
+        };
+    };
+    run("JsonReader::patch", iterations, bytes, records, patch_with(json_path));
+    run("string updates", iterations, bytes, records, patch_with(mod_json_path));
+
+    fs::remove_all(tmp_dir);
+}
+
+int main(int argc, char** argv)
+{
+    CLI::App app{ "UFE benchmarks on synthetic NRBF data" };
+    GeneratorOptions options;
+    size_t iterations = 20;
+    uint32_t files = 100;
+    bool plain = false;
+    int logging_level = spdlog::level::info;
+    fs::path corpus_dir;
+    bool check = false;
+    app.add_option("-i,--iterations", iterations, "timed iterations per benchmark");
+    app.add_option("--classes", options.classes, "distinct class layouts");
+    app.add_option("--objects", options.objects, "root objects per file");
+    app.add_option("--primitives", options.primitive_members, "primitive members per class");
+    app.add_option("--strings", options.string_members, "string members per class");
+    app.add_option("--nested", options.nested_members, "nested class members per class");
+    app.add_option("--arrays", options.array_members, "array members per class");
+    app.add_option("--string_size", options.string_size, "average string length");
+    app.add_option("--array_length", options.array_length, "elements per array");
+    app.add_option("--null_percent", options.null_percent, "chance of null/reference values")->check(CLI::Range(0, 100));
+    app.add_option("--seed", options.seed, "random seed");
+    app.add_flag("--plain", plain, "write uncompressed streams instead of gzip-wrapped ones");
+    app.add_option("--generate", corpus_dir, "write a synthetic corpus to directory and exit");
+    app.add_option("--files", files, "number of files written by --generate or checked by --check");
+    app.add_flag("--check", check, "parse and re-serialize generated files with dense null runs, exit code 1 on differences");
+    app.add_option("-l,--loglevel", logging_level, "set logging level, default info")->check(CLI::Range(0, 6));
+    try
+    {
+        app.parse(argc, argv);
+    }
+    catch (const CLI::ParseError& e)
+    {
+        return app.exit(e);
+    }
+    options.compressed = !plain;
+    spdlog::set_pattern("[%H:%M:%S][%^%l%$] %v");
+    spdlog::set_level(static_cast<spdlog::level::level_enum>(logging_level));
+
+    if (!corpus_dir.empty())
+    {
+        return generate_corpus(corpus_dir, files, options);
+    }
+
+    // parser and patcher log every file and changed value
+    report();
+    spdlog::set_level(spdlog::level::err);
+    if (check)
+    {
+        return check_round_trip(options, files);
+    }
+    run_benchmarks(options, iterations);
+    return 0;
+}
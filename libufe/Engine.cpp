@@ -0,0 +1,297 @@
+#include "Engine.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/base_sink.h>
+#include "BinaryFileParser.hpp"
+#include "FileProcessor.hpp"
+#include "Projection.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    enum class EOp
+    {
+        Parse,
+        Export,
+        Patch
+    };
+
+    // messages logged by the thread processing a file, null outside of files
+    thread_local std::vector<libufe::Message>* t_messages = nullptr;
+    thread_local int t_log_level = UFE_LOG_WARN;
+
+    // default logger sink of the library, log lines become file result messages
+    class CaptureSink : public spdlog::sinks::base_sink<spdlog::details::null_mutex>
+    {
+    protected:
+        void sink_it_(const spdlog::details::log_msg& msg) override
+        {
+            if (t_messages && static_cast<int>(msg.level) >= t_log_level)
+            {
+                t_messages->push_back({ static_cast<int>(msg.level), std::string{ msg.payload.data(), msg.payload.size() } });
+            }
+        }
+        void flush_() override {}
+    };
+
+    std::mutex g_capture_mutex;
+    std::shared_ptr<spdlog::logger> g_capture_logger;
+    // levels of the batches in flight
+    std::multiset<int> g_batch_levels;
+
+    // the logger runs at the lowest level a batch in flight asked for, so messages
+    // no batch keeps aren't formatted, the sink keeps each file's own level.
+    // Caller holds g_capture_mutex.
+    void update_capture_level()
+    {
+        const int level = g_batch_levels.empty() ? UFE_LOG_WARN : *g_batch_levels.begin();
+        g_capture_logger->set_level(static_cast<spdlog::level::level_enum>(level));
+    }
+
+    void install_capture()
+    {
+        std::lock_guard lock{ g_capture_mutex };
+        if (!g_capture_logger)
+        {
+            g_capture_logger = std::make_shared<spdlog::logger>("libufe", std::make_shared<CaptureSink>());
+            update_capture_level();
+            spdlog::set_default_logger(g_capture_logger);
+        }
+    }
+
+    // held by a batch until its last file is done
+    class CaptureLevel
+    {
+    public:
+        explicit CaptureLevel(int log_level)
+            : m_level{ std::clamp(log_level, static_cast<int>(UFE_LOG_TRACE), static_cast<int>(UFE_LOG_OFF)) }
+        {
+            std::lock_guard lock{ g_capture_mutex };
+            g_batch_levels.insert(m_level);
+            update_capture_level();
+        }
+        ~CaptureLevel()
+        {
+            std::lock_guard lock{ g_capture_mutex };
+            g_batch_levels.erase(g_batch_levels.find(m_level));
+            update_capture_level();
+        }
+        CaptureLevel(const CaptureLevel&) = delete;
+        CaptureLevel& operator=(const CaptureLevel&) = delete;
+    private:
+        int m_level;
+    };
+
+    libufe::EStatus status_from(BinaryFileParser::EFileStatus status)
+    {
+        switch (status)
+        {
+            case BinaryFileParser::EFileStatus::FullRead: return libufe::EStatus::Ok;
+            case BinaryFileParser::EFileStatus::PartialRead: return libufe::EStatus::PartialRead;
+            case BinaryFileParser::EFileStatus::Empty:
+            case BinaryFileParser::EFileStatus::Invalid:
+            default:
+                return libufe::EStatus::Invalid;
+        }
+    }
+
+    void process_file(libufe::FileResult& result, EOp op, const libufe::Options& options, const Projection* projection)
+    {
+        BinaryFileParser parser;
+        if (op != EOp::Patch && !options.validate)
+        {
+            parser.set_projection(projection);
+        }
+        if (!parser.open(result.file))
+        {
+            result.status = fs::is_regular_file(result.file) ? libufe::EStatus::Unsupported : libufe::EStatus::Failed;
+            return;
+        }
+        ProcessOptions process;
+        process.export_json = op != EOp::Patch;
+        process.patch = op == EOp::Patch;
+        process.validate = options.validate;
+        std::ostringstream json;
+        const auto processed = process_records(result.file, parser, process, nullptr, op == EOp::Parse ? &json : nullptr);
+        result.status = status_from(parser.status());
+        result.compressed = parser.file_type() == BinaryFileParser::EFileType::Compressed;
+        result.records = parser.records_count();
+        result.members = parser.members_count();
+        result.exported = processed.exported;
+        result.patched = processed.patched;
+        result.round_trip = processed.round_trip;
+        if (op == EOp::Parse)
+        {
+            result.json = std::move(json).str();
+        }
+        if (result.status == libufe::EStatus::Ok &&
+            ((op == EOp::Patch && !processed.patched) || (options.validate && !processed.round_trip)))
+        {
+            result.status = libufe::EStatus::Failed;
+        }
+    }
+}
+
+namespace libufe
+{
+    struct Engine::Impl
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::function<void(bool cancelled)>> tasks;
+        bool stopping = false;
+        std::vector<std::jthread> workers;
+
+        explicit Impl(size_t threads)
+        {
+            install_capture();
+            if (threads == 0)
+            {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            for (size_t i = 0; i < threads; ++i)
+            {
+                workers.emplace_back([this] { work(); });
+            }
+        }
+
+        ~Impl()
+        {
+            {
+                std::lock_guard lock{ mutex };
+                stopping = true;
+            }
+            cv.notify_all();
+            workers.clear();
+        }
+
+        // queued tasks still run after stopping so every batch gets its results
+        void work()
+        {
+            for (;;)
+            {
+                std::function<void(bool)> task;
+                bool cancelled = false;
+                {
+                    std::unique_lock lock{ mutex };
+                    cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                    if (tasks.empty())
+                    {
+                        return;
+                    }
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                    cancelled = stopping;
+                }
+                task(cancelled);
+            }
+        }
+
+        Batch submit(EOp op, std::vector<fs::path> files, Options options, std::stop_token stop)
+        {
+            struct State
+            {
+                std::vector<FileResult> results;
+                Options options;
+                Projection projection;
+                bool projection_ok = true;
+                std::vector<Message> projection_messages;
+                std::stop_token stop;
+                std::atomic<size_t> left{ 0 };
+                std::promise<std::vector<FileResult>> done;
+                // log level of the batch, held until its last file is done
+                std::optional<CaptureLevel> capture;
+            };
+            auto state = std::make_shared<State>();
+            state->capture.emplace(options.log_level);
+            state->options = std::move(options);
+            state->stop = std::move(stop);
+            state->results.resize(files.size());
+            state->left = files.size();
+            t_messages = &state->projection_messages;
+            t_log_level = state->options.log_level;
+            for (const auto& pattern : state->options.select)
+            {
+                state->projection_ok = state->projection.add(pattern) && state->projection_ok;
+            }
+            t_messages = nullptr;
+            auto batch = state->done.get_future();
+            if (files.empty())
+            {
+                state->capture.reset();
+                state->done.set_value({});
+                return batch;
+            }
+            std::lock_guard lock{ mutex };
+            for (size_t i = 0; i < files.size(); ++i)
+            {
+                state->results[i].file = std::move(files[i]);
+                tasks.emplace_back([state, op, i](bool cancelled)
+                    {
+                        auto& result = state->results[i];
+                        if (cancelled || state->stop.stop_requested())
+                        {
+                            result.status = EStatus::Cancelled;
+                        }
+                        else if (!state->projection_ok)
+                        {
+                            result.messages = state->projection_messages;
+                        }
+                        else
+                        {
+                            t_messages = &result.messages;
+                            t_log_level = state->options.log_level;
+                            try
+                            {
+                                process_file(result, op, state->options, &state->projection);
+                            }
+                            catch (const std::exception& e)
+                            {
+                                result.status = EStatus::Failed;
+                                result.messages.push_back({ UFE_LOG_CRITICAL, e.what() });
+                            }
+                            t_messages = nullptr;
+                        }
+                        if (state->left.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        {
+                            state->capture.reset();
+                            state->done.set_value(std::move(state->results));
+                        }
+                    });
+            }
+            cv.notify_all();
+            return batch;
+        }
+    };
+
+    Engine::Engine(size_t threads) : m_impl{ std::make_unique<Impl>(threads) }
+    {
+    }
+
+    Engine::~Engine() = default;
+
+    Engine::Batch Engine::parse_many(std::vector<fs::path> files, Options options, std::stop_token stop)
+    {
+        return m_impl->submit(EOp::Parse, std::move(files), std::move(options), std::move(stop));
+    }
+
+    Engine::Batch Engine::export_many(std::vector<fs::path> files, Options options, std::stop_token stop)
+    {
+        return m_impl->submit(EOp::Export, std::move(files), std::move(options), std::move(stop));
+    }
+
+    Engine::Batch Engine::patch_many(std::vector<fs::path> files, Options options, std::stop_token stop)
+    {
+        return m_impl->submit(EOp::Patch, std::move(files), std::move(options), std::move(stop));
+    }
+}
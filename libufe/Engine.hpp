@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <vector>
+#include "ufe.h"
+
+// C++ API of libufe. It passes standard library types across the library
+// boundary, so hosts must use the same compiler and runtime as the library,
+// ufe.h is the stable one.
+namespace libufe
+{
+    enum class EStatus
+    {
+        Ok = UFE_STATUS_OK,
+        Unsupported = UFE_STATUS_UNSUPPORTED,
+        Invalid = UFE_STATUS_INVALID,
+        PartialRead = UFE_STATUS_PARTIAL_READ,
+        Failed = UFE_STATUS_FAILED,
+        Cancelled = UFE_STATUS_CANCELLED
+    };
+
+    struct Options
+    {
+        bool validate = false;
+        // export projection, '<class>[:<member>.<member>...]', ignored by patching and validation
+        std::vector<std::string> select;
+        // log messages at this level and above are returned with results
+        int log_level = UFE_LOG_WARN;
+    };
+
+    struct Message
+    {
+        int level = UFE_LOG_INFO;
+        std::string text;
+    };
+
+    struct FileResult
+    {
+        std::filesystem::path file;
+        EStatus status = EStatus::Failed;
+        bool compressed = false;
+        uint64_t records = 0;
+        uint64_t members = 0;
+        bool exported = false;
+        bool patched = false;
+        bool round_trip = false;
+        std::string json; // parse_many only
+        std::vector<Message> messages;
+    };
+
+    // Keeps worker threads, registered visitors and the log capture warm between
+    // batches. Files of a batch run in parallel, results keep the input order.
+    // Log output of the core is not printed, it's returned with the file results.
+    // Members are exported one by one, exporting the class would export its
+    // std::unique_ptr member too (C4251).
+    class Engine
+    {
+    public:
+        // threads 0 uses one worker per hardware thread
+        LIBUFE_API explicit Engine(size_t threads = 0);
+        // files not started yet finish as cancelled, running ones are waited for
+        LIBUFE_API ~Engine();
+        Engine(const Engine&) = delete;
+        Engine& operator=(const Engine&) = delete;
+
+        using Batch = std::future<std::vector<FileResult>>;
+        // exported json is returned in FileResult::json, nothing is written
+        LIBUFE_API Batch parse_many(std::vector<std::filesystem::path> files, Options options = {}, std::stop_token stop = {});
+        // writes '<file>.json' next to every file
+        LIBUFE_API Batch export_many(std::vector<std::filesystem::path> files, Options options = {}, std::stop_token stop = {});
+        // patches every file with its '<file>.json'
+        LIBUFE_API Batch patch_many(std::vector<std::filesystem::path> files, Options options = {}, std::stop_token stop = {});
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+}
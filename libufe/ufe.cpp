@@ -0,0 +1,227 @@
+#include "ufe.h"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <vector>
+#include "Engine.hpp"
+
+namespace fs = std::filesystem;
+
+struct ufe_engine
+{
+    explicit ufe_engine(uint32_t threads) : engine{ threads } {}
+    libufe::Engine engine;
+};
+
+struct ufe_batch
+{
+    std::stop_source stop;
+    libufe::Engine::Batch future;
+    size_t size = 0;
+    bool collected = false;
+    std::vector<libufe::FileResult> results;
+    // storage behind the C views of results
+    std::vector<std::string> files;
+    std::vector<std::vector<ufe_message>> messages;
+    std::vector<ufe_file_result> c_results;
+
+    // false if the batch failed, results are then empty
+    bool collect() noexcept
+    {
+        if (collected)
+        {
+            return c_results.size() == size;
+        }
+        collected = true;
+        try
+        {
+            results = future.get();
+            files.reserve(results.size());
+            messages.reserve(results.size());
+            c_results.reserve(results.size());
+            for (const auto& r : results)
+            {
+                const auto file = r.file.u8string();
+                files.emplace_back(file.begin(), file.end());
+                auto& msgs = messages.emplace_back();
+                for (const auto& m : r.messages)
+                {
+                    msgs.push_back({ m.level, m.text.c_str() });
+                }
+                ufe_file_result c{};
+                c.file = files.back().c_str();
+                c.status = static_cast<ufe_status>(r.status);
+                c.compressed = r.compressed;
+                c.records = r.records;
+                c.members = r.members;
+                c.exported = r.exported;
+                c.patched = r.patched;
+                c.round_trip = r.round_trip;
+                c.json = r.json.empty() ? nullptr : r.json.c_str();
+                c.json_size = r.json.size();
+                c.messages = msgs.data();
+                c.message_count = msgs.size();
+                c_results.push_back(c);
+            }
+        }
+        catch (...)
+        {
+            c_results.clear();
+        }
+        return c_results.size() == size;
+    }
+};
+
+namespace
+{
+    // fields past struct_size were not known to the caller and keep their defaults
+    libufe::Options to_options(const ufe_options* options)
+    {
+        libufe::Options opts;
+        if (!options)
+        {
+            return opts;
+        }
+        auto has = [options](size_t end) { return options->struct_size >= end; };
+        if (has(offsetof(ufe_options, validate) + sizeof(options->validate)))
+        {
+            opts.validate = options->validate != 0;
+        }
+        if (has(offsetof(ufe_options, select_count) + sizeof(options->select_count)) && options->select)
+        {
+            for (size_t i = 0; i < options->select_count; ++i)
+            {
+                opts.select.emplace_back(options->select[i]);
+            }
+        }
+        if (has(offsetof(ufe_options, log_level) + sizeof(options->log_level)))
+        {
+            opts.log_level = options->log_level;
+        }
+        return opts;
+    }
+
+    std::vector<fs::path> to_paths(const char* const* files, size_t count)
+    {
+        std::vector<fs::path> paths;
+        paths.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            paths.emplace_back(reinterpret_cast<const char8_t*>(files[i]));
+        }
+        return paths;
+    }
+
+    template<class F>
+    ufe_batch* start(ufe_engine* engine, const char* const* files, size_t count, const ufe_options* options, F submit)
+    {
+        if (!engine || (count && !files))
+        {
+            return nullptr;
+        }
+        // nothing may throw past the C interface
+        try
+        {
+            auto batch = std::make_unique<ufe_batch>();
+            batch->size = count;
+            batch->future = submit(engine->engine, to_paths(files, count), to_options(options), batch->stop.get_token());
+            return batch.release();
+        }
+        catch (...)
+        {
+            return nullptr;
+        }
+    }
+}
+
+uint32_t ufe_api_version(void)
+{
+    return UFE_API_VERSION;
+}
+
+ufe_engine* ufe_engine_create(uint32_t threads)
+{
+    try
+    {
+        return new ufe_engine{ threads };
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void ufe_engine_destroy(ufe_engine* engine)
+{
+    delete engine;
+}
+
+ufe_batch* ufe_parse_many(ufe_engine* engine, const char* const* files, size_t count, const ufe_options* options)
+{
+    return start(engine, files, count, options, [](auto& e, auto paths, auto opts, auto stop) { return e.parse_many(std::move(paths), std::move(opts), stop); });
+}
+
+ufe_batch* ufe_export_many(ufe_engine* engine, const char* const* files, size_t count, const ufe_options* options)
+{
+    return start(engine, files, count, options, [](auto& e, auto paths, auto opts, auto stop) { return e.export_many(std::move(paths), std::move(opts), stop); });
+}
+
+ufe_batch* ufe_patch_many(ufe_engine* engine, const char* const* files, size_t count, const ufe_options* options)
+{
+    return start(engine, files, count, options, [](auto& e, auto paths, auto opts, auto stop) { return e.patch_many(std::move(paths), std::move(opts), stop); });
+}
+
+void ufe_batch_cancel(ufe_batch* batch)
+{
+    if (batch)
+    {
+        batch->stop.request_stop();
+    }
+}
+
+int ufe_batch_wait(ufe_batch* batch, uint32_t timeout_ms)
+{
+    if (!batch)
+    {
+        return 0;
+    }
+    if (batch->collected)
+    {
+        return 1;
+    }
+    if (timeout_ms == UFE_WAIT_INFINITE)
+    {
+        batch->future.wait();
+        return 1;
+    }
+    return batch->future.wait_for(std::chrono::milliseconds{ timeout_ms }) == std::future_status::ready ? 1 : 0;
+}
+
+size_t ufe_batch_size(const ufe_batch* batch)
+{
+    return batch ? batch->size : 0;
+}
+
+const ufe_file_result* ufe_batch_result(ufe_batch* batch, size_t index)
+{
+    if (!batch || index >= batch->size)
+    {
+        return nullptr;
+    }
+    return batch->collect() ? &batch->c_results[index] : nullptr;
+}
+
+void ufe_batch_destroy(ufe_batch* batch)
+{
+    if (batch)
+    {
+        batch->stop.request_stop();
+        if (!batch->collected)
+        {
+            batch->future.wait();
+        }
+        delete batch;
+    }
+}
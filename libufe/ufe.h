@@ -0,0 +1,109 @@
+/* libufe C API, stable across compilers and library versions of the same major
+ * API version. Strings are UTF-8 and owned by the library, results stay valid
+ * until their batch is destroyed. */
+#ifndef LIBUFE_UFE_H
+#define LIBUFE_UFE_H
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(LIBUFE_EXPORTS)
+#    define LIBUFE_API __declspec(dllexport)
+#  else
+#    define LIBUFE_API __declspec(dllimport)
+#  endif
+#else
+#  define LIBUFE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UFE_API_VERSION 1
+#define UFE_WAIT_INFINITE 0xFFFFFFFFu
+
+typedef struct ufe_engine ufe_engine;
+typedef struct ufe_batch ufe_batch;
+
+typedef enum ufe_status
+{
+    UFE_STATUS_OK = 0,
+    UFE_STATUS_UNSUPPORTED = 1,  /* not a compressed or uncompressed NRBF file */
+    UFE_STATUS_INVALID = 2,      /* stream header or records don't parse */
+    UFE_STATUS_PARTIAL_READ = 3, /* parsing stopped before the end of the stream */
+    UFE_STATUS_FAILED = 4,       /* file can't be read, patched or re-serialized */
+    UFE_STATUS_CANCELLED = 5
+} ufe_status;
+
+/* log levels, same values as spdlog */
+typedef enum ufe_log_level
+{
+    UFE_LOG_TRACE = 0,
+    UFE_LOG_DEBUG = 1,
+    UFE_LOG_INFO = 2,
+    UFE_LOG_WARN = 3,
+    UFE_LOG_ERROR = 4,
+    UFE_LOG_CRITICAL = 5,
+    UFE_LOG_OFF = 6
+} ufe_log_level;
+
+/* struct_size must be sizeof(ufe_options), fields added later are read only
+ * when struct_size covers them */
+typedef struct ufe_options
+{
+    uint32_t struct_size;
+    int validate;               /* re-serialize fully parsed files and compare */
+    const char* const* select;  /* export projection patterns, see --select */
+    size_t select_count;
+    int log_level;              /* messages at this level and above are kept, default UFE_LOG_WARN */
+} ufe_options;
+
+typedef struct ufe_message
+{
+    int level;
+    const char* text;
+} ufe_message;
+
+typedef struct ufe_file_result
+{
+    const char* file;
+    ufe_status status;
+    int compressed;
+    uint64_t records;
+    uint64_t members;
+    int exported;               /* json written, or returned in json by ufe_parse_many */
+    int patched;
+    int round_trip;             /* validated and re-serialized without differences */
+    const char* json;           /* ufe_parse_many only, NULL otherwise */
+    size_t json_size;
+    const ufe_message* messages;
+    size_t message_count;
+} ufe_file_result;
+
+LIBUFE_API uint32_t ufe_api_version(void);
+
+/* threads 0 uses one worker per hardware thread */
+LIBUFE_API ufe_engine* ufe_engine_create(uint32_t threads);
+/* cancels files not started yet and waits for running ones */
+LIBUFE_API void ufe_engine_destroy(ufe_engine* engine);
+
+/* batches run asynchronously, options may be NULL, NULL if the batch can't be started */
+LIBUFE_API ufe_batch* ufe_parse_many(ufe_engine* engine, const char* const* files, size_t count, const ufe_options* options);
+LIBUFE_API ufe_batch* ufe_export_many(ufe_engine* engine, const char* const* files, size_t count, const ufe_options* options);
+LIBUFE_API ufe_batch* ufe_patch_many(ufe_engine* engine, const char* const* files, size_t count, const ufe_options* options);
+
+/* files not started yet finish with UFE_STATUS_CANCELLED */
+LIBUFE_API void ufe_batch_cancel(ufe_batch* batch);
+/* 1 once every file is done, 0 on timeout */
+LIBUFE_API int ufe_batch_wait(ufe_batch* batch, uint32_t timeout_ms);
+LIBUFE_API size_t ufe_batch_size(const ufe_batch* batch);
+/* waits for the batch, NULL if index is out of range or the batch failed */
+LIBUFE_API const ufe_file_result* ufe_batch_result(ufe_batch* batch, size_t index);
+/* cancels and waits like ufe_batch_cancel followed by ufe_batch_wait */
+LIBUFE_API void ufe_batch_destroy(ufe_batch* batch);
+
+#ifdef __cplusplus
+}
+#endif
+#endif